@@ -0,0 +1,122 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Pooled, aligned CPU allocator handed to ORT through OrtEpFactory::CreateAllocator
+//
+// Blocks come from size classes (four per power of two, 64 B to 64 MiB) and go back to
+// per-class free lists when ORT frees them, so the buffers ORT allocates for partition
+// outputs and intermediates are recycled across runs instead of round-tripping through
+// malloc. Free lists are sharded and each thread sticks to one shard, which keeps concurrent
+// sessions off each other's locks. Every block is 64-byte aligned for the SIMD kernels.
+
+#pragma once
+
+#include <onnxruntime_c_api.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// ============================================================================
+// PoolAllocatorOptions - Read from the allocator options ORT passes to CreateAllocator
+// ============================================================================
+struct PoolAllocatorOptions {
+    // "huge_pages": carve size-class blocks from 2 MiB-page arenas (Linux only)
+    bool huge_pages = false;
+
+    // "max_cached_bytes": free blocks beyond this are returned to the system
+    size_t max_cached_bytes = size_t(1) << 30;
+
+    // "numa_node": place new blocks and arenas on this node (Linux only). -1 = no preference.
+    int numa_node = -1;
+};
+
+// Parse allocator options. `options_kvps` may be null. Unknown keys are ignored.
+OrtStatus* ParseAllocatorOptions(const OrtApi* api, const OrtKeyValuePairs* options_kvps,
+                                 PoolAllocatorOptions* options);
+
+// ============================================================================
+// PoolAllocator - Size-class pools behind an OrtAllocator
+// Uses composition to wrap OrtAllocator
+// ============================================================================
+class PoolAllocator {
+public:
+    static constexpr size_t kAlignment = 64;
+
+    // `memory_info` must outlive the allocator
+    PoolAllocator(const OrtApi* api, const OrtMemoryInfo* memory_info,
+                  const PoolAllocatorOptions& options);
+    ~PoolAllocator();
+
+    PoolAllocator(const PoolAllocator&) = delete;
+    PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+    OrtAllocator* GetOrtAllocator() { return &allocator_; }
+
+    static PoolAllocator* FromOrt(OrtAllocator* ort_allocator);
+    static const PoolAllocator* FromOrt(const OrtAllocator* ort_allocator);
+
+    // Allocate from the pools. Returns nullptr on failure.
+    void* Allocate(size_t size);
+
+    // Allocate outside the pools; the block goes straight back to the system when freed
+    void* Reserve(size_t size);
+
+    void Free(void* p);
+
+    // Hold the block at `p` out of the pools until a matching Unretain, even if ORT frees it
+    // first: compute queued on a stream still reads and writes buffers ORT has released.
+    // Returns false, retaining nothing, if `p` is not the start of a PoolAllocator block (a
+    // tensor at an offset into one, say). `p` must be inside PoolAllocator memory.
+    static bool Retain(void* p);
+    static void Unretain(void* p);
+
+private:
+    struct BlockHeader;
+
+    // Free lists for a subset of threads
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::vector<BlockHeader*> free_lists;  // Head of the free list per size class
+    };
+
+    // Region that size-class blocks are carved from when huge pages are enabled
+    struct Arena {
+        char* base;
+        size_t size;
+    };
+
+    static void* ORT_API_CALL AllocImpl(OrtAllocator* this_, size_t size) noexcept;
+    static void ORT_API_CALL FreeImpl(OrtAllocator* this_, void* p) noexcept;
+    static const OrtMemoryInfo* ORT_API_CALL InfoImpl(const OrtAllocator* this_) noexcept;
+    static void* ORT_API_CALL ReserveImpl(OrtAllocator* this_, size_t size) noexcept;
+    static OrtStatus* ORT_API_CALL GetStatsImpl(const OrtAllocator* this_,
+                                                OrtKeyValuePairs** out) noexcept;
+
+    void Recycle(BlockHeader* block);
+    BlockHeader* NewBlock(size_t size_class, size_t bytes);
+    BlockHeader* CarveFromArena(size_t bytes);
+    void ReleaseBlock(BlockHeader* block);
+    void* TrackAllocation(BlockHeader* block, size_t requested);
+
+    OrtAllocator allocator_;  // The actual OrtAllocator struct
+    const OrtApi* api_;
+    const OrtMemoryInfo* memory_info_;
+    PoolAllocatorOptions options_;
+
+    std::vector<Shard> shards_;
+
+    std::mutex arena_mutex_;
+    std::vector<Arena> arenas_;
+    size_t arena_used_ = 0;  // Bytes carved from the newest arena
+
+    // Statistics reported through GetStats
+    std::atomic<size_t> in_use_{0};
+    std::atomic<size_t> max_in_use_{0};
+    std::atomic<size_t> cached_{0};
+    std::atomic<size_t> total_allocated_{0};
+    std::atomic<size_t> max_alloc_size_{0};
+    std::atomic<uint64_t> num_allocs_{0};
+    std::atomic<uint64_t> num_reserves_{0};
+    std::atomic<uint64_t> num_system_allocs_{0};
+};
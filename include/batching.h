@@ -0,0 +1,73 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Micro-batching of concurrent calls to one partition
+//
+// Latency-bound traffic runs many tiny tensors, for which a call's fixed cost (plan lookup,
+// dispatch, tile setup) outweighs its arithmetic. With a batch window set, a small call joins
+// the open batch of concurrent calls with the same input shapes, or opens one and waits up to
+// the window for others. The call that opened it then gathers every call's inputs into
+// tensors with a new leading batch dim, runs the program over them once and scatters the
+// outputs back, while the others sleep until it is done. A call waits for the window at most
+// once, so the latency it adds is bounded by the window plus the batch's own run time.
+
+#pragma once
+
+#include "execution_plan.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Calls coalesced into one batch at most
+constexpr size_t kMaxBatchCalls = 16;
+
+// Calls with more output elements than this run alone: they already amortize their overhead
+constexpr size_t kMaxBatchedElements = 4096;
+
+// The partition a batcher runs
+struct BatchTarget {
+    const ExprProgram* program = nullptr;
+    size_t num_call_inputs = 0;  // Inputs [0, num_call_inputs) differ per call; the rest are shared
+    const KernelTable* kernels = nullptr;
+    PlanOptions options;
+    PlanCache* plans = nullptr;  // Batched plans are cached next to the per-call ones
+};
+
+// ============================================================================
+// CallBatcher - Coalesces concurrent calls with the same input shapes
+// ============================================================================
+class CallBatcher {
+public:
+    // Run `plan` over one batched set of buffers
+    using RunFn = void (*)(void* context, const ExecutionPlan& plan, const void** inputs, void* const* outputs);
+
+    // Run the call as part of a batch: join an open one with the same shapes, or open one and
+    // wait up to `window` for others before running all of them through `run`. Returns false,
+    // having run nothing, when the plan does not qualify or a batch of other shapes is open;
+    // the caller then runs the call alone.
+    bool Run(const BatchTarget& target, std::chrono::microseconds window, const ExecutionPlan& plan,
+             const void** inputs, void* const* outputs, RunFn run, void* context);
+
+private:
+    struct Call {
+        const void* const* inputs;
+        void* const* outputs;
+    };
+
+    struct Batch {
+        const ExecutionPlan* plan;
+        std::vector<Call> calls;
+        bool done = false;
+        std::condition_variable done_cv;
+    };
+
+    // Gather the calls' inputs, run them as one plan and scatter the outputs. Calls `run` per
+    // call instead if the batched shapes cannot be planned.
+    static void RunBatch(const BatchTarget& target, const Batch& batch, RunFn run, void* context);
+
+    std::mutex mutex_;
+    std::condition_variable full_cv_;
+    std::shared_ptr<Batch> open_;  // Batch still taking calls, if any
+};
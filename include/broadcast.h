@@ -0,0 +1,56 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// NumPy-style broadcasting plans for elementwise partitions
+//
+// A plan describes the output iteration space as outer "rows" and one contiguous inner dim.
+// Dims are collapsed wherever every input stays linear across them, so after planning each
+// input is, along the inner dim, either contiguous (stride 1) or a single repeated value
+// (stride 0). Kernels therefore always run over contiguous spans; broadcasting only costs a
+// pointer update per row, never index math per element.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Dims of one tensor
+struct ShapeRef {
+    const int64_t* dims;
+    size_t rank;
+};
+
+// ============================================================================
+// BroadcastPlan - Iteration space shared by all inputs of a partition
+// ============================================================================
+struct BroadcastPlan {
+    std::vector<int64_t> output_dims;  // Broadcast shape of all inputs
+    size_t total = 0;                  // Number of output elements
+
+    size_t inner = 1;                  // Length of the contiguous inner dim
+    std::vector<size_t> outer_dims;    // Collapsed outer dims, outermost first
+
+    // Per input: element strides over outer_dims, and stride along the inner dim (0 or 1)
+    std::vector<std::vector<size_t>> outer_strides;
+    std::vector<uint8_t> inner_stride;
+
+    // Short rows are widened by folding `repeat` rows into the inner dim. Inputs marked here
+    // are row vectors that must be tiled `repeat` times (see ReplicateRows) before executing.
+    size_t repeat = 1;
+    std::vector<uint8_t> replicate;
+};
+
+// Rows shorter than kMinInnerElements are widened, when the broadcast pattern allows it,
+// up to at most kMaxWidenedElements
+constexpr size_t kMinInnerElements = 64;
+constexpr size_t kMaxWidenedElements = 256;
+
+// Compute the broadcast of `inputs` and the collapsed iteration plan over it.
+// Returns false if the shapes are not broadcast-compatible.
+bool ComputeBroadcastPlan(const std::vector<ShapeRef>& inputs, BroadcastPlan* plan);
+
+// Compute the broadcast of two shapes. Returns false if they are not compatible.
+bool BroadcastShapes(const std::vector<int64_t>& a, const std::vector<int64_t>& b,
+                     std::vector<int64_t>* out);
+
+// Fill `out` with `repeat` copies of the `row_bytes` bytes at `row`
+void ReplicateRows(const void* row, size_t row_bytes, size_t repeat, void* out);
@@ -0,0 +1,59 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Lowering of fused ORT subgraphs into expression programs
+
+#pragma once
+
+#include "constant_folding.h"
+#include "expr_program.h"
+#include "op_registry.h"
+#include "sample_ep.h"
+
+#include <memory>
+#include <vector>
+
+// Map an ONNX tensor element type to the type the executor computes in. Returns false if
+// the EP has no kernels for it.
+bool LookupDataType(ONNXTensorElementDataType elem_type, DataType* type);
+
+// ============================================================================
+// NodeLowering - The instructions one node becomes
+// ============================================================================
+struct NodeLowering {
+    // Sources index the node's inputs; kPrevious is the result of the step before
+    static constexpr uint8_t kPrevious = 0xFF;
+
+    struct Step {
+        OpCode op;
+        uint8_t src[3];
+    };
+
+    const OpDescriptor* descriptor = nullptr;
+    std::vector<Step> steps;
+    DataType type = DataType::Float;  // Type of every step's result: the node output's
+
+    // Axes and attributes of the node's row op step, if it has one (always its first)
+    bool has_row_op = false;
+    RowSpec row;
+};
+
+// Lower one node. `supported` is false if its op, schema version, attributes, arity, shapes or
+// element types have no kernels; GetCapability claims exactly the nodes this accepts.
+OrtStatus* LowerNode(const OrtApi* api, const OrtNode* node, NodeLowering* lowering, bool* supported);
+
+// Lower the fused subgraph `graph` into `program`. Program inputs and outputs follow the
+// order of the fused node's inputs and outputs, which is the kernel context order. The
+// partitioner puts at most one node with a row op in each subgraph.
+OrtStatus* CompileFusedGraph(const ApiPtrs& apis, const OrtGraph* graph,
+                             const OrtNode* fused_node, ExprProgram* program);
+
+// Read what FoldConstants needs about the fused node's inputs, which are the program's: the
+// value of each constant initializer small enough to fold (null for the others) and the dims
+// the model declares for each
+OrtStatus* ReadConstantInputs(const OrtApi* api, const OrtGraph* graph, const OrtNode* fused_node,
+                              const ExprProgram& program, std::vector<std::unique_ptr<ConstantTensor>>* values,
+                              std::vector<std::vector<int64_t>>* dims);
+
+// Fold activations into the arithmetic instruction computing their input when nothing else
+// reads that intermediate, so e.g. Gelu(Add(x, b)) runs as one kernel. Registers are
+// renumbered to stay in instruction order.
+void FuseEpilogues(ExprProgram* program);
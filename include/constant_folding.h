@@ -0,0 +1,53 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Compile-time folding of a partition's constant inputs
+//
+// Partition inputs that are constant initializers are known once the session is created, so
+// instructions computed only from them are evaluated then, with the EP's own kernels so the
+// values are the ones Compute would have produced. Their results become extra program inputs
+// whose data the node carries. Constants that repeat along an axis are stored with that dim
+// collapsed to 1: a uniform tensor becomes a scalar and a tensor of equal rows a row vector,
+// which the broadcast kernels read once per row instead of streaming. The original inputs
+// stay in the program, unread, so they still give the output its shape.
+
+#pragma once
+
+#include "expr_program.h"
+#include "kernels.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Constants larger than this are left to be computed per call
+constexpr size_t kMaxFoldedElements = size_t(64) << 10;
+
+// ============================================================================
+// ConstantTensor - A tensor value known at compile time, in its register's element type
+// ============================================================================
+struct ConstantTensor {
+    std::vector<int64_t> dims;
+
+    // Resize the storage to `bytes`, 64-byte aligned for the SIMD kernels
+    void Allocate(size_t bytes);
+
+    void* data() { return storage_.data(); }
+    const void* data() const { return storage_.data(); }
+    size_t bytes() const { return bytes_; }
+
+private:
+    struct alignas(64) Line {
+        char bytes[64];
+    };
+    std::vector<Line> storage_;
+    size_t bytes_ = 0;
+};
+
+// Fold the instructions of `program` whose operands are all known. inputs[k] holds the value
+// of program input k, or null when it is only known per call, and input_dims[k] the dims the
+// model declares for it, -1 where unknown. A dim is only collapsed where those show the other
+// operands already give the result its length. The values of the inputs appended to the
+// program are added to *folded, in input order.
+void FoldConstants(ExprProgram* program, const std::vector<std::unique_ptr<ConstantTensor>>& inputs,
+                   const std::vector<std::vector<int64_t>>& input_dims, const KernelTable& kernels,
+                   std::vector<ConstantTensor>* folded);
@@ -0,0 +1,58 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Always-on aggregate performance counters, read through SampleEpGetCounters
+//
+// Every thread that counts gets its own cache-line aligned block, so the hot paths update
+// counters with a plain relaxed load and store that never contends with other threads. A
+// read sums every live block plus the totals of threads that have exited. Gauges (bytes in
+// use, queue depth) are counted as increments and decrements that may land on different
+// threads; only their sum is meaningful, as a two's-complement value read while updates are in
+// flight may be momentarily off.
+
+#pragma once
+
+#include "expr_program.h"
+
+#include <cstddef>
+#include <cstdint>
+
+enum class Counter : uint16_t {
+    ComputeCalls,      // Compute calls, batched or not
+    OutputElements,    // Output elements computed, per output tensor shape
+    GenericCalls,      // Calls run by the generic elementwise executor
+    HotPathCalls,      // Calls run through a plan's hot path (see HotPath)
+    RowOpCalls,        // Calls with a row op
+    PlanCacheHits,
+    PlanCacheMisses,   // Calls that built their plan
+    PlanCacheOverflows,  // Misses whose plan did not fit in the cache
+    Batches,           // Micro-batches of more than one call
+    BatchedCalls,      // Calls run as part of one
+    PoolBytesInUse,    // Gauge: PoolAllocator bytes handed out
+    PoolBytesCached,   // Gauge: PoolAllocator bytes held in free lists
+    StreamQueueDepth,  // Gauge: tasks queued on CpuStreams and not yet run
+    ParallelLoops,     // Loops run on the thread pool's workers
+    BusyPoolLoops,     // Loops run inline because another caller owned the pool
+    StolenChunks,      // Chunks a pool participant took from another's range
+    OpElements,        // First of kNumOpCodes: elements each op ran over (see OpElementsCounter)
+};
+
+constexpr size_t kNumCounters = static_cast<size_t>(Counter::OpElements) + kNumOpCodes;
+
+// Counter of the elements instructions with `op` ran over: a row op's operand elements, or
+// its multiply-adds for a MatMul, and for the others the elements they computed
+constexpr size_t OpElementsCounter(OpCode op) {
+    return static_cast<size_t>(Counter::OpElements) + static_cast<size_t>(op);
+}
+
+// Add `delta` to counter `index` on the calling thread's block
+void CountAdd(size_t index, uint64_t delta);
+
+inline void CountAdd(Counter counter, uint64_t delta) { CountAdd(static_cast<size_t>(counter), delta); }
+
+// Decrement a gauge, for a matching CountAdd on any thread
+inline void CountSub(Counter counter, uint64_t delta) { CountAdd(static_cast<size_t>(counter), 0 - delta); }
+
+// Name of counter `index`, e.g. "plan_cache_hits" or "op_elements.add"
+const char* CounterName(size_t index);
+
+// Sum every counter over all threads into values[0, kNumCounters)
+void ReadCounters(uint64_t* values);
@@ -0,0 +1,68 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Copies between host memory and the EP's memory at partition boundaries
+//
+// The EP's memory is host memory with a 64-byte alignment guarantee, so ORT sees it as a
+// separate device and inserts a copy wherever a tensor crosses between it and ORT's CPU
+// memory. Both sides are plain host memory, so a copy whose source and destination already
+// share storage is skipped. Large copies are split across threads and written with
+// non-temporal stores, which do not pull the destination through the cache or evict the
+// data the next kernel is about to read.
+
+#pragma once
+
+#include <onnxruntime_c_api.h>
+
+#include "stream.h"
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+// Copy `bytes` from `src` to `dst`, which must not overlap. Copies of at least
+// kStreamingCopyBytes bypass the cache; `pool`, if given, splits them across its threads.
+void CopyBuffer(void* dst, const void* src, size_t bytes, ThreadPool* pool);
+
+constexpr size_t kStreamingCopyBytes = size_t(1) << 20;
+
+// ============================================================================
+// SampleDataTransfer - CopyTensors between ORT's CPU memory and the EP's memory
+// Uses composition to wrap OrtDataTransferImpl
+// ============================================================================
+class SampleDataTransfer {
+public:
+    // `memory_info` describes the EP's memory and must outlive the transfer. `streams` holds
+    // every stream partitions may be queued on.
+    SampleDataTransfer(const OrtApi* api, const OrtEpApi* ep_api, const OrtMemoryInfo* memory_info,
+                       std::shared_ptr<StreamSet> streams);
+
+    OrtDataTransferImpl* GetOrtDataTransfer() { return &data_transfer_; }
+
+    static SampleDataTransfer* FromOrt(OrtDataTransferImpl* ort_data_transfer);
+    static const SampleDataTransfer* FromOrt(const OrtDataTransferImpl* ort_data_transfer);
+
+private:
+    static void ORT_API_CALL ReleaseImpl(OrtDataTransferImpl* this_ptr) noexcept;
+
+    static bool ORT_API_CALL CanCopyImpl(const OrtDataTransferImpl* this_ptr,
+                                         const OrtMemoryDevice* src_memory_device,
+                                         const OrtMemoryDevice* dst_memory_device) noexcept;
+
+    static OrtStatus* ORT_API_CALL CopyTensorsImpl(OrtDataTransferImpl* this_ptr,
+                                                   const OrtValue** src_tensors,
+                                                   OrtValue** dst_tensors,
+                                                   OrtSyncStream** streams,
+                                                   size_t num_tensors) noexcept;
+
+    // Workers for large copies, started on the first one
+    ThreadPool* GetCopyPool();
+
+    OrtDataTransferImpl data_transfer_;  // The actual OrtDataTransferImpl struct
+    const OrtApi* api_;
+    const OrtEpApi* ep_api_;
+    const OrtMemoryDevice* memory_device_;
+    std::shared_ptr<StreamSet> streams_;
+
+    std::once_flag pool_once_;
+    std::unique_ptr<ThreadPool> copy_pool_;
+};
@@ -0,0 +1,45 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// EPContext nodes: compiled partitions saved into the model and loaded back without recompiling
+//
+// When "ep.context_enable" is set, CompileImpl emits one com.microsoft EPContext node per
+// fused partition. Its "ep_cache_context" attribute holds the serialized expression program
+// (embed_mode 1), so a session created from the saved model claims those nodes directly and
+// compiles nothing. Kernels are selected for the loading machine, not the compiling one.
+
+#pragma once
+
+#include "expr_program.h"
+#include "kernels.h"
+#include "sample_ep.h"
+
+#include <string>
+
+// Version of the serialized program. Bump on any incompatible change to the format.
+constexpr int kEpContextFormatVersion = 4;
+
+// Serialize `program`, recording the kernel table it was compiled against
+std::string SerializeProgram(const ExprProgram& program, const KernelTable& kernels);
+
+// Parse and validate a serialized program. Returns false if the blob is malformed or was
+// written by an incompatible format version.
+bool DeserializeProgram(const std::string& blob, ExprProgram* program);
+
+// Compatibility string stored in compiled models, e.g. "SampleEP;format=1;isa=avx2"
+std::string GetCompatibilityInfo(const KernelTable& kernels);
+
+// Check a compatibility string written by GetCompatibilityInfo
+OrtCompiledModelCompatibility CheckCompatibilityInfo(const char* compatibility_info);
+
+// Whether `node` is an EPContext node produced by the EP named `ep_name`
+OrtStatus* IsOwnEpContextNode(const OrtApi* api, const OrtNode* node, const std::string& ep_name,
+                              bool* result);
+
+// Create the EPContext node replacing `fused_node`, with the same inputs and outputs
+OrtStatus* CreateEpContextNode(const ApiPtrs& apis, const OrtNode* fused_node,
+                               const std::string& ep_name, const std::string& blob,
+                               OrtNode** ep_context_node);
+
+// If `graph` is a single EPContext node, load the program it carries into the compute info
+// for `fused_node`. loaded is false if the graph has to be compiled instead.
+OrtStatus* LoadEpContextProgram(const ApiPtrs& apis, const OrtGraph* graph,
+                                const OrtNode* fused_node, ExprProgram* program, bool* loaded);
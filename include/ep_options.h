@@ -0,0 +1,104 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Session options understood by the Sample EP
+
+#pragma once
+
+#include "allocator.h"
+#include "kernels.h"
+#include "partitioner.h"
+#include "thread_pool.h"
+
+#include <onnxruntime_c_api.h>
+
+#include <cstddef>
+#include <string>
+
+// ============================================================================
+// SampleEpOptions - Per-session EP configuration
+//
+// Read from session config entries "ep.<ep name lowercased>.<key>", which is where ORT puts
+// the provider options given to SessionOptionsAppendExecutionProvider_V2. The shorter
+// "ep.sampleep.<key>" form is accepted as well. Options marked dynamic can also be changed on
+// a live session through SetEpDynamicOptions.
+// ============================================================================
+struct SampleEpOptions {
+    // Threads used for intra-op parallelism, including the calling thread. 0 = one per core.
+    // Dynamic.
+    size_t num_threads = 0;
+
+    // NUMA node to run on: the pool's workers are pinned to its CPUs (and num_threads = 0 means
+    // one per CPU of the node), and the EP's allocator places its memory there. -1 = any.
+    int numa_node = -1;
+
+    // Scheduling priority of the pool's worker threads: "normal" or "low". Dynamic, also as
+    // ORT's "ep.dynamic.workload_type" ("Default" or "Efficient").
+    ThreadPriority thread_priority = ThreadPriority::Normal;
+
+    // Queue each partition on ORT's sync stream and return from Compute before it runs, so
+    // ORT can launch other nodes meanwhile. Off = compute inline on ORT's thread.
+    bool stream_execution = true;
+
+    // Partitions with fewer output elements than this run inline on the calling thread
+    size_t parallel_threshold = size_t(1) << 16;
+
+    // Calls with the same input shapes after which a partition specializes its plan for them
+    // (fixed-length kernels for full tiles, precomputed row offsets). 0 = never.
+    size_t specialize_after = 16;
+
+    // Coalesce concurrent calls to a partition with the same small input shapes: a call waits
+    // up to this many microseconds for others to run with it as one batch. 0 = off.
+    size_t batch_window_us = 0;
+
+    // Split long reductions into fixed-size blocks, so their results do not change with the
+    // thread count. Off = one block per thread, which rounds differently as threads change.
+    bool deterministic_reductions = true;
+
+    // Evaluate instructions computed only from constant initializers once at compile time,
+    // and store constants that repeat along an axis with that dim collapsed
+    bool fold_constants = true;
+
+    // Layout reported to ORT's layout transformer: "NCHW" or "NHWC". The elementwise kernels
+    // are layout-agnostic, so this only decides which way ORT converts layout-sensitive ops.
+    OrtEpDataLayout preferred_layout = OrtEpDataLayout_NCHW;
+
+    // Kernel instruction set ("scalar", "sse4", "avx2", "avx512", "neon"). Unset = the best
+    // one this CPU supports; naming one it does not support fails session creation.
+    bool force_isa = false;
+    Isa isa = Isa::Scalar;
+
+    // Most nodes fused into one partition. 0 = no limit.
+    size_t max_partition_nodes = 0;
+
+    // Allocator for tensors placed in the EP's memory: "pool" (default), "huge_pages" (pool
+    // blocks carved from 2 MiB pages) or "system" (no caching; every free returns the memory)
+    PoolAllocatorOptions allocator;
+
+    // Record per-partition timings and write them as Chrome trace events to profile_file.
+    // Dynamic.
+    bool enable_profiling = false;
+    std::string profile_file = "sample_ep_profile.json";
+
+    // Only claim partitions the cost model expects to run faster here than on ORT's CPU EP.
+    // Set from partition_policy: "cost" (default) or "all".
+    bool partition_by_cost = true;
+    CostModel cost_model;
+
+    // Print every partitioning decision with its estimate
+    bool partition_log = false;
+
+    // Directory holding the shared on-disk cache of compiled partitions. Empty = disabled.
+    std::string program_cache_dir;
+
+    // ORT's "ep.context_enable" session option: emit EPContext nodes when compiling a model
+    bool ep_context_enable = false;
+};
+
+// Parse the EP options from the session options. Unknown keys are ignored.
+OrtStatus* ParseEpOptions(const OrtApi* api, const OrtSessionOptions* session_options,
+                          const std::string& ep_name, SampleEpOptions* options);
+
+// Apply SetEpDynamicOptions keys (unprefixed, e.g. "num_threads") to `options`. Fails on an
+// invalid value or an EP option that is fixed at session creation, in which case `options` is
+// unchanged. Other keys are ignored; ORT passes the same keys to every EP of the session.
+OrtStatus* ParseDynamicEpOptions(const OrtApi* api, const char* const* keys, const char* const* values,
+                                 size_t num_options, SampleEpOptions* options);
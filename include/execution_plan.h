@@ -0,0 +1,162 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Shape-specialized execution plans and their per-partition cache
+//
+// Everything ComputeImpl derives from input shapes (output dims, broadcast strides, which
+// kernel each instruction calls, how the work is chunked) is resolved once per
+// distinct set of input shapes and cached. A repeat call with known shapes only compares the
+// shapes against the cached key, so it makes no heap allocations.
+//
+// Models with symbolic dims see many shapes, most of them rarely. A plan that keeps being hit
+// is specialized further: full tiles switch to kernels compiled for exactly kTileElements
+// elements and the input offset of every row is precomputed. Shapes that stay cold keep the
+// generic path, so the extra work and memory go only to the shapes that repay them.
+
+#pragma once
+
+#include "broadcast.h"
+#include "expr_program.h"
+#include "kernels.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+struct RowPlan;
+
+// ============================================================================
+// HotPath - What a plan adds once its shapes are hot
+// ============================================================================
+struct HotPath {
+    // Per instruction: the kernel for a full tile, the generic one where there is no
+    // fixed-length variant. Partial tiles, only ever the last of a row, keep the generic one.
+    std::vector<Kernel> tile_kernels;
+
+    // Element offset of every input at the start of each row, [row * num_inputs + k]. Empty
+    // when the plan has more rows than are worth tabulating.
+    std::vector<size_t> row_offsets;
+};
+
+// Rows times inputs beyond which a hot path steps row offsets instead of tabulating them
+constexpr size_t kMaxRowOffsets = size_t(16) << 10;
+
+// ============================================================================
+// ExecutionPlan - An ExprProgram resolved for one set of input shapes
+// ============================================================================
+struct ExecutionPlan {
+    ExecutionPlan();
+    ~ExecutionPlan();
+
+    // Input shapes the plan was built for, flattened as (rank, dims...) per input
+    std::vector<int64_t> key;
+    uint64_t key_hash = 0;  // HashShapes of the same shapes
+
+    BroadcastPlan broadcast;
+
+    // Per register: holds a single value per row (selects the vector-scalar kernels)
+    std::vector<uint8_t> scalar;
+
+    // Per instruction: the kernel for its operand types and kinds
+    std::vector<Kernel> kernels;
+
+    // Per register: the scratch tile it is computed into, or kNoTile for inputs and outputs.
+    // Tiles are shared by registers whose lifetimes do not overlap, and an instruction may
+    // write over an operand it is the last reader of (see AssignTiles).
+    static constexpr uint16_t kNoTile = 0xFFFF;
+    std::vector<uint16_t> tile;
+    size_t num_tiles = 0;
+
+    // Scratch needed to tile row-vector inputs across widened rows
+    size_t replicated_bytes = 0;
+
+    // Work split. num_chunks == 1 runs inline on the calling thread.
+    size_t chunk_elements = 0;
+    size_t num_chunks = 1;
+
+    // Set for programs with a row instruction, which run through RunRowPlan. Only key,
+    // broadcast.output_dims, broadcast.total and num_chunks are filled in next to it.
+    std::unique_ptr<RowPlan> row;
+
+    // Calls the plan has served, counted until it is hot, and the hot path once published
+    // (see RecordPlanCall). Both change on a plan that is otherwise immutable once cached.
+    mutable std::atomic<uint32_t> calls{0};
+    mutable std::atomic<const HotPath*> hot{nullptr};
+
+    bool Matches(const ShapeRef* shapes, size_t count) const;
+};
+
+// Settings that influence how a plan is chunked. The thread count is not one: it can change
+// while plans stay cached, and chunks run inline when the pool has no workers.
+struct PlanOptions {
+    size_t parallel_threshold = 0;
+};
+
+enum class PlanStatus {
+    Ok,
+    IncompatibleShapes,  // Inputs cannot be broadcast together
+    UnsupportedShapes,   // Valid, but some output does not span the full iteration space
+};
+
+// Resolve `program` for the given input shapes (one per program input)
+PlanStatus BuildExecutionPlan(const ExprProgram& program, const KernelTable& kernels,
+                              const ShapeRef* shapes, const PlanOptions& options,
+                              ExecutionPlan* plan);
+
+// Tile the row-vector inputs `plan` marks for replication into `replicated`, which must hold
+// plan.replicated_bytes, and point their entries in `inputs` at the copies
+void ReplicateInputs(const ExprProgram& program, const ExecutionPlan& plan, const void** inputs,
+                     char* replicated);
+
+// Count a call served by the cached `plan`, and give it a hot path on the call that makes
+// `hot_calls` of them. Counting stops once the hot path is published, so steady-state calls
+// only load it. 0 never specializes; plans with a row instruction are never specialized.
+void RecordPlanCall(const ExprProgram& program, const KernelTable& kernels, size_t hot_calls,
+                    const ExecutionPlan& plan);
+
+// Hash of a set of input shapes, as stored in ExecutionPlan::key_hash
+uint64_t HashShapes(const ShapeRef* shapes, size_t count);
+
+// ============================================================================
+// PlanCache - Read-copy-update hash map from input shapes to execution plans
+//
+// Lookups take no lock and write no shared memory: they load the current table and probe
+// it. Plans are immutable once published. Writers, serialized by a mutex that only a call
+// seeing new shapes ever takes, fill an empty slot with a release store, or copy everything
+// into a table twice the size and swap the table pointer once the current one is half full.
+// Replaced tables and every plan stay alive until the cache is destroyed, so readers never
+// need to announce themselves. Past kCapacity plans, further shapes are planned per call.
+// ============================================================================
+class PlanCache {
+public:
+    static constexpr size_t kCapacity = 64;
+
+    PlanCache() = default;
+    ~PlanCache();
+
+    PlanCache(const PlanCache&) = delete;
+    PlanCache& operator=(const PlanCache&) = delete;
+
+    // Find the plan for these input shapes, or nullptr
+    const ExecutionPlan* Find(const ShapeRef* shapes, size_t count) const;
+
+    // Publish a plan. Returns the cached plan for its shapes (which may have been inserted by
+    // another thread) and takes ownership, or returns nullptr and leaves `plan` with the
+    // caller if the cache is full.
+    const ExecutionPlan* Insert(std::unique_ptr<ExecutionPlan>& plan);
+
+private:
+    // Open addressing on key_hash, at most half full. Slots only ever go from null to a plan.
+    struct Table {
+        explicit Table(size_t num_slots)
+            : mask(num_slots - 1), slots(new std::atomic<const ExecutionPlan*>[num_slots]()) {}
+
+        const size_t mask;
+        size_t size = 0;  // Written under insert_mutex_ only
+        std::unique_ptr<std::atomic<const ExecutionPlan*>[]> slots;
+    };
+
+    std::atomic<const Table*> table_{nullptr};
+
+    std::mutex insert_mutex_;  // Serializes writers; readers never take it
+    std::vector<std::unique_ptr<Table>> tables_;  // Every table published, newest last
+};
@@ -0,0 +1,280 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Compiled expression programs for fused elementwise partitions
+//
+// A fused partition is lowered into a small register-based bytecode. Registers
+// [0, num_inputs) hold the partition inputs; every instruction writes one new register.
+// The executor runs the whole program one tile at a time, so intermediates live in a
+// cache-resident scratch tile instead of full-size buffers.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct ExecutionPlan;
+
+// Element types the executor computes in. Float16 and BFloat16 are stored as their 16-bit
+// encodings and computed in float. Bool is one byte per element, 0 or 1.
+enum class DataType : uint8_t {
+    Float,
+    Double,
+    Float16,
+    BFloat16,
+    Int8,
+    Int32,
+    Int64,
+    Bool,
+};
+
+constexpr size_t kNumDataTypes = static_cast<size_t>(DataType::Bool) + 1;
+
+// Size in bytes of one element
+constexpr size_t DataTypeSize(DataType type) {
+    switch (type) {
+        case DataType::Double:
+        case DataType::Int64:
+            return 8;
+        case DataType::Float:
+        case DataType::Int32:
+            return 4;
+        case DataType::Float16:
+        case DataType::BFloat16:
+            return 2;
+        case DataType::Int8:
+        case DataType::Bool:
+            return 1;
+    }
+    return 0;
+}
+
+// Lowercase name, as used in ONNX type strings ("float", "float16", ...)
+constexpr const char* DataTypeName(DataType type) {
+    switch (type) {
+        case DataType::Float: return "float";
+        case DataType::Double: return "double";
+        case DataType::Float16: return "float16";
+        case DataType::BFloat16: return "bfloat16";
+        case DataType::Int8: return "int8";
+        case DataType::Int32: return "int32";
+        case DataType::Int64: return "int64";
+        case DataType::Bool: return "bool";
+    }
+    return "unknown";
+}
+
+constexpr bool IsFloatType(DataType type) {
+    return type == DataType::Float || type == DataType::Double || type == DataType::Float16 ||
+           type == DataType::BFloat16;
+}
+
+constexpr bool IsIntType(DataType type) {
+    return type == DataType::Int8 || type == DataType::Int32 || type == DataType::Int64;
+}
+
+// Operations understood by the executor, grouped by form. Values are stored in EPContext
+// blobs and the program cache, so changing them means bumping both formats' versions.
+enum class OpCode : uint8_t {
+    // dst = src0 op src1, all of one type
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Max,
+    Min,
+    Pow,
+
+    // dst = src0 op src1 as a Bool
+    Equal,
+    Less,
+    Greater,
+    LessOrEqual,
+    GreaterOrEqual,
+
+    // dst = op(src0)
+    Neg,
+    Abs,
+    Relu,
+    Sigmoid,
+    Tanh,
+    Gelu,      // Exact form, x * Phi(x)
+    GeluTanh,  // Tanh approximation
+    Erf,
+    Exp,
+    Log,
+    Sqrt,
+    Reciprocal,
+
+    // dst = src0 ? src1 : src2, with a Bool src0
+    Where,
+
+    // dst = src0 converted to the type of dst
+    Cast,
+
+    // Row ops: dst = op over the axes in ExprProgram::row of src0 (see RowSpec)
+    ReduceSum,
+    ReduceMean,
+    ReduceMax,
+    Softmax,
+    LayerNorm,  // (x - mean) / sqrt(variance + epsilon); scale and bias are separate instructions
+    MatMul,     // src0 [..., k] times the constant [k, n] weight in partition input src1
+};
+
+constexpr size_t kNumOpCodes = static_cast<size_t>(OpCode::MatMul) + 1;
+
+// Ranges of OpCode values sharing a form
+constexpr size_t kNumArithmeticOps = static_cast<size_t>(OpCode::Pow) + 1;
+constexpr size_t kNumBinaryOps = static_cast<size_t>(OpCode::GreaterOrEqual) + 1;
+constexpr size_t kFirstUnaryOp = static_cast<size_t>(OpCode::Neg);
+constexpr size_t kNumUnaryOps = static_cast<size_t>(OpCode::Reciprocal) + 1 - kFirstUnaryOp;
+constexpr size_t kFirstRowOp = static_cast<size_t>(OpCode::ReduceSum);
+
+constexpr bool IsBinaryOp(OpCode op) { return static_cast<size_t>(op) < kNumBinaryOps; }
+constexpr bool IsCompareOp(OpCode op) { return IsBinaryOp(op) && static_cast<size_t>(op) >= kNumArithmeticOps; }
+constexpr bool IsUnaryOp(OpCode op) {
+    return static_cast<size_t>(op) >= kFirstUnaryOp && static_cast<size_t>(op) < kFirstUnaryOp + kNumUnaryOps;
+}
+constexpr bool IsRowOp(OpCode op) {
+    return static_cast<size_t>(op) >= kFirstRowOp && static_cast<size_t>(op) < kNumOpCodes;
+}
+constexpr bool IsReduceOp(OpCode op) {
+    return op == OpCode::ReduceSum || op == OpCode::ReduceMean || op == OpCode::ReduceMax;
+}
+
+// Number of source registers an instruction reads
+constexpr size_t OpArity(OpCode op) {
+    return op == OpCode::Where ? 3 : IsBinaryOp(op) || op == OpCode::MatMul ? 2 : 1;
+}
+
+// Whether the executor has a kernel for `op` on operands of `type`. This is the type of src0,
+// except for Where, whose src0 is always Bool and which is keyed by the type it selects.
+constexpr bool HasKernel(OpCode op, DataType type) {
+    switch (op) {
+        case OpCode::Add:
+        case OpCode::Sub:
+        case OpCode::Mul:
+        case OpCode::Div:
+        case OpCode::Max:
+        case OpCode::Min:
+        case OpCode::Less:
+        case OpCode::Greater:
+        case OpCode::LessOrEqual:
+        case OpCode::GreaterOrEqual:
+        case OpCode::Neg:
+        case OpCode::Abs:
+        case OpCode::Relu:
+            return type != DataType::Bool;
+        case OpCode::Pow:
+            return type != DataType::Bool && type != DataType::Int8;
+        case OpCode::Equal:
+        case OpCode::Where:
+        case OpCode::Cast:
+            return true;
+        case OpCode::ReduceSum:
+        case OpCode::ReduceMean:
+        case OpCode::ReduceMax:
+        case OpCode::Softmax:
+        case OpCode::LayerNorm:
+        case OpCode::MatMul:
+            return type == DataType::Float;
+        default:
+            return IsFloatType(type);
+    }
+}
+
+// Activations that can be fused into the arithmetic instruction producing their input, so a
+// pattern like Gelu(Add(x, b)) runs as one kernel
+enum class Activation : uint8_t {
+    None,
+    Relu,
+    Sigmoid,
+    Tanh,
+    Gelu,
+    GeluTanh,
+};
+
+constexpr size_t kNumActivations = static_cast<size_t>(Activation::GeluTanh) + 1;
+
+// The unary op an activation computes. Activation::None has none and maps past the last opcode.
+constexpr OpCode ActivationOp(Activation act) {
+    switch (act) {
+        case Activation::Relu: return OpCode::Relu;
+        case Activation::Sigmoid: return OpCode::Sigmoid;
+        case Activation::Tanh: return OpCode::Tanh;
+        case Activation::Gelu: return OpCode::Gelu;
+        case Activation::GeluTanh: return OpCode::GeluTanh;
+        case Activation::None: break;
+    }
+    return static_cast<OpCode>(kNumOpCodes);
+}
+
+// Whether `op` on `type` has kernels with a fused activation
+constexpr bool HasEpilogue(OpCode op, DataType type) {
+    return (op == OpCode::Add || op == OpCode::Sub || op == OpCode::Mul) && IsFloatType(type);
+}
+
+// One bytecode instruction: dst = epilogue(op(src[0], ..., src[OpArity(op) - 1])). Unused
+// sources are 0.
+struct Instr {
+    OpCode op;
+    Activation epilogue = Activation::None;
+    uint16_t dst;
+    uint16_t src[3];
+};
+
+// Check the operand types of one instruction: `src` holds OpArity(op) types
+bool IsSupportedInstr(OpCode op, Activation epilogue, const DataType* src, DataType dst);
+
+// Where a program's row instruction works. Its operand is viewed as [outer, n, inner] with
+// n spanning dims [axis_begin, axis_end): reductions collapse n to one value per (outer, inner)
+// position and normalizations rescale each run of n values. MatMul contracts n, the last dim,
+// against the weight.
+struct RowSpec {
+    uint32_t axis_begin = 0;
+    uint32_t axis_end = 0;
+    bool keep_dims = true;     // Reductions: the reduced dims stay in the output as 1s
+    float epsilon = 0;         // LayerNorm
+    bool transposed = false;   // MatMul: the weight is stored [n, k]
+
+    bool operator==(const RowSpec& other) const {
+        return axis_begin == other.axis_begin && axis_end == other.axis_end &&
+               keep_dims == other.keep_dims && epsilon == other.epsilon && transposed == other.transposed;
+    }
+};
+
+// ============================================================================
+// ExprProgram - Bytecode for one fused partition
+// ============================================================================
+struct ExprProgram {
+    uint32_t num_inputs = 0;  // Registers [0, num_inputs) are the partition inputs
+    uint32_t num_registers = 0;
+    std::vector<DataType> types;  // Element type of each register
+    std::vector<Instr> code;
+
+    // Register holding each partition output, in fused node output order
+    std::vector<uint32_t> outputs;
+
+    // Axes of the row instruction, for programs with one (at most one is allowed)
+    RowSpec row;
+};
+
+// Index of the program's row instruction, or code.size() if it has none
+size_t FindRowInstr(const ExprProgram& program);
+
+// Check the invariants the executors rely on: registers are assigned in order (inputs, then
+// one per instruction), every source is defined before use, operand types match a kernel,
+// outputs are computed registers and there is at most one row instruction.
+// CompileFusedGraph guarantees them; programs read back from storage must be checked.
+bool ValidateProgram(const ExprProgram& program);
+
+// Number of elements processed per tile. Each live intermediate register holds one tile, and
+// registers that are never live together share one, so the working set of a program stays
+// in L1 even for long chains.
+constexpr size_t kTileElements = 256;
+
+// Run the program over output elements [begin, end) of the iteration space described by
+// `plan`, using the kernels the plan selected. Programs with a row instruction run through
+// RunRowPlan instead. Inputs are read through the plan's broadcast
+// strides; outputs are contiguous. Buffers hold elements of their register's type.
+void ExecuteProgram(const ExprProgram& program, const ExecutionPlan& plan,
+                    const void* const* inputs, void* const* outputs, size_t begin, size_t end);
@@ -0,0 +1,127 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Vectorized compute kernels and runtime ISA dispatch
+//
+// Each instruction set has its own translation unit compiled with the matching target flags.
+// The best table the CPU supports is selected once, when the factory is created.
+
+#pragma once
+
+#include "expr_program.h"
+
+#include <cstddef>
+
+// Instruction sets with a kernel table, in increasing order of preference per architecture
+enum class Isa : uint8_t {
+    Scalar,
+    Sse4,
+    Avx2,
+    Avx512,
+    Neon,
+};
+
+// Lowercase name, as used in KernelTable::name and the "isa" EP option
+constexpr const char* IsaName(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::Sse4: return "sse4";
+        case Isa::Avx2: return "avx2";
+        case Isa::Avx512: return "avx512";
+        case Isa::Neon: return "neon";
+    }
+    return "unknown";
+}
+
+// out[i] = op(src[0][i], ..., src[k][i]) for i in [0, n), with k + 1 the op's arity. Each
+// buffer holds elements of its register's type. Broadcast variants read some sources as a
+// single element, e.g. out[i] = a[i] op b[0].
+using Kernel = void (*)(const void* const* src, void* out, size_t n);
+
+// Which operands of a binary kernel stream through memory; the others are one element held
+// in a register
+enum class Operands : uint8_t {
+    VectorVector,
+    VectorScalar,
+    ScalarVector,
+};
+
+constexpr size_t kNumOperandKinds = 3;
+
+// Binary ops computed on the traits' vectors rather than lane by lane
+constexpr size_t kNumVectorOps = static_cast<size_t>(OpCode::Div) + 1;
+
+// Kernels for one element type, the type of src[0] (of src[1] for Where). Entries the type
+// does not support (see HasKernel, HasEpilogue) are null.
+struct TypedKernels {
+    Kernel binary[kNumBinaryOps][kNumActivations][kNumOperandKinds];  // [op][epilogue][operands]
+    Kernel unary[kNumUnaryOps];                                       // [op - kFirstUnaryOp]
+    Kernel where[8];                     // Bit k of the index: src[k] is a single element
+    Kernel cast[kNumDataTypes];          // [destination type]
+
+    // The same kernels over exactly kTileElements elements, for plans specialized to hot
+    // shapes: with the length a constant, their loops have fixed trip counts and no remainder
+    Kernel tile_binary[kNumVectorOps][kNumActivations][kNumOperandKinds];  // Add, Sub, Mul, Div
+    Kernel tile_unary[kNumUnaryOps];
+};
+
+// Float kernels for the row ops, over one run of n values. Results may be written over x.
+struct RowKernels {
+    float (*sum)(const float* x, size_t n);
+    float (*max)(const float* x, size_t n);  // -inf for n == 0
+
+    // acc[i] = acc[i] + x[i], or max(acc[i], x[i]), for i in [0, n): one reduced row of a
+    // reduction whose values are strided by the inner dim
+    void (*accumulate_sum)(const float* x, float* acc, size_t n);
+    void (*accumulate_max)(const float* x, float* acc, size_t n);
+
+    void (*softmax)(const float* x, float* out, size_t n);
+    void (*layer_norm)(const float* x, float* out, size_t n, float epsilon);
+};
+
+// Float GEMM against a weight packed once into panels of panel_width columns, each holding
+// its columns for every k contiguously (zero-padded past n)
+struct GemmKernels {
+    size_t panel_width;
+
+    // Pack b, [k, n] or [n, k] when transposed, into `packed`, which holds
+    // k * panel_width floats per panel
+    void (*pack)(const float* b, size_t k, size_t n, bool transposed, float* packed);
+
+    // c[rows, n] = a[rows, k] * b over columns [col_begin, col_end). col_begin must be a
+    // multiple of panel_width, and so must col_end unless it is n.
+    void (*multiply)(const float* a, size_t rows, size_t k, const float* packed, size_t n,
+                     size_t col_begin, size_t col_end, float* c);
+};
+
+// ============================================================================
+// KernelTable - Kernels for one instruction set
+// ============================================================================
+struct KernelTable {
+    Isa isa;
+    const char* name;
+    TypedKernels types[kNumDataTypes];  // Indexed by DataType
+    RowKernels row;
+    GemmKernels gemm;
+
+    const TypedKernels& For(DataType type) const { return types[static_cast<size_t>(type)]; }
+};
+
+// Detect the best instruction set supported by this CPU and OS
+Isa DetectIsa();
+
+// Get the kernel table for an instruction set, or nullptr if it is not built into this
+// library or not supported by the CPU
+const KernelTable* GetKernelTable(Isa isa);
+
+// Get the kernel table for the best instruction set available
+const KernelTable& SelectKernelTable();
+
+// Per-ISA tables, defined in src/kernels_<isa>.cpp
+const KernelTable& GetScalarKernelTable();
+#if defined(SAMPLE_EP_X86_KERNELS)
+const KernelTable& GetSse4KernelTable();
+const KernelTable& GetAvx2KernelTable();
+const KernelTable& GetAvx512KernelTable();
+#endif
+#if defined(SAMPLE_EP_NEON_KERNELS)
+const KernelTable& GetNeonKernelTable();
+#endif
@@ -0,0 +1,1101 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Kernel templates shared by the per-ISA translation units
+//
+// Each src/kernels_<isa>.cpp defines vector traits types in an anonymous namespace and
+// instantiates these templates with them. Everything here must depend on a traits type or
+// be static: a plain inline function would be emitted once per ISA and the linker could keep
+// the copy built for a wider instruction set than the CPU has.
+//
+// Traits provide:
+//   using Elem = <storage type>;        using V = <vector type>;
+//   static constexpr size_t kWidth = <lanes>;
+//   static V Load(const Elem*);         static void Store(Elem*, V);
+//   static V Add(V, V);  Sub  Mul  Div
+// and, when V does not hold Elem values (16-bit floats computed in float):
+//   using Compute = <traits whose Elem is the type V holds>;
+//
+// Only float and double need hand-written traits per ISA. Integer types use LaneTraits, whose
+// fixed-width lane loops the compiler vectorizes under each translation unit's target flags,
+// and the 16-bit float types are computed in float through WidenedTraits. Add, Sub, Mul and
+// Div run on the traits' vectors; every other op is written one lane at a time over the
+// compute type and left to the same auto-vectorization.
+
+#pragma once
+
+#include "kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+// Arithmetic on the traits' vectors, templated on the traits so each ISA and element type
+// gets its own copy
+template <class T, OpCode kOp>
+struct ArithmeticOp {
+    static typename T::V Apply(typename T::V a, typename T::V b) {
+        if constexpr (kOp == OpCode::Add) return T::Add(a, b);
+        if constexpr (kOp == OpCode::Sub) return T::Sub(a, b);
+        if constexpr (kOp == OpCode::Mul) return T::Mul(a, b);
+        if constexpr (kOp == OpCode::Div) return T::Div(a, b);
+    }
+};
+
+// ============================================================================
+// Element traits built on top of the per-ISA float traits
+// ============================================================================
+
+// Integer lanes. Arithmetic wraps on overflow, division truncates toward zero, and division
+// by zero yields 0 rather than trapping.
+template <class E, size_t W, class Tag>
+struct LaneTraits {
+    using Elem = E;
+    struct V {
+        E lane[W];
+    };
+    static constexpr size_t kWidth = W;
+
+    static V Load(const E* p) {
+        V v;
+        std::memcpy(v.lane, p, sizeof(v.lane));
+        return v;
+    }
+    static void Store(E* p, V v) { std::memcpy(p, v.lane, sizeof(v.lane)); }
+
+    static V Add(V a, V b) {
+        for (size_t i = 0; i < W; ++i) a.lane[i] = static_cast<E>(U(a.lane[i]) + U(b.lane[i]));
+        return a;
+    }
+    static V Sub(V a, V b) {
+        for (size_t i = 0; i < W; ++i) a.lane[i] = static_cast<E>(U(a.lane[i]) - U(b.lane[i]));
+        return a;
+    }
+    static V Mul(V a, V b) {
+        for (size_t i = 0; i < W; ++i) a.lane[i] = static_cast<E>(U(a.lane[i]) * U(b.lane[i]));
+        return a;
+    }
+    static V Div(V a, V b) {
+        for (size_t i = 0; i < W; ++i) {
+            const E x = a.lane[i];
+            const E y = b.lane[i];
+            // -x is computed unsigned so that MIN / -1 wraps instead of overflowing
+            a.lane[i] = y == 0 ? E(0) : y == E(-1) ? static_cast<E>(U(0) - U(x)) : static_cast<E>(x / y);
+        }
+        return a;
+    }
+
+private:
+    using U = std::make_unsigned_t<E>;
+};
+
+// Integer lanes filling the same register width as the float traits F
+template <class E, class F>
+using IntTraits = LaneTraits<E, (sizeof(typename F::V) >= sizeof(E) ? sizeof(typename F::V) / sizeof(E) : 1), F>;
+
+// IEEE binary16 <-> float, rounding to nearest even
+template <class Tag>
+struct HalfConvert {
+    static float ToFloat(uint16_t h) {
+        const uint32_t sign = uint32_t(h & 0x8000) << 16;
+        uint32_t exponent = (h >> 10) & 0x1F;
+        uint32_t mantissa = h & 0x3FF;
+        uint32_t bits;
+        if (exponent == 0x1F) {
+            bits = sign | 0x7F800000 | (mantissa << 13);  // Inf, NaN
+        } else if (exponent != 0) {
+            bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        } else if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // Subnormal: renormalize into the float exponent range
+            exponent = 113;
+            while ((mantissa & 0x400) == 0) {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+        }
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+    static uint16_t FromFloat(float f) {
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        const uint32_t magnitude = bits & 0x7FFFFFFF;
+
+        if (magnitude >= 0x7F800000) {
+            return sign | (magnitude > 0x7F800000 ? 0x7E00 : 0x7C00);  // NaN, Inf
+        }
+        if (magnitude >= 0x477FF000) {
+            return sign | 0x7C00;  // Rounds past the largest half (65504)
+        }
+        if (magnitude < 0x38800000) {
+            // Subnormal or zero: adding 0.5 lines the half's 2^-24 units up with the low
+            // mantissa bits, and the FPU does the rounding
+            float shifted;
+            std::memcpy(&shifted, &magnitude, sizeof(shifted));
+            shifted += 0.5f;
+            uint32_t shifted_bits;
+            std::memcpy(&shifted_bits, &shifted, sizeof(shifted_bits));
+            return sign | static_cast<uint16_t>(shifted_bits - 0x3F000000);
+        }
+        // Normal: rebias the exponent and round the mantissa to 10 bits
+        const uint32_t odd = (magnitude >> 13) & 1;
+        return sign | static_cast<uint16_t>((magnitude + 0xC8000FFF + odd) >> 13);
+    }
+};
+
+// bfloat16 <-> float, rounding to nearest even
+template <class Tag>
+struct BFloat16Convert {
+    static float ToFloat(uint16_t v) {
+        const uint32_t bits = uint32_t(v) << 16;
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+    static uint16_t FromFloat(float f) {
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        if ((bits & 0x7FFFFFFF) > 0x7F800000) {
+            return static_cast<uint16_t>((bits >> 16) | 0x40);  // Keep NaNs quiet
+        }
+        return static_cast<uint16_t>((bits + 0x7FFF + ((bits >> 16) & 1)) >> 16);
+    }
+};
+
+// 16-bit floats computed in float: convert on load and store, arithmetic from F
+template <class F, class Convert>
+struct WidenedTraits {
+    using Elem = uint16_t;
+    using V = typename F::V;
+    using Compute = F;
+    static constexpr size_t kWidth = F::kWidth;
+
+    static V Load(const uint16_t* p) {
+        float lanes[kWidth];
+        for (size_t i = 0; i < kWidth; ++i) lanes[i] = Convert::ToFloat(p[i]);
+        return F::Load(lanes);
+    }
+    static void Store(uint16_t* p, V v) {
+        float lanes[kWidth];
+        F::Store(lanes, v);
+        for (size_t i = 0; i < kWidth; ++i) p[i] = Convert::FromFloat(lanes[i]);
+    }
+
+    static V Add(V a, V b) { return F::Add(a, b); }
+    static V Sub(V a, V b) { return F::Sub(a, b); }
+    static V Mul(V a, V b) { return F::Mul(a, b); }
+    static V Div(V a, V b) { return F::Div(a, b); }
+};
+
+// Traits whose Elem is the type T's vectors hold: T::Compute if present, otherwise T
+template <class T, class = void>
+struct ComputeTraitsOf {
+    using type = T;
+};
+
+template <class T>
+struct ComputeTraitsOf<T, std::void_t<typename T::Compute>> {
+    using type = typename T::Compute;
+};
+
+template <class T>
+using ComputeTraits = typename ComputeTraitsOf<T>::type;
+
+// Type of one lane as ops compute it
+template <class T>
+using Lane = typename ComputeTraits<T>::Elem;
+
+// ============================================================================
+// Float math
+// ============================================================================
+
+// float transcendentals as branch-free polynomials, so that lane loops over them vectorize.
+// Exp, Log and Tanh follow Cephes (about 1-2 ulp); Erf is within 2e-7 absolute: the tail's
+// 1.5e-7 bound plus float rounding.
+template <class Tag>
+struct FloatMath {
+    static uint32_t Bits(float x) {
+        uint32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        return bits;
+    }
+    static float FromBits(uint32_t bits) {
+        float x;
+        std::memcpy(&x, &bits, sizeof(x));
+        return x;
+    }
+
+    // exp(x) = 2^n * exp(r) with n = round(x / ln2) and |r| <= ln2 / 2
+    static float Exp(float x) {
+        constexpr float kMax = 88.7228394f;   // ln(FLT_MAX)
+        constexpr float kMin = -103.972084f;  // ln of the smallest subnormal
+        const float xc = x > kMax ? kMax : x < kMin ? kMin : x;
+
+        // Adding 1.5 * 2^23 rounds to an integer, which lands in the low mantissa bits
+        const float shifted = xc * 1.44269504f + 12582912.0f;
+        const float n = shifted - 12582912.0f;
+        const float r = xc - n * 0.693359375f + n * 2.12194440e-4f;
+
+        float p = 1.9875691500e-4f;
+        p = p * r + 1.3981999507e-3f;
+        p = p * r + 8.3334519073e-3f;
+        p = p * r + 4.1665795894e-2f;
+        p = p * r + 1.6666665459e-1f;
+        p = p * r + 5.0000001201e-1f;
+        p = p * r * r + r + 1.0f;
+
+        // 2^n applied as two factors, so n in [-150, 128] never leaves the normal range
+        const auto ni = static_cast<int32_t>(Bits(shifted) - 0x4B400000u);
+        const int32_t n1 = ni / 2;
+        const float s1 = FromBits(static_cast<uint32_t>(n1 + 127) << 23);
+        const float s2 = FromBits(static_cast<uint32_t>(ni - n1 + 127) << 23);
+        const float result = p * s1 * s2;
+        return x > kMax ? std::numeric_limits<float>::infinity() : x < kMin ? 0.0f : result;
+    }
+
+    // log(x) = e * ln2 + log(m) with m in [sqrt(1/2), sqrt(2))
+    static float Log(float x) {
+        const bool subnormal = x < 1.17549435e-38f;
+        const float xs = subnormal ? x * 8388608.0f : x;
+        const uint32_t bits = Bits(xs);
+        float e = static_cast<float>(static_cast<int32_t>((bits >> 23) & 0xFF) - 126) -
+                  (subnormal ? 23.0f : 0.0f);
+        float m = FromBits((bits & 0x007FFFFFu) | 0x3F000000u);  // [0.5, 1)
+        const bool low = m < 0.707106781f;
+        e = low ? e - 1.0f : e;
+        m = low ? m + m - 1.0f : m - 1.0f;
+
+        const float z = m * m;
+        float y = 7.0376836292e-2f;
+        y = y * m - 1.1514610310e-1f;
+        y = y * m + 1.1676998740e-1f;
+        y = y * m - 1.2420140846e-1f;
+        y = y * m + 1.4249322787e-1f;
+        y = y * m - 1.6668057665e-1f;
+        y = y * m + 2.0000714765e-1f;
+        y = y * m - 2.4999993993e-1f;
+        y = y * m + 3.3333331174e-1f;
+        y = y * m * z - 2.12194440e-4f * e - 0.5f * z;
+        const float result = m + y + 0.693359375f * e;
+
+        constexpr float kInf = std::numeric_limits<float>::infinity();
+        return x != x ? x : x < 0.0f ? std::numeric_limits<float>::quiet_NaN()
+                          : x == 0.0f ? -kInf : x == kInf ? kInf : result;
+    }
+
+    static float Tanh(float x) {
+        // Odd polynomial near zero, 1 - 2 / (exp(2|x|) + 1) beyond
+        const float z = x * x;
+        float p = -5.70498872745e-3f;
+        p = p * z + 2.06390887954e-2f;
+        p = p * z - 5.37397155531e-2f;
+        p = p * z + 1.33314422036e-1f;
+        p = p * z - 3.33332819422e-1f;
+        const float small = p * z * x + x;
+
+        const float ax = std::fabs(x);
+        const float large = 1.0f - 2.0f / (Exp(2.0f * ax) + 1.0f);
+        return ax < 0.625f ? small : std::copysign(large, x);
+    }
+
+    static float Sigmoid(float x) { return 1.0f / (1.0f + Exp(-x)); }
+
+    // erfc(a) for a >= 1 (Abramowitz & Stegun 7.1.26)
+    static float ErfcTail(float a) {
+        const float t = 1.0f / (1.0f + 0.3275911f * a);
+        float q = 1.061405429f;
+        q = q * t - 1.453152027f;
+        q = q * t + 1.421413741f;
+        q = q * t - 0.284496736f;
+        q = q * t + 0.254829592f;
+        return q * t * Exp(-a * a);
+    }
+
+    static float Erf(float x) {
+        // |x| < 1: x * P(x^2)
+        const float z = x * x;
+        float p = 7.853861353153693e-5f;
+        p = p * z - 8.010193625184903e-4f;
+        p = p * z + 5.188327685732524e-3f;
+        p = p * z - 2.685381193529856e-2f;
+        p = p * z + 1.128358514861418e-1f;
+        p = p * z - 3.761262582423300e-1f;
+        p = p * z + 1.128379165726710e+0f;
+        const float small = x * p;
+
+        const float ax = std::fabs(x);
+        return ax < 1.0f ? small : std::copysign(1.0f - ErfcTail(ax), x);
+    }
+
+    static float Gelu(float x) {
+        // 1 + erf(u) is taken from the tail form where it would cancel
+        const float u = x * 0.707106781f;
+        return 0.5f * x * (u <= -1.0f ? ErfcTail(-u) : 1.0f + Erf(u));
+    }
+
+    static float GeluTanh(float x) {
+        // 0.5 * (1 + tanh(y)) = sigmoid(2y)
+        return x / (1.0f + Exp(-1.59576912f * (x + 0.044715f * x * x * x)));
+    }
+
+    // C pow semantics for finite operands; the result is exp(b * log|a|), so its relative
+    // error grows with |b * log|a|| (to about 1e-5 near overflow)
+    static float Pow(float a, float b) {
+        const float magnitude = Exp(b * Log(std::fabs(a)));
+        const bool integral = std::trunc(b) == b;
+        const bool odd = integral && std::fabs(b) < 16777216.0f && (static_cast<int32_t>(b) & 1) != 0;
+        float result = a < 0.0f ? (integral ? (odd ? -magnitude : magnitude)
+                                            : std::numeric_limits<float>::quiet_NaN())
+                                : magnitude;
+        result = a == 0.0f && odd ? std::copysign(result, a) : result;  // (-0)^3 = -0
+        return b == 0.0f || a == 1.0f ? 1.0f : result;
+    }
+};
+
+// double keeps libm accuracy
+template <class Tag>
+struct DoubleMath {
+    static double Exp(double x) { return std::exp(x); }
+    static double Log(double x) { return std::log(x); }
+    static double Tanh(double x) { return std::tanh(x); }
+    static double Sigmoid(double x) { return 1.0 / (1.0 + std::exp(-x)); }
+    static double Erf(double x) { return std::erf(x); }
+    static double Gelu(double x) { return 0.5 * x * std::erfc(-x * 0.70710678118654752); }
+    static double GeluTanh(double x) {
+        return x / (1.0 + std::exp(-1.5957691216057308 * (x + 0.044715 * x * x * x)));
+    }
+    static double Pow(double a, double b) { return std::pow(a, b); }
+};
+
+template <class T>
+using MathOf = std::conditional_t<std::is_same_v<Lane<T>, double>, DoubleMath<T>, FloatMath<T>>;
+
+// ============================================================================
+// Lane ops
+// ============================================================================
+
+// dst = op(x) on one lane of T's compute type
+template <class T, OpCode kOp>
+struct UnaryOp {
+    using L = Lane<T>;
+
+    static L Apply(L x) {
+        if constexpr (std::is_integral_v<L>) {
+            using U = std::make_unsigned_t<L>;
+            // Negation is computed unsigned so that -MIN wraps instead of overflowing
+            if constexpr (kOp == OpCode::Neg) return static_cast<L>(U(0) - U(x));
+            if constexpr (kOp == OpCode::Abs) return x < 0 ? static_cast<L>(U(0) - U(x)) : x;
+            if constexpr (kOp == OpCode::Relu) return x < 0 ? L(0) : x;
+        } else {
+            using Math = MathOf<T>;
+            if constexpr (kOp == OpCode::Neg) return -x;
+            if constexpr (kOp == OpCode::Abs) return std::fabs(x);
+            if constexpr (kOp == OpCode::Relu) return x < L(0) ? L(0) : x;
+            if constexpr (kOp == OpCode::Sigmoid) return Math::Sigmoid(x);
+            if constexpr (kOp == OpCode::Tanh) return Math::Tanh(x);
+            if constexpr (kOp == OpCode::Gelu) return Math::Gelu(x);
+            if constexpr (kOp == OpCode::GeluTanh) return Math::GeluTanh(x);
+            if constexpr (kOp == OpCode::Erf) return Math::Erf(x);
+            if constexpr (kOp == OpCode::Exp) return Math::Exp(x);
+            if constexpr (kOp == OpCode::Log) return Math::Log(x);
+            if constexpr (kOp == OpCode::Sqrt) return std::sqrt(x);
+            if constexpr (kOp == OpCode::Reciprocal) return L(1) / x;
+        }
+    }
+};
+
+// dst = a op b on one lane of T's compute type. Comparisons return bool.
+template <class T, OpCode kOp>
+struct BinaryLaneOp {
+    using L = Lane<T>;
+
+    static auto Apply(L a, L b) {
+        if constexpr (kOp == OpCode::Add) return L(a + b);
+        if constexpr (kOp == OpCode::Sub) return L(a - b);
+        if constexpr (kOp == OpCode::Mul) return L(a * b);
+        // NaN in either operand propagates
+        if constexpr (kOp == OpCode::Max) return a > b || a != a ? a : b;
+        if constexpr (kOp == OpCode::Min) return a < b || a != a ? a : b;
+        if constexpr (kOp == OpCode::Pow) return Pow(a, b);
+        if constexpr (kOp == OpCode::Equal) return a == b;
+        if constexpr (kOp == OpCode::Less) return a < b;
+        if constexpr (kOp == OpCode::Greater) return a > b;
+        if constexpr (kOp == OpCode::LessOrEqual) return a <= b;
+        if constexpr (kOp == OpCode::GreaterOrEqual) return a >= b;
+    }
+
+private:
+    static L Pow(L a, L b) {
+        if constexpr (std::is_integral_v<L>) {
+            // Exponentiation by squaring, wrapping on overflow. Negative exponents truncate
+            // 1 / a^|b| toward zero.
+            if (b < 0) return a == 1 ? L(1) : a == L(-1) ? ((b & 1) ? L(-1) : L(1)) : L(0);
+            using U = std::make_unsigned_t<L>;
+            U result = 1;
+            U base = static_cast<U>(a);
+            for (U e = static_cast<U>(b); e != 0; e >>= 1) {
+                if (e & 1) result *= base;
+                base *= base;
+            }
+            return static_cast<L>(result);
+        } else {
+            return MathOf<T>::Pow(a, b);
+        }
+    }
+};
+
+// An arithmetic op followed by its fused activation
+template <class T, OpCode kOp, Activation kAct>
+struct FusedOp {
+    static Lane<T> Apply(Lane<T> a, Lane<T> b) {
+        const Lane<T> y = BinaryLaneOp<T, kOp>::Apply(a, b);
+        if constexpr (kAct == Activation::None) {
+            return y;
+        } else {
+            return UnaryOp<T, ActivationOp(kAct)>::Apply(y);
+        }
+    }
+};
+
+// ============================================================================
+// Kernels
+// ============================================================================
+
+// Broadcast one element to every lane
+template <class T>
+typename T::V Splat(const typename T::Elem* value) {
+    typename T::Elem lanes[T::kWidth];
+    for (size_t i = 0; i < T::kWidth; ++i) lanes[i] = *value;
+    return T::Load(lanes);
+}
+
+// Four vectors per iteration keep enough independent loads in flight to reach memory
+// bandwidth; the remainder runs one vector at a time, then one zero-padded vector.
+template <class T, class Op, Operands kOperands>
+void BinaryKernelImpl(const void* const* src, void* out_data, size_t n) {
+    using E = typename T::Elem;
+    using V = typename T::V;
+    constexpr size_t W = T::kWidth;
+    constexpr bool kStreamA = kOperands != Operands::ScalarVector;
+    constexpr bool kStreamB = kOperands != Operands::VectorScalar;
+
+    const E* a = static_cast<const E*>(src[0]);
+    const E* b = static_cast<const E*>(src[1]);
+    E* out = static_cast<E*>(out_data);
+
+    V va{};
+    V vb{};
+    if constexpr (!kStreamA) va = Splat<T>(a);
+    if constexpr (!kStreamB) vb = Splat<T>(b);
+    auto load_a = [&](size_t i) { if constexpr (kStreamA) return T::Load(a + i); else return va; };
+    auto load_b = [&](size_t i) { if constexpr (kStreamB) return T::Load(b + i); else return vb; };
+
+    size_t i = 0;
+    for (; i + 4 * W <= n; i += 4 * W) {
+        V r0 = Op::Apply(load_a(i), load_b(i));
+        V r1 = Op::Apply(load_a(i + W), load_b(i + W));
+        V r2 = Op::Apply(load_a(i + 2 * W), load_b(i + 2 * W));
+        V r3 = Op::Apply(load_a(i + 3 * W), load_b(i + 3 * W));
+        T::Store(out + i, r0);
+        T::Store(out + i + W, r1);
+        T::Store(out + i + 2 * W, r2);
+        T::Store(out + i + 3 * W, r3);
+    }
+    for (; i + W <= n; i += W) {
+        T::Store(out + i, Op::Apply(load_a(i), load_b(i)));
+    }
+    if (i < n) {
+        const size_t rest = n - i;
+        E ta[W] = {};
+        E tb[W] = {};
+        E to[W];
+        if constexpr (kStreamA) std::memcpy(ta, a + i, rest * sizeof(E));
+        if constexpr (kStreamB) std::memcpy(tb, b + i, rest * sizeof(E));
+        T::Store(to, Op::Apply(kStreamA ? T::Load(ta) : va, kStreamB ? T::Load(tb) : vb));
+        std::memcpy(out + i, to, rest * sizeof(E));
+    }
+}
+
+// Moves blocks between T's storage and its compute lanes. Types stored as their compute type
+// are used in place; 16-bit floats are converted through a block buffer.
+template <class T>
+struct LaneIo {
+    using C = ComputeTraits<T>;
+    using E = typename T::Elem;
+    using L = Lane<T>;
+    static constexpr size_t W = T::kWidth;
+    static constexpr bool kInPlace = std::is_same_v<E, L>;
+    static constexpr size_t kBlock = 64;
+    static_assert(kBlock % W == 0, "blocks must hold whole vectors");
+
+    // Lanes of the m <= kBlock elements at p, in `buffer` if they need converting
+    static const L* Read(const E* p, size_t m, L* buffer) {
+        if constexpr (kInPlace) {
+            (void)m;
+            (void)buffer;
+            return p;
+        } else {
+            size_t j = 0;
+            for (; j + W <= m; j += W) C::Store(buffer + j, T::Load(p + j));
+            if (j < m) {
+                E padded[W] = {};
+                L lanes[W];
+                std::memcpy(padded, p + j, (m - j) * sizeof(E));
+                C::Store(lanes, T::Load(padded));
+                std::memcpy(buffer + j, lanes, (m - j) * sizeof(L));
+            }
+            return buffer;
+        }
+    }
+
+    static L ReadOne(const E* p) {
+        L lane;
+        Read(p, 1, &lane);
+        return kInPlace ? *p : lane;
+    }
+
+    // Where to compute lanes destined for p
+    static L* Target(E* p, L* buffer) {
+        if constexpr (kInPlace) {
+            (void)buffer;
+            return p;
+        } else {
+            (void)p;
+            return buffer;
+        }
+    }
+
+    // Store m lanes computed into Target(p, ...) back to p
+    static void Write(E* p, size_t m, const L* lanes) {
+        if constexpr (!kInPlace) {
+            size_t j = 0;
+            for (; j + W <= m; j += W) T::Store(p + j, C::Load(lanes + j));
+            if (j < m) {
+                L padded[W] = {};
+                E out[W];
+                std::memcpy(padded, lanes + j, (m - j) * sizeof(L));
+                T::Store(out, C::Load(padded));
+                std::memcpy(p + j, out, (m - j) * sizeof(E));
+            }
+        } else {
+            (void)p;
+            (void)m;
+            (void)lanes;
+        }
+    }
+};
+
+// out[i] = Op::Apply(a[i], b[i]) one lane at a time, with inputs of T and output of Out
+template <class T, class Out, class Op, Operands kOperands>
+void LaneBinaryKernelImpl(const void* const* src, void* out_data, size_t n) {
+    using In = LaneIo<T>;
+    using Res = LaneIo<Out>;
+    using L = typename In::L;
+    using R = typename Res::L;
+    constexpr size_t kBlock = In::kBlock;
+    constexpr bool kStreamA = kOperands != Operands::ScalarVector;
+    constexpr bool kStreamB = kOperands != Operands::VectorScalar;
+
+    const auto* a = static_cast<const typename In::E*>(src[0]);
+    const auto* b = static_cast<const typename In::E*>(src[1]);
+    auto* out = static_cast<typename Res::E*>(out_data);
+
+    L sa{};
+    L sb{};
+    if constexpr (!kStreamA) sa = In::ReadOne(a);
+    if constexpr (!kStreamB) sb = In::ReadOne(b);
+
+    L buffer_a[kBlock];
+    L buffer_b[kBlock];
+    R buffer_out[kBlock];
+    for (size_t i = 0; i < n; i += kBlock) {
+        const size_t m = std::min(kBlock, n - i);
+        const L* x = kStreamA ? In::Read(a + i, m, buffer_a) : nullptr;
+        const L* y = kStreamB ? In::Read(b + i, m, buffer_b) : nullptr;
+        R* z = Res::Target(out + i, buffer_out);
+        for (size_t j = 0; j < m; ++j) {
+            z[j] = static_cast<R>(Op::Apply(kStreamA ? x[j] : sa, kStreamB ? y[j] : sb));
+        }
+        Res::Write(out + i, m, z);
+    }
+}
+
+// out[i] = Op::Apply(a[i]) one lane at a time
+template <class T, class Op>
+void LaneUnaryKernelImpl(const void* const* src, void* out_data, size_t n) {
+    using Io = LaneIo<T>;
+    using L = typename Io::L;
+    constexpr size_t kBlock = Io::kBlock;
+
+    const auto* a = static_cast<const typename Io::E*>(src[0]);
+    auto* out = static_cast<typename Io::E*>(out_data);
+
+    L buffer_a[kBlock];
+    L buffer_out[kBlock];
+    for (size_t i = 0; i < n; i += kBlock) {
+        const size_t m = std::min(kBlock, n - i);
+        const L* x = Io::Read(a + i, m, buffer_a);
+        L* z = Io::Target(out + i, buffer_out);
+        for (size_t j = 0; j < m; ++j) z[j] = Op::Apply(x[j]);
+        Io::Write(out + i, m, z);
+    }
+}
+
+// out[i] = cond[i] ? x[i] : y[i] on T's storage. Bit k of kScalar marks src[k] as a single
+// element.
+template <class T, size_t kScalar>
+void WhereKernelImpl(const void* const* src, void* out_data, size_t n) {
+    using E = typename T::Elem;
+    const auto* cond = static_cast<const uint8_t*>(src[0]);
+    const E* x = static_cast<const E*>(src[1]);
+    const E* y = static_cast<const E*>(src[2]);
+    E* out = static_cast<E*>(out_data);
+
+    for (size_t i = 0; i < n; ++i) {
+        const uint8_t c = cond[kScalar & 1 ? 0 : i];
+        out[i] = c ? x[kScalar & 2 ? 0 : i] : y[kScalar & 4 ? 0 : i];
+    }
+}
+
+// ============================================================================
+// Cast
+// ============================================================================
+
+// Element storage and the value it decodes to
+template <class E, class Tag>
+struct PlainCodec {
+    using Elem = E;
+    using Value = E;
+    static E Decode(E v) { return v; }
+    static E Encode(E v) { return v; }
+};
+
+template <class Convert>
+struct HalfCodec {
+    using Elem = uint16_t;
+    using Value = float;
+    static float Decode(uint16_t v) { return Convert::ToFloat(v); }
+    static uint16_t Encode(float v) { return Convert::FromFloat(v); }
+};
+
+template <class Tag>
+struct BoolCodec {
+    using Elem = uint8_t;
+    using Value = bool;
+    static bool Decode(uint8_t v) { return v != 0; }
+    static uint8_t Encode(bool v) { return v ? 1 : 0; }
+};
+
+template <DataType kType, class Tag> struct Codec;
+template <class Tag> struct Codec<DataType::Float, Tag> : PlainCodec<float, Tag> {};
+template <class Tag> struct Codec<DataType::Double, Tag> : PlainCodec<double, Tag> {};
+template <class Tag> struct Codec<DataType::Float16, Tag> : HalfCodec<HalfConvert<Tag>> {};
+template <class Tag> struct Codec<DataType::BFloat16, Tag> : HalfCodec<BFloat16Convert<Tag>> {};
+template <class Tag> struct Codec<DataType::Int8, Tag> : PlainCodec<int8_t, Tag> {};
+template <class Tag> struct Codec<DataType::Int32, Tag> : PlainCodec<int32_t, Tag> {};
+template <class Tag> struct Codec<DataType::Int64, Tag> : PlainCodec<int64_t, Tag> {};
+template <class Tag> struct Codec<DataType::Bool, Tag> : BoolCodec<Tag> {};
+
+// Cast of one value. Anything to bool compares against zero. Floating point to integer
+// truncates and saturates, with NaN going to 0, so no input is undefined behaviour. The rest
+// are plain conversions, so integers wrap when narrowed.
+template <class Tag>
+struct ValueCast {
+    template <class To, class From>
+    static To Apply(From v) {
+        if constexpr (std::is_same_v<To, bool>) {
+            return v != From(0);
+        } else if constexpr (std::is_integral_v<To> && std::is_floating_point_v<From>) {
+            constexpr From kLow = static_cast<From>(std::numeric_limits<To>::min());
+            constexpr From kHigh = static_cast<From>(std::numeric_limits<To>::max());
+            return v != v ? To(0) : v <= kLow ? std::numeric_limits<To>::min()
+                                  : v >= kHigh ? std::numeric_limits<To>::max() : static_cast<To>(v);
+        } else {
+            return static_cast<To>(v);
+        }
+    }
+};
+
+template <class From, class To, class Tag>
+void CastKernelImpl(const void* const* src, void* out_data, size_t n) {
+    const auto* in = static_cast<const typename From::Elem*>(src[0]);
+    auto* out = static_cast<typename To::Elem*>(out_data);
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = To::Encode(ValueCast<Tag>::template Apply<typename To::Value>(From::Decode(in[i])));
+    }
+}
+
+// ============================================================================
+// Row ops (float only, so T is always the ISA's float traits)
+// ============================================================================
+
+// Horizontal sum of four vector accumulators, in a fixed order so a row's result does not
+// depend on where it starts in memory
+template <class T>
+float SumLanes(typename T::V a, typename T::V b, typename T::V c, typename T::V d) {
+    float lanes[T::kWidth];
+    T::Store(lanes, T::Add(T::Add(a, b), T::Add(c, d)));
+    float sum = 0.0f;
+    for (size_t j = 0; j < T::kWidth; ++j) sum += lanes[j];
+    return sum;
+}
+
+// sum((x[i] - center)^2) when kSquares, else sum(x[i]). The tail is padded with `center`, which
+// adds nothing either way.
+template <class T, bool kSquares>
+float RowSumOf(const float* x, size_t n, float center) {
+    using V = typename T::V;
+    constexpr size_t W = T::kWidth;
+    const V c = Splat<T>(&center);
+    auto term = [&](V v) {
+        if constexpr (kSquares) {
+            const V d = T::Sub(v, c);
+            return T::Mul(d, d);
+        } else {
+            return v;
+        }
+    };
+
+    const float zero = 0.0f;
+    V acc0 = Splat<T>(&zero), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    size_t i = 0;
+    for (; i + 4 * W <= n; i += 4 * W) {
+        acc0 = T::Add(acc0, term(T::Load(x + i)));
+        acc1 = T::Add(acc1, term(T::Load(x + i + W)));
+        acc2 = T::Add(acc2, term(T::Load(x + i + 2 * W)));
+        acc3 = T::Add(acc3, term(T::Load(x + i + 3 * W)));
+    }
+    for (; i + W <= n; i += W) acc0 = T::Add(acc0, term(T::Load(x + i)));
+    if (i < n) {
+        float padded[W];
+        for (size_t j = 0; j < W; ++j) padded[j] = i + j < n ? x[i + j] : (kSquares ? center : 0.0f);
+        acc1 = T::Add(acc1, term(T::Load(padded)));
+    }
+    return SumLanes<T>(acc0, acc1, acc2, acc3);
+}
+
+template <class T>
+float RowSumImpl(const float* x, size_t n) {
+    return RowSumOf<T, false>(x, n, 0.0f);
+}
+
+// NaN propagates, as in Max
+template <class T>
+float RowMaxImpl(const float* x, size_t n) {
+    using Max = BinaryLaneOp<T, OpCode::Max>;
+    constexpr size_t L = 4 * T::kWidth;
+    float lanes[L];
+    for (float& lane : lanes) lane = -std::numeric_limits<float>::infinity();
+    size_t i = 0;
+    for (; i + L <= n; i += L) {
+        for (size_t j = 0; j < L; ++j) lanes[j] = Max::Apply(x[i + j], lanes[j]);
+    }
+    for (; i < n; ++i) lanes[0] = Max::Apply(x[i], lanes[0]);
+    float m = lanes[0];
+    for (size_t j = 1; j < L; ++j) m = Max::Apply(lanes[j], m);
+    return m;
+}
+
+template <class T>
+void AccumulateSumImpl(const float* x, float* acc, size_t n) {
+    const void* src[2] = {acc, x};
+    BinaryKernelImpl<T, ArithmeticOp<T, OpCode::Add>, Operands::VectorVector>(src, acc, n);
+}
+
+template <class T>
+void AccumulateMaxImpl(const float* x, float* acc, size_t n) {
+    using Max = BinaryLaneOp<T, OpCode::Max>;
+    for (size_t i = 0; i < n; ++i) acc[i] = Max::Apply(x[i], acc[i]);
+}
+
+// Three passes over a row that stays in cache: the max, exp(x - max) and its sum, then the
+// scaling by 1 / sum
+template <class T>
+void SoftmaxImpl(const float* x, float* out, size_t n) {
+    if (n == 0) return;
+    const float m = RowMaxImpl<T>(x, n);
+
+    constexpr size_t L = 4 * T::kWidth;
+    float lanes[L] = {};
+    size_t i = 0;
+    for (; i + L <= n; i += L) {
+        for (size_t j = 0; j < L; ++j) {
+            const float e = FloatMath<T>::Exp(x[i + j] - m);
+            out[i + j] = e;
+            lanes[j] += e;
+        }
+    }
+    for (; i < n; ++i) {
+        out[i] = FloatMath<T>::Exp(x[i] - m);
+        lanes[0] += out[i];
+    }
+    float sum = 0.0f;
+    for (float lane : lanes) sum += lane;
+
+    const float scale = 1.0f / sum;
+    const void* src[2] = {out, &scale};
+    BinaryKernelImpl<T, ArithmeticOp<T, OpCode::Mul>, Operands::VectorScalar>(src, out, n);
+}
+
+// Two-pass mean and variance: the second pass sums squares about the mean, which keeps the
+// precision a single pass over x and x^2 loses when the mean is large
+template <class T>
+void LayerNormImpl(const float* x, float* out, size_t n, float epsilon) {
+    using V = typename T::V;
+    constexpr size_t W = T::kWidth;
+    if (n == 0) return;
+
+    const float mean = RowSumOf<T, false>(x, n, 0.0f) / static_cast<float>(n);
+    const float variance = RowSumOf<T, true>(x, n, mean) / static_cast<float>(n);
+    const float inv_std = 1.0f / std::sqrt(variance + epsilon);
+
+    const V vmean = Splat<T>(&mean);
+    const V vscale = Splat<T>(&inv_std);
+    size_t i = 0;
+    for (; i + W <= n; i += W) T::Store(out + i, T::Mul(T::Sub(T::Load(x + i), vmean), vscale));
+    for (; i < n; ++i) out[i] = (x[i] - mean) * inv_std;
+}
+
+template <class T>
+RowKernels MakeRowKernels() {
+    RowKernels kernels{};
+    kernels.sum = RowSumImpl<T>;
+    kernels.max = RowMaxImpl<T>;
+    kernels.accumulate_sum = AccumulateSumImpl<T>;
+    kernels.accumulate_max = AccumulateMaxImpl<T>;
+    kernels.softmax = SoftmaxImpl<T>;
+    kernels.layer_norm = LayerNormImpl<T>;
+    return kernels;
+}
+
+// ============================================================================
+// GEMM (float only)
+//
+// The weight is packed into panels of two vectors of columns. A register tile holds
+// kGemmRows rows of c across one panel, so each k step loads two vectors of the panel and
+// broadcasts one value of a per row. k is blocked so the panel slice a tile walks stays in
+// L1 while the rows of a chunk stream past it.
+// ============================================================================
+
+constexpr size_t kGemmRows = 4;
+constexpr size_t kGemmDepth = 256;
+
+template <class T>
+void PackImpl(const float* b, size_t k, size_t n, bool transposed, float* packed) {
+    constexpr size_t NR = 2 * T::kWidth;
+    const size_t panels = (n + NR - 1) / NR;
+    for (size_t p = 0; p < panels; ++p) {
+        float* out = packed + p * k * NR;
+        for (size_t kk = 0; kk < k; ++kk) {
+            for (size_t j = 0; j < NR; ++j) {
+                const size_t col = p * NR + j;
+                out[kk * NR + j] = col >= n ? 0.0f : transposed ? b[col * k + kk] : b[kk * n + col];
+            }
+        }
+    }
+}
+
+// c[kRows, cols] = a[kRows, depth] * panel[depth, NR], added to c when `accumulate`. Rows of
+// a and c are lda and ldc apart; a partial tile (cols < NR) goes through a local buffer.
+template <class T, size_t kRows>
+void GemmTile(const float* a, size_t lda, const float* panel, size_t depth, float* c, size_t ldc,
+              size_t cols, bool accumulate) {
+    using V = typename T::V;
+    constexpr size_t W = T::kWidth;
+    constexpr size_t NR = 2 * W;
+    const bool full = cols == NR;
+
+    float edge[kRows][NR] = {};
+    V acc[kRows][2];
+    const float zero = 0.0f;
+    for (size_t r = 0; r < kRows; ++r) {
+        if (!accumulate) {
+            acc[r][0] = acc[r][1] = Splat<T>(&zero);
+            continue;
+        }
+        const float* src = c + r * ldc;
+        if (!full) {
+            std::memcpy(edge[r], src, cols * sizeof(float));
+            src = edge[r];
+        }
+        acc[r][0] = T::Load(src);
+        acc[r][1] = T::Load(src + W);
+    }
+
+    for (size_t kk = 0; kk < depth; ++kk) {
+        const V b0 = T::Load(panel + kk * NR);
+        const V b1 = T::Load(panel + kk * NR + W);
+        for (size_t r = 0; r < kRows; ++r) {
+            const V av = Splat<T>(a + r * lda + kk);
+            acc[r][0] = T::Add(acc[r][0], T::Mul(av, b0));
+            acc[r][1] = T::Add(acc[r][1], T::Mul(av, b1));
+        }
+    }
+
+    for (size_t r = 0; r < kRows; ++r) {
+        float* dst = full ? c + r * ldc : edge[r];
+        T::Store(dst, acc[r][0]);
+        T::Store(dst + W, acc[r][1]);
+        if (!full) std::memcpy(c + r * ldc, edge[r], cols * sizeof(float));
+    }
+}
+
+template <class T>
+void MultiplyImpl(const float* a, size_t rows, size_t k, const float* packed, size_t n,
+                  size_t col_begin, size_t col_end, float* c) {
+    constexpr size_t NR = 2 * T::kWidth;
+    if (k == 0) {
+        for (size_t r = 0; r < rows; ++r) std::fill(c + r * n + col_begin, c + r * n + col_end, 0.0f);
+        return;
+    }
+
+    for (size_t k0 = 0; k0 < k; k0 += kGemmDepth) {
+        const size_t depth = std::min(kGemmDepth, k - k0);
+        const bool accumulate = k0 > 0;
+        for (size_t col = col_begin; col < col_end; col += NR) {
+            const float* panel = packed + col / NR * k * NR + k0 * NR;
+            const size_t cols = std::min(NR, col_end - col);
+            const float* at = a + k0;
+            float* ct = c + col;
+            size_t r = 0;
+            for (; r + kGemmRows <= rows; r += kGemmRows) {
+                GemmTile<T, kGemmRows>(at + r * k, k, panel, depth, ct + r * n, n, cols, accumulate);
+            }
+            switch (rows - r) {
+                case 3: GemmTile<T, 3>(at + r * k, k, panel, depth, ct + r * n, n, cols, accumulate); break;
+                case 2: GemmTile<T, 2>(at + r * k, k, panel, depth, ct + r * n, n, cols, accumulate); break;
+                case 1: GemmTile<T, 1>(at + r * k, k, panel, depth, ct + r * n, n, cols, accumulate); break;
+                default: break;
+            }
+        }
+    }
+}
+
+template <class T>
+GemmKernels MakeGemmKernels() {
+    GemmKernels kernels{};
+    kernels.panel_width = 2 * T::kWidth;
+    kernels.pack = PackImpl<T>;
+    kernels.multiply = MultiplyImpl<T>;
+    return kernels;
+}
+
+// ============================================================================
+// Tables
+// ============================================================================
+
+// kKernel over exactly kTileElements elements: with the length a constant, the compiler
+// unrolls its loops and drops their remainders
+template <Kernel kKernel>
+void FullTileKernel(const void* const* src, void* out, size_t) {
+    kKernel(src, out, kTileElements);
+}
+
+// kKernel, or its full-tile form
+template <bool kFullTile, Kernel kKernel>
+constexpr Kernel kKernelVariant = kFullTile ? FullTileKernel<kKernel> : kKernel;
+
+// Fill the three operand kinds of one binary op, with vector or lane kernels
+template <class T, class Out, class Op, bool kVector, bool kFullTile = false>
+void SetOperandKinds(Kernel (&kinds)[kNumOperandKinds]) {
+    constexpr auto kVV = static_cast<size_t>(Operands::VectorVector);
+    constexpr auto kVS = static_cast<size_t>(Operands::VectorScalar);
+    constexpr auto kSV = static_cast<size_t>(Operands::ScalarVector);
+    if constexpr (kVector) {
+        kinds[kVV] = kKernelVariant<kFullTile, BinaryKernelImpl<T, Op, Operands::VectorVector>>;
+        kinds[kVS] = kKernelVariant<kFullTile, BinaryKernelImpl<T, Op, Operands::VectorScalar>>;
+        kinds[kSV] = kKernelVariant<kFullTile, BinaryKernelImpl<T, Op, Operands::ScalarVector>>;
+    } else {
+        kinds[kVV] = kKernelVariant<kFullTile, LaneBinaryKernelImpl<T, Out, Op, Operands::VectorVector>>;
+        kinds[kVS] = kKernelVariant<kFullTile, LaneBinaryKernelImpl<T, Out, Op, Operands::VectorScalar>>;
+        kinds[kSV] = kKernelVariant<kFullTile, LaneBinaryKernelImpl<T, Out, Op, Operands::ScalarVector>>;
+    }
+}
+
+template <class T, OpCode kOp, bool kFullTile, size_t... kActs>
+void SetEpilogues(Kernel (&epilogues)[kNumActivations][kNumOperandKinds], std::index_sequence<kActs...>) {
+    // Activation::None (0) is the plain op, filled by the caller
+    ((kActs == 0 ? void()
+                 : SetOperandKinds<T, T, FusedOp<T, kOp, static_cast<Activation>(kActs)>, false, kFullTile>(
+                       epilogues[kActs])),
+     ...);
+}
+
+template <class T, size_t... kMasks>
+void SetWhereKernels(TypedKernels& kernels, std::index_sequence<kMasks...>) {
+    ((kernels.where[kMasks] = WhereKernelImpl<T, kMasks>), ...);
+}
+
+template <class From, class Tag, size_t... kTo>
+void SetCastKernels(TypedKernels& kernels, std::index_sequence<kTo...>) {
+    ((kernels.cast[kTo] = CastKernelImpl<From, Codec<static_cast<DataType>(kTo), Tag>, Tag>), ...);
+}
+
+// Kernels of one opcode for elements of kType, computed through traits T. F is the ISA's
+// float traits, which tags the helpers that have no traits of their own.
+template <class T, class F, DataType kType, OpCode kOp>
+void SetKernels(TypedKernels& kernels) {
+    constexpr auto index = static_cast<size_t>(kOp);
+    if constexpr (!HasKernel(kOp, kType)) {
+        (void)kernels;
+    } else if constexpr (index <= static_cast<size_t>(OpCode::Div)) {
+        SetOperandKinds<T, T, ArithmeticOp<T, kOp>, true>(kernels.binary[index][0]);
+        SetOperandKinds<T, T, ArithmeticOp<T, kOp>, true, true>(kernels.tile_binary[index][0]);
+        if constexpr (HasEpilogue(kOp, kType)) {
+            SetEpilogues<T, kOp, false>(kernels.binary[index], std::make_index_sequence<kNumActivations>{});
+            SetEpilogues<T, kOp, true>(kernels.tile_binary[index], std::make_index_sequence<kNumActivations>{});
+        }
+    } else if constexpr (IsBinaryOp(kOp)) {
+        using Out = std::conditional_t<IsCompareOp(kOp), IntTraits<uint8_t, F>, T>;
+        SetOperandKinds<T, Out, BinaryLaneOp<T, kOp>, false>(kernels.binary[index][0]);
+    } else if constexpr (IsUnaryOp(kOp)) {
+        kernels.unary[index - kFirstUnaryOp] = LaneUnaryKernelImpl<T, UnaryOp<T, kOp>>;
+        kernels.tile_unary[index - kFirstUnaryOp] = FullTileKernel<LaneUnaryKernelImpl<T, UnaryOp<T, kOp>>>;
+    } else if constexpr (kOp == OpCode::Where) {
+        SetWhereKernels<T>(kernels, std::make_index_sequence<8>{});
+    } else if constexpr (kOp == OpCode::Cast) {
+        SetCastKernels<Codec<kType, F>, F>(kernels, std::make_index_sequence<kNumDataTypes>{});
+    }
+}
+
+template <class T, class F, DataType kType, size_t... kOps>
+TypedKernels MakeTypedKernels(std::index_sequence<kOps...>) {
+    TypedKernels kernels{};
+    (SetKernels<T, F, kType, static_cast<OpCode>(kOps)>(kernels), ...);
+    return kernels;
+}
+
+// Build the table for one ISA from its float and double traits. ISAs with native half
+// conversions pass their own Half traits.
+template <class Float, class Double, class Half = WidenedTraits<Float, HalfConvert<Float>>>
+KernelTable MakeKernelTable(Isa isa, const char* name) {
+    constexpr auto kOps = std::make_index_sequence<kNumOpCodes>{};
+    KernelTable table{};
+    table.isa = isa;
+    table.name = name;
+    table.types[static_cast<size_t>(DataType::Float)] = MakeTypedKernels<Float, Float, DataType::Float>(kOps);
+    table.types[static_cast<size_t>(DataType::Double)] = MakeTypedKernels<Double, Float, DataType::Double>(kOps);
+    table.types[static_cast<size_t>(DataType::Float16)] = MakeTypedKernels<Half, Float, DataType::Float16>(kOps);
+    table.types[static_cast<size_t>(DataType::BFloat16)] =
+        MakeTypedKernels<WidenedTraits<Float, BFloat16Convert<Float>>, Float, DataType::BFloat16>(kOps);
+    table.types[static_cast<size_t>(DataType::Int8)] =
+        MakeTypedKernels<IntTraits<int8_t, Float>, Float, DataType::Int8>(kOps);
+    table.types[static_cast<size_t>(DataType::Int32)] =
+        MakeTypedKernels<IntTraits<int32_t, Float>, Float, DataType::Int32>(kOps);
+    table.types[static_cast<size_t>(DataType::Int64)] =
+        MakeTypedKernels<IntTraits<int64_t, Float>, Float, DataType::Int64>(kOps);
+    table.types[static_cast<size_t>(DataType::Bool)] =
+        MakeTypedKernels<IntTraits<uint8_t, Float>, Float, DataType::Bool>(kOps);
+    table.row = MakeRowKernels<Float>();
+    table.gemm = MakeGemmKernels<Float>();
+    return table;
+}
@@ -0,0 +1,36 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// NUMA topology discovery, thread pinning and memory placement
+//
+// The topology is read once from /sys/devices/system/node on Linux. Elsewhere, or when the
+// kernel exposes no nodes, the whole machine is reported as node 0 with every CPU, and
+// pinning and placement calls do nothing.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct NumaNode {
+    int id;
+    std::vector<int> cpus;  // Logical CPU ids, ascending
+};
+
+// Nodes that have CPUs, ordered by id. Never empty.
+const std::vector<NumaNode>& GetNumaNodes();
+
+// The node with `id`, or nullptr
+const NumaNode* FindNumaNode(int id);
+
+// Parse a kernel CPU list such as "0-3,8,10-11". Returns false on malformed input.
+bool ParseCpuList(const std::string& list, std::vector<int>* cpus);
+
+// The inverse of ParseCpuList, with runs collapsed into ranges
+std::string FormatCpuList(const std::vector<int>& cpus);
+
+// Restrict the calling thread to `cpus`. Returns false if the OS refused or cannot pin.
+bool PinCurrentThread(const std::vector<int>& cpus);
+
+// Prefer `node` for the pages wholly inside [p, p + bytes), moving pages already touched.
+// Pages not yet touched are placed there on first touch, whichever thread touches them.
+void BindMemoryToNode(void* p, size_t bytes, int node);
@@ -0,0 +1,73 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Static registry of the ONNX ops the EP supports
+//
+// One table, built at compile time, describes every supported (domain, op_type): the schema
+// versions it is accepted at, how it lowers, which element types have kernels and how it
+// behaves in a partition. GetCapability, lowering and layout queries all read it, and lookups
+// go through a perfect hash computed with the table, so each is one hash and one compare.
+
+#pragma once
+
+#include "expr_program.h"
+
+#include <cstdint>
+
+// How an ONNX op lowers into instructions
+enum class OpForm : uint8_t {
+    Basic,     // One instruction over the node's inputs
+    Variadic,  // Two or more inputs folded left: Max(a, b, c) = Max(Max(a, b), c)
+    Clip,      // Max with the lower bound, then Min with the upper one; either may be absent
+    Bias,      // op(x + bias), as in com.microsoft BiasGelu and FastGelu (whose bias is optional)
+    Reduce,    // Row op over the axes attribute or a constant axes input; keepdims honoured
+    Softmax,   // Row op over the axis attribute: one dim from opset 13, the trailing dims before
+    LayerNorm, // Row op over the dims from axis on, then Mul by scale and an optional Add of bias
+    MatMul,    // Row op by a constant 2D weight; Gemm adds its optional bias C after
+};
+
+// How an op's inputs combine into its output shape
+enum class BroadcastRule : uint8_t {
+    None,              // One data input; the output has its shape
+    Multidirectional,  // NumPy-style over all inputs
+    Unidirectional,    // Other inputs broadcast to input 0, which has the output's shape
+    Reduction,         // The output is input 0 with the reduced dims removed or set to 1
+    Contraction,       // The output is input 0 with its last dim replaced by the weight's columns
+};
+
+// ============================================================================
+// OpDescriptor - What the EP knows about one ONNX op
+// ============================================================================
+struct OpDescriptor {
+    static constexpr int kLatest = 0x7FFFFFFF;
+
+    const char* domain;  // "" for ai.onnx
+    const char* op_type;
+
+    // Range of schema versions (the node's since-version) with the semantics lowered here
+    int min_version;
+    int max_version;
+
+    OpCode op;
+    OpForm form;
+
+    // Bit per DataType: element types of the data input with kernels (see HasKernel)
+    uint16_t types;
+
+    BroadcastRule broadcast;
+
+    // Whether the node may share a partition with its neighbours
+    bool fusable;
+
+    // Estimated cost per output element, in units of one Add
+    uint8_t cost;
+
+    constexpr bool SupportsVersion(int since_version) const {
+        return since_version >= min_version && since_version <= max_version;
+    }
+    constexpr bool SupportsType(DataType type) const {
+        return (types >> static_cast<unsigned>(type)) & 1u;
+    }
+};
+
+// Look up an op. "ai.onnx" and "" name the same domain. Returns nullptr if the EP does not
+// know the op at any version.
+const OpDescriptor* FindOp(const char* domain, const char* op_type);
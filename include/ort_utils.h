@@ -0,0 +1,85 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Small helpers shared by the Sample EP's use of the ONNX Runtime C API
+
+#pragma once
+
+#include <onnxruntime_c_api.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Helper macro to get containing object from member pointer (like container_of in Linux kernel)
+#define CONTAINER_OF(ptr, type, member) \
+    reinterpret_cast<type*>(reinterpret_cast<char*>(ptr) - offsetof(type, member))
+
+#define CONTAINER_OF_CONST(ptr, type, member) \
+    reinterpret_cast<const type*>(reinterpret_cast<const char*>(ptr) - offsetof(type, member))
+
+// Return early from an OrtStatus-returning function if expr fails
+#define RETURN_IF_ERROR(expr)                   \
+    do {                                        \
+        OrtStatus* _status = (expr);            \
+        if (_status != nullptr) return _status; \
+    } while (0)
+
+// Get the element type of a tensor value and a key describing its static shape.
+// shape_key is left empty when the shape is not fully known (e.g. unnamed dynamic dims),
+// and elem_type is UNDEFINED for non-tensor values.
+OrtStatus* GetValueTensorInfo(const OrtApi* api, const OrtValueInfo* value_info,
+                              ONNXTensorElementDataType* elem_type, std::string* shape_key);
+
+// Get the static dims of a tensor value, -1 for each dim not known as a constant. found is
+// false if the value is not a tensor. An unknown rank reads as no dims, like a scalar.
+OrtStatus* GetValueDims(const OrtApi* api, const OrtValueInfo* value_info,
+                        std::vector<int64_t>* dims, bool* found);
+
+// Get the element count and size in bytes of a tensor value with a static shape. Both are 0
+// when a dim is not a known constant, or the value is not a tensor of a fixed-size type.
+OrtStatus* GetStaticTensorSize(const OrtApi* api, const OrtValueInfo* value_info,
+                               size_t* elements, size_t* bytes);
+
+// Get the inputs or outputs of a node. Missing optional inputs are returned as nullptr.
+OrtStatus* GetNodeInputs(const OrtApi* api, const OrtNode* node,
+                         std::vector<const OrtValueInfo*>* inputs);
+OrtStatus* GetNodeOutputs(const OrtApi* api, const OrtNode* node,
+                          std::vector<const OrtValueInfo*>* outputs);
+
+// Get the nodes of a graph
+OrtStatus* GetGraphNodes(const OrtApi* api, const OrtGraph* graph,
+                         std::vector<const OrtNode*>* nodes);
+
+// Look up a node attribute by name. attr is nullptr if the node has no such attribute.
+OrtStatus* FindAttribute(const OrtApi* api, const OrtNode* node, const char* name,
+                         const OrtOpAttr** attr);
+
+// Read a string attribute of a node. found is false if the node has no such attribute.
+OrtStatus* GetStringAttribute(const OrtApi* api, const OrtNode* node, const char* name,
+                              std::string* value, bool* found);
+
+// Read an int, float or ints attribute of a node. found is false if the node has no such
+// attribute or it has another type.
+OrtStatus* GetIntAttribute(const OrtApi* api, const OrtNode* node, const char* name,
+                           int64_t* value, bool* found);
+OrtStatus* GetFloatAttribute(const OrtApi* api, const OrtNode* node, const char* name,
+                             float* value, bool* found);
+OrtStatus* GetIntsAttribute(const OrtApi* api, const OrtNode* node, const char* name,
+                            std::vector<int64_t>* values, bool* found);
+
+// Get the element type, dims and data of a constant initializer. data is nullptr, and the
+// rest unset, if the value is not one. The data stays owned by ORT.
+OrtStatus* GetInitializerTensor(const OrtApi* api, const OrtValueInfo* value_info,
+                                ONNXTensorElementDataType* elem_type, std::vector<int64_t>* dims,
+                                const void** data);
+
+// Read the values of a constant int64 initializer. found is false for any other value.
+OrtStatus* GetInitializerInts(const OrtApi* api, const OrtValueInfo* value_info,
+                              std::vector<int64_t>* values, bool* found);
+
+// Read the values and dims of a constant float initializer. found is false for any other value.
+OrtStatus* GetInitializerFloats(const OrtApi* api, const OrtValueInfo* value_info,
+                                std::vector<float>* values, std::vector<int64_t>* dims, bool* found);
+
+// The initializer of `graph` named `name`, or nullptr if it has none
+OrtStatus* FindGraphInitializer(const OrtApi* api, const OrtGraph* graph, const char* name,
+                                const OrtValueInfo** value_info);
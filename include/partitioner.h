@@ -0,0 +1,120 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Graph partitioning for the Sample EP
+//
+// The partitioner works on a compact, ORT-independent description of the graph so that the
+// grouping logic stays separate from the C API plumbing in GetCapabilityImpl.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// ============================================================================
+// PartitionGraph - What the partitioner needs to know about the graph's nodes
+//
+// One array per field, indexed by node, with every node's producer edges in one flat array,
+// so a graph of hundreds of thousands of nodes takes a handful of allocations that threads
+// describing disjoint nodes fill without locking. Flags are bytes for the same reason.
+// ============================================================================
+struct PartitionGraph {
+    // The nodes' producers, as begin/end pointers into `producers`
+    struct Producers {
+        const size_t* first;
+        const size_t* last;
+        const size_t* begin() const { return first; }
+        const size_t* end() const { return last; }
+    };
+
+    // Whether the EP can execute node i
+    std::vector<uint8_t> supported;
+
+    // Supported nodes are only fused with neighbours of the same shape class, so that every
+    // value inside a partition shares one iteration space, but for a row op's operand, which
+    // its prologue computes in the operand's. -1 means "never fuse".
+    std::vector<int64_t> shape_class;
+
+    // Reduces or normalizes over axes (see RowSpec). A partition holds at most one.
+    std::vector<uint8_t> row_op;
+
+    // In-graph node producing a row op's operand, or -1 (also for nodes that are not row ops)
+    std::vector<int64_t> operand_producer;
+
+    // In-graph nodes producing node i's inputs are producers[producer_begin[i], producer_begin[i + 1])
+    // (may contain duplicates). producer_begin has one entry more than there are nodes.
+    std::vector<size_t> producer_begin;
+    std::vector<size_t> producers;
+
+    // Cost model inputs, from static shapes. elements == 0 means they are not known.
+    std::vector<size_t> elements;      // Output elements
+    std::vector<size_t> input_bytes;   // Bytes read, summed over inputs
+    std::vector<size_t> output_bytes;  // Bytes written
+    std::vector<uint32_t> cost;        // Compute per element in units of one Add (OpDescriptor::cost)
+    std::vector<uint8_t> graph_output; // The output is read after the run
+
+    PartitionGraph() = default;
+    explicit PartitionGraph(size_t num_nodes) { Resize(num_nodes); }
+
+    // Size every array for num_nodes unsupported nodes without producers
+    void Resize(size_t num_nodes);
+
+    size_t size() const { return supported.size(); }
+    Producers ProducersOf(size_t i) const {
+        return {producers.data() + producer_begin[i], producers.data() + producer_begin[i + 1]};
+    }
+};
+
+// Group supported nodes into partitions, each of which becomes one fused node.
+//
+// Partitions are connected through producer/consumer edges and are convex: no path leaves a
+// partition and re-enters it through a node outside it, so fusing never creates a cycle.
+// The result is deterministic and lists node indices in topological order. A nonzero
+// max_nodes caps the size of each partition, and no partition holds two row ops. A row op
+// whose operand has another shape class than its result, like a reduction's, takes the
+// partition computing nothing but that operand as its prologue. With a pool, groups are split
+// into their components in parallel; the result is the same.
+std::vector<std::vector<size_t>> BuildPartitions(const PartitionGraph& graph, size_t max_nodes = 0,
+                                                 ThreadPool* pool = nullptr);
+
+// ============================================================================
+// CostModel - Estimated run time of a partition on this EP and on ORT's CPU EP
+//
+// Each side pays a fixed cost per kernel call, streams what each kernel reads and writes, and
+// spends compute on ops heavier than an Add (an Add's own work is part of its streaming rate).
+// The EP makes one call per partition and only streams values crossing its boundary; the CPU
+// EP makes one per node and streams every intermediate. The defaults are rough figures for a
+// current x86 core; `bench_sample_ep --calibrate` measures a host and prints a spec for the
+// `cost_model` EP option.
+// ============================================================================
+struct CostModel {
+    double ep_call_ns = 2500;
+    double ep_bytes_per_ns = 16;
+    double ep_ns_per_op = 0.03;  // Per element and unit of cost above 1
+    double cpu_node_ns = 700;
+    double cpu_bytes_per_ns = 12;
+    double cpu_ns_per_op = 0.08;
+
+    // Set fields from "name=value,..." using the field names above. Returns false on an
+    // unknown name or a value that is not a positive number.
+    bool Parse(const std::string& spec);
+
+    // The spec Parse accepts for the current values
+    std::string ToString() const;
+};
+
+struct PartitionEstimate {
+    bool known = false;         // Every node has static shapes; otherwise the partition is claimed
+    size_t boundary_bytes = 0;  // Bytes of partition inputs and outputs
+    double ep_ns = 0;
+    double cpu_ns = 0;
+
+    bool Profitable() const { return !known || ep_ns < cpu_ns; }
+};
+
+// Estimate each partition of BuildPartitions' result
+std::vector<PartitionEstimate> EstimatePartitions(const PartitionGraph& graph,
+                                                  const std::vector<std::vector<size_t>>& partitions,
+                                                  const CostModel& model);
@@ -0,0 +1,117 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Opt-in per-partition profiler, flushed as Chrome trace events
+//
+// Compute calls record one sample each into a ring buffer owned by the calling thread, so the
+// hot path takes no locks and shares no cache lines with other threads. OnRunEnd drains every
+// buffer and appends the samples to a trace file in the Chrome trace event format (the format
+// ORT's own profiler writes), which chrome://tracing and Perfetto open directly. Profiling can
+// be switched on and off at any time; while it is off the only cost is one relaxed load per call.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// Profiler - Per-thread sample rings and the trace file they drain into
+// ============================================================================
+class Profiler {
+public:
+    // Read the cycle counter (TSC on x86, the virtual counter on AArch64)
+    static uint64_t Now();
+
+    // The trace file is created on the first flush
+    explicit Profiler(std::string path);
+    ~Profiler();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    // Register a fused partition; the returned id is passed to RecordCompute.
+    // `kernel` names the kernel variant, e.g. "avx2/float".
+    uint32_t RegisterNode(const std::string& name, const std::string& kernel);
+
+    // Record one Compute call of a registered partition on the calling thread
+    void RecordCompute(uint32_t node, uint64_t start, uint64_t end, uint64_t bytes,
+                       uint32_t chunks, bool plan_built);
+
+    // Mark the start and end of a session run on the calling thread
+    void RecordRunStart();
+    void RecordRunEnd();
+
+    // Write all recorded samples to the trace file. Returns false if this call failed to
+    // create the file; samples are then discarded and later calls return true.
+    bool Flush();
+
+    const std::string& Path() const { return path_; }
+
+    // Callers only record samples while this is set
+    bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+    void SetEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+
+private:
+    static constexpr uint32_t kRunNode = UINT32_MAX;
+    static constexpr size_t kRingCapacity = 4096;  // Samples per thread, a power of two
+
+    // Fields are relaxed atomics so a flush may read a slot while its owner overwrites it;
+    // such slots are detected by re-reading the head and dropped
+    struct Sample {
+        std::atomic<uint64_t> start{0};
+        std::atomic<uint64_t> end{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint32_t> node{0};
+        std::atomic<uint32_t> chunks{0};
+        std::atomic<uint32_t> plan_built{0};
+    };
+
+    // Single-producer ring owned by one thread; drained by Flush
+    struct Ring {
+        Ring(uint32_t tid, std::thread::id owner)
+            : tid(tid), owner(owner), samples(new Sample[kRingCapacity]) {}
+
+        const uint32_t tid;  // Trace thread id
+        const std::thread::id owner;
+        std::unique_ptr<Sample[]> samples;
+        alignas(64) std::atomic<uint64_t> head{0};  // Samples ever written
+        uint64_t tail = 0;                          // Samples ever drained, under flush_mutex_
+        uint64_t run_start = 0;                     // Written by the owning thread only
+    };
+
+    struct NodeInfo {
+        std::string name;
+        std::string kernel;
+    };
+
+    Ring* ThreadRing();
+    void Push(Ring* ring, uint32_t node, uint64_t start, uint64_t end, uint64_t bytes,
+              uint32_t chunks, bool plan_built);
+
+    std::atomic<bool> enabled_{false};
+
+    const uint64_t id_;  // Unique per instance, so thread-local ring caches never go stale
+    const std::string path_;
+
+    // Cycle counter and steady clock read together at construction, for converting
+    // counter ticks to trace microseconds
+    const uint64_t base_ticks_;
+    const std::chrono::steady_clock::time_point base_time_;
+
+    std::mutex rings_mutex_;  // Guards rings_ and nodes_
+    std::vector<std::unique_ptr<Ring>> rings_;
+    std::vector<NodeInfo> nodes_;
+
+    std::mutex flush_mutex_;  // Guards the file and every Ring::tail
+    std::FILE* file_ = nullptr;
+    bool failed_ = false;
+    bool first_event_ = true;
+    uint64_t dropped_ = 0;  // Samples overwritten before they were flushed
+    uint64_t reported_dropped_ = 0;
+};
@@ -0,0 +1,70 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// On-disk cache of compiled partitions, memory-mapped and shared by every process on a host
+//
+// With the "program_cache_dir" EP option set, CompileImpl hashes each fused subgraph (its
+// nodes, their wiring, the partition's input types and shapes) together with the kernel ISA,
+// and looks the hash up in <dir>/sample_ep_programs.bin before lowering the subgraph. The file
+// is a flat, offset-based table mapped read-only, so all workers share its pages. Misses are
+// compiled and written back by replacing the file atomically, so readers never see a partial
+// file and keep their existing mapping until they reopen it.
+
+#pragma once
+
+#include "expr_program.h"
+#include "kernels.h"
+
+#include <onnxruntime_c_api.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Hash of a fused subgraph and the kernel table it will run with, used as the cache key
+OrtStatus* HashFusedGraph(const OrtApi* api, const OrtGraph* graph, const OrtNode* fused_node,
+                          const KernelTable& kernels, uint64_t* key);
+
+// ============================================================================
+// ProgramCache - Read-only mapping of the cache file plus entries to add to it
+// ============================================================================
+class ProgramCache {
+public:
+    static constexpr const char* kFileName = "sample_ep_programs.bin";
+
+    // Map <dir>/sample_ep_programs.bin. A missing or malformed file is treated as empty.
+    explicit ProgramCache(std::string dir);
+    ~ProgramCache();
+
+    ProgramCache(const ProgramCache&) = delete;
+    ProgramCache& operator=(const ProgramCache&) = delete;
+
+    // Look up a program by key. Returns false on a miss or if the stored entry is invalid.
+    bool Find(uint64_t key, ExprProgram* program) const;
+
+    // Queue a compiled program to be written by the next Commit
+    void Add(uint64_t key, const ExprProgram& program);
+
+    // Merge queued programs into the file on disk and remap it. Returns false if the file
+    // could not be written; the queued programs are dropped either way.
+    bool Commit();
+
+private:
+    // A mapped (or, where mmap is unavailable, loaded) cache file
+    struct Mapping {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        std::vector<uint8_t> buffer;  // Backing storage when not memory-mapped
+        bool mapped = false;
+    };
+
+    static void Open(const std::string& path, Mapping* mapping);
+    static void Close(Mapping* mapping);
+
+    // Entry payload for `key` in `mapping`, or {nullptr, 0}
+    static std::pair<const uint8_t*, size_t> Lookup(const Mapping& mapping, uint64_t key);
+
+    const std::string path_;
+    Mapping mapping_;
+    std::vector<std::pair<uint64_t, std::vector<uint8_t>>> pending_;
+};
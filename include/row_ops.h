@@ -0,0 +1,97 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Row ops: reductions, normalizations and MatMul fused with the elementwise code around them
+//
+// A program with a row instruction runs in three stages over a group of rows at a time: a
+// prologue computes the row op's operand into a per-thread buffer, the row kernel reduces or
+// normalizes it, and an epilogue applies the elementwise code that follows. Both are ordinary
+// ExprPrograms carved out of the partition's, so a pattern like Gelu(LayerNorm(x + r) * g)
+// makes one pass over memory with the rows in flight staying in cache.
+//
+// MatMul is a row op too: each row of its operand is multiplied by a constant weight, which is
+// packed into the kernels' panel layout once per session rather than per call.
+//
+// Reductions of a few long rows cannot be split by row. They split each row into blocks
+// instead, reduce the blocks in parallel and combine the partial results pairwise in a fixed
+// order, so with deterministic reductions the result does not depend on the thread count.
+
+#pragma once
+
+#include "execution_plan.h"
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// PackedWeight - A MatMul weight in GemmKernels' panel layout
+// ============================================================================
+struct PackedWeight {
+    size_t k = 0;
+    size_t n = 0;
+    std::vector<float> panels;
+
+    // Pack b, [k, n] or [n, k] when transposed, with `kernels`' panel width
+    void Pack(const GemmKernels& kernels, const float* b, size_t k_dim, size_t n_dim, bool transposed);
+};
+
+// ============================================================================
+// RowPlan - How a program with a row instruction runs for one set of input shapes
+// ============================================================================
+struct RowPlan {
+    OpCode op = OpCode::ReduceSum;
+    float epsilon = 0;
+
+    // The operand viewed as [outer, n, inner], and the elements of operand and result per
+    // outer index: n * inner for both, inner for the result of a reduction and `columns` for
+    // the result of a MatMul
+    size_t outer = 1;
+    size_t n = 1;
+    size_t inner = 1;
+    size_t operand_slab = 1;
+    size_t result_slab = 1;
+    size_t columns = 0;
+
+    // The operand is computed by `prologue` from the partition inputs in prologue_inputs, or,
+    // when the prologue has no code, read from partition input operand_input
+    ExprProgram prologue;
+    std::vector<uint32_t> prologue_inputs;
+    ExecutionPlan prologue_plan;
+    uint32_t operand_input = 0;
+
+    // Partition output the row op writes, or -1 when only the epilogue reads its result
+    int64_t result_output = -1;
+
+    // Computes the other partition outputs, listed in epilogue_outputs, from the partition
+    // inputs in epilogue_inputs followed by the row result as its last input. Empty when
+    // the row op computes the only output.
+    ExprProgram epilogue;
+    std::vector<uint32_t> epilogue_inputs;
+    std::vector<uint32_t> epilogue_outputs;
+    ExecutionPlan epilogue_plan;
+
+    // Work split: outer indices per chunk
+    size_t rows_per_chunk = 1;
+    size_t num_chunks = 1;
+
+    // Reductions split along n instead: reduced rows per block, 0 when rows run in parallel
+    size_t reduce_block = 0;
+
+    // MatMuls over too few rows split their columns instead: weight panels per block, 0 when
+    // rows run in parallel
+    size_t column_block = 0;
+
+    // Scratch for the sub-plans' replicated inputs
+    size_t replicated_bytes = 0;
+};
+
+// Fill in plan->row for a program with a row instruction, for BuildExecutionPlan
+PlanStatus BuildRowPlan(const ExprProgram& program, const KernelTable& kernels,
+                        const ShapeRef* shapes, const PlanOptions& options, ExecutionPlan* plan);
+
+// Run a plan built by BuildRowPlan over all of its rows. Without `deterministic`, split
+// reductions use one block per thread, so their rounding depends on the thread count.
+// `weight` is the packed weight of a MatMul program and ignored otherwise.
+void RunRowPlan(const ExecutionPlan& plan, const KernelTable& kernels, ThreadPool* pool,
+                bool deterministic, const PackedWeight* weight, const void* const* inputs,
+                void* const* outputs, std::vector<char>* replicated);
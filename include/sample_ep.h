@@ -7,9 +7,22 @@
 
 #include <onnxruntime_c_api.h>
 
+#include "constant_folding.h"
+#include "ep_options.h"
+#include "expr_program.h"
+#include "kernels.h"
+#include "profiler.h"
+#include "program_cache.h"
+#include "stream.h"
+#include "thread_pool.h"
+
+#include <chrono>
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
+
+struct PackedWeight;
 
 // Forward declarations
 class SampleEpFactory;
@@ -45,6 +58,21 @@ public:
     const ApiPtrs& GetApis() const { return apis_; }
     const std::string& GetEpName() const { return ep_name_; }
 
+    // Kernels for the best instruction set on this machine, chosen at construction
+    const KernelTable& GetKernels() const { return *kernels_; }
+
+    // Memory served by PoolAllocator, registered on every EP device. Null if it could not
+    // be created, in which case ORT's default CPU allocator is used.
+    const OrtMemoryInfo* GetMemoryInfo() const { return memory_info_; }
+
+    // Every stream created through the factory or its EPs
+    const std::shared_ptr<StreamSet>& GetStreams() const { return streams_; }
+
+    // Create a PoolAllocator for `memory_info` if it is ours. Sets nullptr for other memory,
+    // which leaves it to ORT's default allocator.
+    OrtStatus* CreatePoolAllocator(const OrtMemoryInfo* memory_info, const PoolAllocatorOptions& options,
+                                   OrtAllocator** allocator);
+
     // Helper to get SampleEpFactory from OrtEpFactory pointer
     static SampleEpFactory* FromOrt(OrtEpFactory* ort_factory);
     static const SampleEpFactory* FromOrt(const OrtEpFactory* ort_factory);
@@ -107,6 +135,9 @@ private:
     OrtEpFactory factory_;  // The actual OrtEpFactory struct
     std::string ep_name_;
     ApiPtrs apis_;
+    const KernelTable* kernels_;
+    OrtMemoryInfo* memory_info_ = nullptr;
+    std::shared_ptr<StreamSet> streams_ = std::make_shared<StreamSet>();
 };
 
 // ============================================================================
@@ -115,7 +146,8 @@ private:
 // ============================================================================
 class SampleEp {
 public:
-    SampleEp(SampleEpFactory* factory, const OrtLogger* session_logger);
+    SampleEp(SampleEpFactory* factory, const OrtLogger* session_logger,
+             const SampleEpOptions& options, const KernelTable& kernels);
     ~SampleEp();
 
     // Get the OrtEp struct to return to ORT
@@ -123,6 +155,14 @@ public:
 
     SampleEpFactory* GetFactory() const { return factory_; }
     const ApiPtrs& GetApis() const { return factory_->GetApis(); }
+    const SampleEpOptions& GetOptions() const { return options_; }
+    ThreadPool* GetThreadPool() const { return thread_pool_.get(); }
+
+    // Kernels for the factory's instruction set, or the one forced by the isa option
+    const KernelTable& GetKernels() const { return *kernels_; }
+
+    // Null while profiling is disabled
+    Profiler* GetProfiler() const { return profiler_->Enabled() ? profiler_.get() : nullptr; }
 
     // Helper to get SampleEp from OrtEp pointer
     static SampleEp* FromOrt(OrtEp* ort_ep);
@@ -182,15 +222,27 @@ private:
     OrtEp ep_;  // The actual OrtEp struct
     SampleEpFactory* factory_;
     const OrtLogger* session_logger_;
+    SampleEpOptions options_;
+    const KernelTable* kernels_;
+    std::unique_ptr<ThreadPool> thread_pool_;  // Shared by all partitions of the session
+    std::unique_ptr<Profiler> profiler_;       // Records only while enable_profiling is set
+    std::unique_ptr<ProgramCache> program_cache_;  // Null unless program_cache_dir is set
+    std::shared_ptr<StreamSet> streams_;       // Streams ORT created through this EP, also in the factory's
+    std::string compatibility_info_;           // Stored in models compiled by this EP
 };
 
 // ============================================================================
 // SampleNodeComputeInfo - Implements computation for fused nodes
 // Uses composition to wrap OrtNodeComputeInfo
+//
+// Every field is set by CompileImpl and only read afterwards, so any number of threads may
+// run the node at once. The packed MatMul weight is the exception, built once by the first
+// CreateStateImpl. Mutable per-call data lives in thread-local scratch, and plans in the
+// compute state's lock-free PlanCache. Calls queued on a stream own copies of their data.
 // ============================================================================
 class SampleNodeComputeInfo {
 public:
-    SampleNodeComputeInfo(const ApiPtrs& apis);
+    SampleNodeComputeInfo(const ApiPtrs& apis, const KernelTable& kernels);
 
     OrtNodeComputeInfo* GetOrtComputeInfo() { return &compute_info_; }
 
@@ -198,6 +250,39 @@ public:
 
     const OrtApi* ort_api;
     const OrtEpApi* ep_api;
+    const KernelTable& kernels;
+
+    // Compiled partition, filled in by SampleEp::CompileImpl. Its inputs are the fused node's,
+    // then one per folded constant, whose values `constants` holds in order.
+    ExprProgram program;
+    std::vector<ConstantTensor> constants;
+
+    // Large partitions are split into chunks across this pool
+    ThreadPool* thread_pool = nullptr;
+    size_t parallel_threshold = 0;
+    size_t specialize_after = 0;
+
+    // Small calls wait up to this long to be coalesced with concurrent ones (see CallBatcher).
+    // 0 = off.
+    std::chrono::microseconds batch_window{0};
+    bool deterministic_reductions = true;
+
+    // Queue calls on ORT's stream when every buffer they touch is in memory named
+    // pool_memory_name, whose blocks PoolAllocator can keep alive until the call has run
+    bool stream_execution = false;
+    std::string pool_memory_name;
+
+    // Set when profiling is enabled; profile_id identifies this partition to the profiler
+    Profiler* profiler = nullptr;
+    uint32_t profile_id = 0;
+
+    // MatMul partitions: the constant weight as stored in the model, dropped once packed
+    std::vector<float> weight;
+    std::vector<int64_t> weight_dims;
+
+    // The weight in the kernels' panel layout, packed on the first call and shared by every
+    // compute state. Null, with the error in *status, if there is no weight to pack.
+    std::shared_ptr<const PackedWeight> GetPackedWeight(OrtStatus** status);
 
 private:
     static OrtStatus* ORT_API_CALL CreateStateImpl(
@@ -215,4 +300,7 @@ private:
         void* compute_state) noexcept;
 
     OrtNodeComputeInfo compute_info_;  // The actual OrtNodeComputeInfo struct
+
+    std::once_flag pack_once_;
+    std::shared_ptr<const PackedWeight> packed_weight_;
 };
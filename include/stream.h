@@ -0,0 +1,109 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// CPU sync streams: an in-order task queue behind each OrtSyncStreamImpl
+//
+// ORT creates a stream per device in a session's execution plan and hands its handle to the
+// kernels it launches there. Compute enqueues its partition on the stream and returns, so
+// ORT's thread moves on to other EPs' nodes while the stream's own thread runs the work.
+// Tasks on one stream run in submission order. Notifications mark a point in that order for
+// consumers on other streams or on the host to wait for.
+
+#pragma once
+
+#include <onnxruntime_c_api.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class CpuStream;
+
+// ============================================================================
+// StreamSet - The streams created for one EP, so OnRunEnd can wait for all of them
+// ============================================================================
+class StreamSet {
+public:
+    // Streams added to the set are added to `parent` as well, if there is one
+    explicit StreamSet(std::shared_ptr<StreamSet> parent = nullptr) : parent_(std::move(parent)) {}
+
+    void Add(CpuStream* stream);
+    void Remove(CpuStream* stream);
+
+    // Wait until every task submitted to the set's streams so far has run
+    void DrainAll();
+
+private:
+    const std::shared_ptr<StreamSet> parent_;
+    std::mutex mutex_;
+    std::vector<CpuStream*> streams_;
+};
+
+// ============================================================================
+// CpuStream - One ORT sync stream
+// Uses composition to wrap OrtSyncStreamImpl
+// ============================================================================
+class CpuStream {
+public:
+    using Task = std::function<void()>;
+
+    // The stream is listed in `set`, if given, while it lives
+    CpuStream(const OrtEpApi* ep_api, std::shared_ptr<StreamSet> set);
+
+    // Runs the tasks still queued, then joins the worker
+    ~CpuStream();
+
+    CpuStream(const CpuStream&) = delete;
+    CpuStream& operator=(const CpuStream&) = delete;
+
+    OrtSyncStreamImpl* GetOrtStream() { return &stream_; }
+
+    static CpuStream* FromOrt(OrtSyncStreamImpl* ort_stream);
+
+    // The stream behind KernelContext_GetGPUComputeStream's handle, or nullptr
+    static CpuStream* FromHandle(void* handle) { return static_cast<CpuStream*>(handle); }
+
+    // The CpuStream behind an ORT stream, or nullptr for a null stream or another EP's
+    static CpuStream* FromOrtStream(const OrtEpApi* ep_api, OrtSyncStream* stream);
+
+    // Queue `task` after everything submitted so far. Returns its ticket; tickets count up
+    // from 1. The worker thread starts on the first call.
+    uint64_t Enqueue(Task task);
+
+    // Ticket of the last task submitted, 0 if none
+    uint64_t Submitted();
+
+    // Block until the task with `ticket` and everything before it has run
+    void WaitFor(uint64_t ticket);
+
+    void Drain() { WaitFor(Submitted()); }
+
+private:
+    static void ORT_API_CALL ReleaseImpl(OrtSyncStreamImpl* this_ptr) noexcept;
+    static void* ORT_API_CALL GetHandleImpl(OrtSyncStreamImpl* this_ptr) noexcept;
+    static OrtStatus* ORT_API_CALL CreateNotificationImpl(OrtSyncStreamImpl* this_ptr,
+                                                          OrtSyncNotificationImpl** notification) noexcept;
+    static OrtStatus* ORT_API_CALL FlushImpl(OrtSyncStreamImpl* this_ptr) noexcept;
+    static OrtStatus* ORT_API_CALL OnSessionRunEndImpl(OrtSyncStreamImpl* this_ptr) noexcept;
+
+    void WorkerLoop();
+
+    friend struct CpuNotification;
+
+    OrtSyncStreamImpl stream_;  // The actual OrtSyncStreamImpl struct
+    const OrtEpApi* ep_api_;
+    std::shared_ptr<StreamSet> set_;
+
+    std::mutex mutex_;
+    std::condition_variable work_cv_;  // Signalled when a task is queued or on shutdown
+    std::condition_variable done_cv_;  // Signalled when a task completes
+    std::deque<Task> queue_;
+    uint64_t submitted_ = 0;
+    uint64_t completed_ = 0;
+    bool stop_ = false;
+    std::thread worker_;
+};
@@ -0,0 +1,92 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Thread pool used by the Sample EP for intra-op parallelism
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Scheduling priority of the pool's worker threads. The calling thread is never changed.
+enum class ThreadPriority : uint8_t {
+    Normal,  // Same as the thread that created the pool
+    Low,     // Below normal, so the workers yield the cores to other work on the machine
+};
+
+// ============================================================================
+// ThreadPool - Persistent workers running chunked parallel loops
+//
+// ParallelFor splits [0, num_chunks) into one contiguous range per participant (the calling
+// thread plus the workers). Each participant claims chunks from the front of its own range
+// with an atomic increment, then steals from the other ranges the same way, so uneven chunks
+// balance out without any locking per chunk.
+//
+// One loop runs on the pool at a time. If another caller already owns the pool, the loop
+// runs inline on the calling thread instead of waiting.
+//
+// Reconfigure replaces the workers between loops, so the thread count and priority can change
+// while sessions keep running. Workers can be pinned to a set of CPUs, e.g. one NUMA node's.
+// ============================================================================
+class ThreadPool {
+public:
+    using ChunkFn = void (*)(void* context, size_t chunk);
+
+    // num_threads counts the calling thread, so 1 means no workers are started. A non-empty
+    // `cpus` restricts the workers to those CPUs.
+    explicit ThreadPool(size_t num_threads, ThreadPriority priority = ThreadPriority::Normal,
+                        std::vector<int> cpus = {});
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t NumThreads() const { return num_threads_.load(std::memory_order_relaxed); }
+    ThreadPriority Priority() const { return priority_; }
+
+    // Wait for the loop in flight, if any, then restart the workers with the new settings.
+    // Loops started meanwhile run inline on their calling thread.
+    void Reconfigure(size_t num_threads, ThreadPriority priority);
+
+    // Call fn(context, chunk) for every chunk in [0, num_chunks) and wait for all of them
+    void ParallelFor(size_t num_chunks, ChunkFn fn, void* context);
+
+    template <class F>
+    void ParallelFor(size_t num_chunks, F& f) {
+        ParallelFor(num_chunks, [](void* ctx, size_t chunk) { (*static_cast<F*>(ctx))(chunk); }, &f);
+    }
+
+private:
+    // Chunk range owned by one participant, padded to avoid false sharing
+    struct alignas(64) Range {
+        std::atomic<size_t> next{0};
+        size_t end = 0;
+    };
+
+    void StartWorkers(size_t num_threads);
+    void StopWorkers();
+    void WorkerLoop(size_t index, uint64_t seen);
+    void RunChunks(size_t self);
+
+    std::vector<std::thread> workers_;
+    std::unique_ptr<Range[]> ranges_;
+    std::atomic<size_t> num_threads_{1};  // Read without the lock when sizing work
+    ThreadPriority priority_;
+    const std::vector<int> cpus_;
+
+    std::mutex submit_mutex_;  // Held by the caller that owns the pool
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    uint64_t generation_ = 0;  // Bumped for every loop posted to the workers
+    bool stop_ = false;
+
+    // Current loop, valid while a generation is in flight
+    ChunkFn fn_ = nullptr;
+    void* context_ = nullptr;
+    std::atomic<size_t> active_workers_{0};
+};
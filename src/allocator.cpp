@@ -0,0 +1,380 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Pooled, aligned CPU allocator handed to ORT through OrtEpFactory::CreateAllocator
+
+#include "allocator.h"
+#include "counters.h"
+#include "numa.h"
+#include "ort_utils.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+// Precedes every block; its size keeps the payload 64-byte aligned
+struct alignas(PoolAllocator::kAlignment) PoolAllocator::BlockHeader {
+    BlockHeader* next;    // Free list link
+    size_t bytes;         // Whole block, including this header
+    uint32_t size_class;  // kDirect for blocks owned by the system allocator
+    bool from_arena;
+    std::atomic<uint32_t> refs;  // ORT's reference plus one per Retain; 0 while pooled
+    PoolAllocator* owner;
+    uintptr_t check;  // Address of the header mixed with kBlockMagic; identifies a block start
+};
+
+namespace {
+
+constexpr size_t kNumShards = 8;
+constexpr size_t kMaxClassBytes = size_t(64) << 20;
+constexpr uint32_t kDirect = UINT32_MAX;
+constexpr size_t kArenaBytes = size_t(64) << 20;
+constexpr size_t kMaxArenaBlockBytes = kArenaBytes / 8;  // Bounds the space lost at an arena's end
+constexpr size_t kHugePageBytes = size_t(2) << 20;
+constexpr uintptr_t kBlockMagic = static_cast<uintptr_t>(0x5A3C96E1D2B4F087ull);
+
+// Size classes: 64, 128, 192, 256, then four per power of two (320, 384, 448, 512, 640, ...)
+size_t ClassSize(size_t size_class) {
+    if (size_class < 4) return (size_class + 1) * 64;
+    const size_t power = (size_class - 4) / 4;
+    const size_t quarter = (size_class - 4) % 4;
+    return (size_t(256) << power) * (5 + quarter) / 4;
+}
+
+size_t ClassOf(size_t size) {
+    if (size <= 256) return size == 0 ? 0 : (size - 1) / 64;
+    size_t base = 256;  // Largest power of two below size
+    size_t power = 0;
+    while (base * 2 < size) {
+        base *= 2;
+        ++power;
+    }
+    const size_t quarters = (size * 4 + base - 1) / base;  // In (4, 8]
+    return 4 + 4 * power + (quarters - 5);
+}
+
+const size_t kNumClasses = ClassOf(kMaxClassBytes) + 1;
+
+// Shard used by the calling thread, assigned round-robin on first use
+size_t ThreadShard() {
+    static std::atomic<size_t> next_shard{0};
+    thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kNumShards;
+    return shard;
+}
+
+void* SystemAlloc(size_t bytes) {
+#if defined(_WIN32)
+    return _aligned_malloc(bytes, PoolAllocator::kAlignment);
+#else
+    return std::aligned_alloc(PoolAllocator::kAlignment, bytes);  // bytes is a multiple of 64
+#endif
+}
+
+void SystemFree(void* p) {
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+size_t RoundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+void UpdateMax(std::atomic<size_t>& max, size_t value) {
+    size_t current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace
+
+OrtStatus* ParseAllocatorOptions(const OrtApi* api, const OrtKeyValuePairs* options_kvps,
+                                 PoolAllocatorOptions* options) {
+    if (options_kvps == nullptr) return nullptr;
+
+    if (const char* value = api->GetKeyValue(options_kvps, "huge_pages")) {
+        if (std::strcmp(value, "0") != 0 && std::strcmp(value, "1") != 0) {
+            std::string msg = std::string("Invalid value for allocator option 'huge_pages': ") + value;
+            return api->CreateStatus(ORT_INVALID_ARGUMENT, msg.c_str());
+        }
+        options->huge_pages = value[0] == '1';
+    }
+
+    if (const char* value = api->GetKeyValue(options_kvps, "max_cached_bytes")) {
+        errno = 0;
+        char* end = nullptr;
+        unsigned long long parsed = std::strtoull(value, &end, 10);
+        if (value[0] == '\0' || value[0] == '-' || *end != '\0' || errno != 0) {
+            std::string msg = std::string("Invalid value for allocator option 'max_cached_bytes': ") + value;
+            return api->CreateStatus(ORT_INVALID_ARGUMENT, msg.c_str());
+        }
+        options->max_cached_bytes = static_cast<size_t>(parsed);
+    }
+
+    if (const char* value = api->GetKeyValue(options_kvps, "numa_node")) {
+        char* end = nullptr;
+        const long node = std::strtol(value, &end, 10);
+        if (value[0] == '\0' || *end != '\0' || FindNumaNode(static_cast<int>(node)) == nullptr) {
+            std::string msg = std::string("Invalid value for allocator option 'numa_node': ") + value;
+            return api->CreateStatus(ORT_INVALID_ARGUMENT, msg.c_str());
+        }
+        options->numa_node = static_cast<int>(node);
+    }
+
+    return nullptr;
+}
+
+// ============================================================================
+// PoolAllocator Implementation
+// ============================================================================
+
+PoolAllocator* PoolAllocator::FromOrt(OrtAllocator* ort_allocator) {
+    return CONTAINER_OF(ort_allocator, PoolAllocator, allocator_);
+}
+
+const PoolAllocator* PoolAllocator::FromOrt(const OrtAllocator* ort_allocator) {
+    return CONTAINER_OF_CONST(ort_allocator, PoolAllocator, allocator_);
+}
+
+PoolAllocator::PoolAllocator(const OrtApi* api, const OrtMemoryInfo* memory_info,
+                             const PoolAllocatorOptions& options)
+    : api_(api), memory_info_(memory_info), options_(options), shards_(kNumShards) {
+    std::memset(&allocator_, 0, sizeof(allocator_));
+    allocator_.version = ORT_API_VERSION;
+    allocator_.Alloc = AllocImpl;
+    allocator_.Free = FreeImpl;
+    allocator_.Info = InfoImpl;
+    allocator_.Reserve = ReserveImpl;
+    allocator_.GetStats = GetStatsImpl;
+
+    for (Shard& shard : shards_) {
+        shard.free_lists.assign(kNumClasses, nullptr);
+    }
+}
+
+PoolAllocator::~PoolAllocator() {
+    CountSub(Counter::PoolBytesCached, cached_.load(std::memory_order_relaxed));
+    for (Shard& shard : shards_) {
+        for (BlockHeader* head : shard.free_lists) {
+            while (head != nullptr) {
+                BlockHeader* next = head->next;
+                ReleaseBlock(head);
+                head = next;
+            }
+        }
+    }
+
+#if defined(__linux__)
+    for (const Arena& arena : arenas_) {
+        munmap(arena.base, arena.size);
+    }
+#endif
+}
+
+void* PoolAllocator::Allocate(size_t size) {
+    if (size > kMaxClassBytes) return Reserve(size);
+
+    const size_t size_class = ClassOf(size);
+
+    // Reuse a free block, preferring this thread's shard
+    const size_t home = ThreadShard();
+    for (size_t s = 0; s < kNumShards; ++s) {
+        Shard& shard = shards_[(home + s) % kNumShards];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        BlockHeader* block = shard.free_lists[size_class];
+        if (block != nullptr) {
+            shard.free_lists[size_class] = block->next;
+            cached_.fetch_sub(block->bytes, std::memory_order_relaxed);
+            CountSub(Counter::PoolBytesCached, block->bytes);
+            return TrackAllocation(block, size);
+        }
+    }
+
+    BlockHeader* block = NewBlock(size_class, sizeof(BlockHeader) + ClassSize(size_class));
+    return block ? TrackAllocation(block, size) : nullptr;
+}
+
+void* PoolAllocator::Reserve(size_t size) {
+    if (size > SIZE_MAX - sizeof(BlockHeader) - kAlignment) return nullptr;
+    BlockHeader* block = NewBlock(kDirect, RoundUp(sizeof(BlockHeader) + size, kAlignment));
+    if (block == nullptr) return nullptr;
+    num_reserves_.fetch_add(1, std::memory_order_relaxed);
+    return TrackAllocation(block, size);
+}
+
+void PoolAllocator::Free(void* p) {
+    if (p == nullptr) return;
+
+    BlockHeader* block = static_cast<BlockHeader*>(p) - 1;
+    if (block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) Recycle(block);
+}
+
+bool PoolAllocator::Retain(void* p) {
+    BlockHeader* block = static_cast<BlockHeader*>(p) - 1;
+    if (block->check != (reinterpret_cast<uintptr_t>(block) ^ kBlockMagic)) return false;
+    block->refs.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void PoolAllocator::Unretain(void* p) {
+    BlockHeader* block = static_cast<BlockHeader*>(p) - 1;
+    if (block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) block->owner->Recycle(block);
+}
+
+void PoolAllocator::Recycle(BlockHeader* block) {
+    in_use_.fetch_sub(block->bytes, std::memory_order_relaxed);
+    CountSub(Counter::PoolBytesInUse, block->bytes);
+
+    // Arena blocks are always kept, since arenas are only unmapped as a whole
+    const bool keep = block->size_class != kDirect &&
+                      (block->from_arena ||
+                       cached_.load(std::memory_order_relaxed) + block->bytes <= options_.max_cached_bytes);
+    if (!keep) {
+        ReleaseBlock(block);
+        return;
+    }
+
+    Shard& shard = shards_[ThreadShard()];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    block->next = shard.free_lists[block->size_class];
+    shard.free_lists[block->size_class] = block;
+    cached_.fetch_add(block->bytes, std::memory_order_relaxed);
+    CountAdd(Counter::PoolBytesCached, block->bytes);
+}
+
+PoolAllocator::BlockHeader* PoolAllocator::NewBlock(size_t size_class, size_t bytes) {
+    void* memory = nullptr;
+    bool from_arena = false;
+    if (options_.huge_pages && size_class != kDirect) {
+        memory = CarveFromArena(bytes);
+        from_arena = memory != nullptr;
+    }
+    if (memory == nullptr) {
+        memory = SystemAlloc(bytes);
+        if (memory == nullptr) return nullptr;
+        // Before the header below touches the first page; arenas are bound when mapped
+        if (options_.numa_node >= 0) BindMemoryToNode(memory, bytes, options_.numa_node);
+    }
+
+    auto* block = new (memory) BlockHeader();
+    block->next = nullptr;
+    block->bytes = bytes;
+    block->size_class = static_cast<uint32_t>(size_class);
+    block->from_arena = from_arena;
+    block->refs.store(0, std::memory_order_relaxed);
+    block->owner = this;
+    block->check = reinterpret_cast<uintptr_t>(block) ^ kBlockMagic;
+
+    total_allocated_.fetch_add(bytes, std::memory_order_relaxed);
+    num_system_allocs_.fetch_add(1, std::memory_order_relaxed);
+    return block;
+}
+
+PoolAllocator::BlockHeader* PoolAllocator::CarveFromArena(size_t bytes) {
+#if defined(__linux__)
+    if (bytes > kMaxArenaBlockBytes) return nullptr;
+
+    std::lock_guard<std::mutex> lock(arena_mutex_);
+    if (arenas_.empty() || arena_used_ + bytes > arenas_.back().size) {
+        // Explicit huge pages if the system has a pool of them, else transparent huge pages
+        void* base = mmap(nullptr, kArenaBytes, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base == MAP_FAILED) {
+            base = mmap(nullptr, kArenaBytes + kHugePageBytes, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (base == MAP_FAILED) return nullptr;
+
+            // Trim to a 2 MiB-aligned region so THP can back all of it
+            auto addr = reinterpret_cast<uintptr_t>(base);
+            auto aligned = RoundUp(addr, kHugePageBytes);
+            if (aligned > addr) munmap(base, aligned - addr);
+            munmap(reinterpret_cast<void*>(aligned + kArenaBytes), addr + kHugePageBytes - aligned);
+            base = reinterpret_cast<void*>(aligned);
+#if defined(MADV_HUGEPAGE)
+            madvise(base, kArenaBytes, MADV_HUGEPAGE);
+#endif
+        }
+        if (options_.numa_node >= 0) BindMemoryToNode(base, kArenaBytes, options_.numa_node);
+        arenas_.push_back({static_cast<char*>(base), kArenaBytes});
+        arena_used_ = 0;
+    }
+
+    auto* block = reinterpret_cast<BlockHeader*>(arenas_.back().base + arena_used_);
+    arena_used_ += bytes;
+    return block;
+#else
+    (void)bytes;
+    return nullptr;
+#endif
+}
+
+void PoolAllocator::ReleaseBlock(BlockHeader* block) {
+    block->check = 0;
+    total_allocated_.fetch_sub(block->bytes, std::memory_order_relaxed);
+    if (!block->from_arena) SystemFree(block);
+}
+
+void* PoolAllocator::TrackAllocation(BlockHeader* block, size_t requested) {
+    block->refs.store(1, std::memory_order_relaxed);
+    const size_t in_use = in_use_.fetch_add(block->bytes, std::memory_order_relaxed) + block->bytes;
+    CountAdd(Counter::PoolBytesInUse, block->bytes);
+    UpdateMax(max_in_use_, in_use);
+    UpdateMax(max_alloc_size_, requested);
+    num_allocs_.fetch_add(1, std::memory_order_relaxed);
+    return block + 1;
+}
+
+void* ORT_API_CALL PoolAllocator::AllocImpl(OrtAllocator* this_, size_t size) noexcept {
+    return FromOrt(this_)->Allocate(size);
+}
+
+void ORT_API_CALL PoolAllocator::FreeImpl(OrtAllocator* this_, void* p) noexcept {
+    FromOrt(this_)->Free(p);
+}
+
+const OrtMemoryInfo* ORT_API_CALL PoolAllocator::InfoImpl(const OrtAllocator* this_) noexcept {
+    return FromOrt(this_)->memory_info_;
+}
+
+void* ORT_API_CALL PoolAllocator::ReserveImpl(OrtAllocator* this_, size_t size) noexcept {
+    return FromOrt(this_)->Reserve(size);
+}
+
+OrtStatus* ORT_API_CALL PoolAllocator::GetStatsImpl(const OrtAllocator* this_,
+                                                    OrtKeyValuePairs** out) noexcept {
+    const auto* allocator = FromOrt(this_);
+    const OrtApi* api = allocator->api_;
+
+    // Key names follow ORT's own arena statistics
+    const struct {
+        const char* key;
+        uint64_t value;
+    } stats[] = {
+        {"Limit", allocator->options_.max_cached_bytes},
+        {"InUse", allocator->in_use_.load(std::memory_order_relaxed)},
+        {"TotalAllocated", allocator->total_allocated_.load(std::memory_order_relaxed)},
+        {"MaxInUse", allocator->max_in_use_.load(std::memory_order_relaxed)},
+        {"NumAllocs", allocator->num_allocs_.load(std::memory_order_relaxed)},
+        {"NumReserves", allocator->num_reserves_.load(std::memory_order_relaxed)},
+        {"NumArenaExtensions", allocator->num_system_allocs_.load(std::memory_order_relaxed)},
+        {"MaxAllocSize", allocator->max_alloc_size_.load(std::memory_order_relaxed)},
+        {"Cached", allocator->cached_.load(std::memory_order_relaxed)},
+    };
+
+    api->CreateKeyValuePairs(out);
+    for (const auto& stat : stats) {
+        api->AddKeyValuePair(*out, stat.key, std::to_string(stat.value).c_str());
+    }
+    return nullptr;
+}
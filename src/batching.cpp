@@ -0,0 +1,157 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Micro-batching of concurrent calls to one partition
+
+#include "batching.h"
+#include "counters.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Per-thread buffers of the call running a batch, reused so batching does not allocate
+struct BatchScratch {
+    std::vector<std::vector<int64_t>> dims;
+    std::vector<ShapeRef> shapes;
+    std::vector<size_t> input_bytes;  // Per call input: bytes of one call's tensor
+    std::vector<const void*> inputs;
+    std::vector<void*> outputs;
+    std::vector<char> gathered;
+};
+
+constexpr size_t AlignUp(size_t n) { return (n + 63) & ~size_t(63); }
+
+}  // namespace
+
+bool CallBatcher::Run(const BatchTarget& target, std::chrono::microseconds window, const ExecutionPlan& plan,
+                      const void** inputs, void* const* outputs, RunFn run, void* context) {
+    if (window.count() <= 0 || plan.row || plan.broadcast.total > kMaxBatchedElements) return false;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (open_ != nullptr) {
+        if (open_->plan->key_hash != plan.key_hash || open_->plan->key != plan.key) return false;
+
+        // Join, closing the batch if this call fills it, and sleep until it has run
+        std::shared_ptr<Batch> batch = open_;
+        batch->calls.push_back(Call{inputs, outputs});
+        if (batch->calls.size() == kMaxBatchCalls) {
+            open_.reset();
+            full_cv_.notify_one();
+        }
+        batch->done_cv.wait(lock, [&] { return batch->done; });
+        return true;
+    }
+
+    // Open a batch and hold it for the window, or until it fills
+    auto batch = std::make_shared<Batch>();
+    batch->plan = &plan;
+    batch->calls.push_back(Call{inputs, outputs});
+    open_ = batch;
+    full_cv_.wait_until(lock, std::chrono::steady_clock::now() + window, [&] { return open_ != batch; });
+    if (open_ == batch) open_.reset();
+    lock.unlock();
+
+    if (batch->calls.size() == 1) {
+        run(context, plan, inputs, outputs);
+    } else {
+        RunBatch(target, *batch, run, context);
+    }
+
+    lock.lock();
+    batch->done = true;
+    batch->done_cv.notify_all();
+    return true;
+}
+
+void CallBatcher::RunBatch(const BatchTarget& target, const Batch& batch, RunFn run, void* context) {
+    const ExprProgram& program = *target.program;
+    const ExecutionPlan& plan = *batch.plan;
+    const size_t count = batch.calls.size();
+    const size_t rank = plan.broadcast.output_dims.size();
+
+    // Batched shapes from the plan's key: call inputs right-aligned to the output rank under a
+    // leading batch dim, so they broadcast as before; shared inputs as they are
+    static thread_local BatchScratch scratch;
+    scratch.dims.resize(program.num_inputs);
+    scratch.shapes.resize(program.num_inputs);
+    scratch.input_bytes.resize(target.num_call_inputs);
+    size_t pos = 0;
+    for (uint32_t k = 0; k < program.num_inputs; ++k) {
+        const auto input_rank = static_cast<size_t>(plan.key[pos]);
+        const int64_t* dims = plan.key.data() + pos + 1;
+        pos += 1 + input_rank;
+
+        std::vector<int64_t>& batched = scratch.dims[k];
+        batched.clear();
+        if (k < target.num_call_inputs) {
+            batched.push_back(static_cast<int64_t>(count));
+            batched.insert(batched.end(), rank - input_rank, 1);
+
+            size_t elements = 1;
+            for (size_t d = 0; d < input_rank; ++d) elements *= static_cast<size_t>(dims[d]);
+            scratch.input_bytes[k] = elements * DataTypeSize(program.types[k]);
+        }
+        batched.insert(batched.end(), dims, dims + input_rank);
+        scratch.shapes[k] = ShapeRef{batched.data(), batched.size()};
+    }
+
+    const ExecutionPlan* batched_plan = target.plans->Find(scratch.shapes.data(), program.num_inputs);
+    std::unique_ptr<ExecutionPlan> uncached;
+    if (batched_plan == nullptr) {
+        auto built = std::make_unique<ExecutionPlan>();
+        if (BuildExecutionPlan(program, *target.kernels, scratch.shapes.data(), target.options, built.get()) !=
+            PlanStatus::Ok) {
+            for (const Call& call : batch.calls) {
+                scratch.inputs.assign(call.inputs, call.inputs + program.num_inputs);
+                run(context, plan, scratch.inputs.data(), call.outputs);
+            }
+            return;
+        }
+        batched_plan = target.plans->Insert(built);
+        if (batched_plan == nullptr) {
+            uncached = std::move(built);
+            batched_plan = uncached.get();
+        }
+    }
+
+    // Gather: one 64-byte aligned region per call input, then one per output
+    const size_t out_elements = plan.broadcast.total;
+    size_t bytes = 0;
+    for (size_t k = 0; k < target.num_call_inputs; ++k) bytes += AlignUp(count * scratch.input_bytes[k]);
+    for (uint32_t out_reg : program.outputs) bytes += AlignUp(count * out_elements * DataTypeSize(program.types[out_reg]));
+    scratch.gathered.resize(bytes + 64);
+    const auto base = reinterpret_cast<uintptr_t>(scratch.gathered.data());
+    char* region = scratch.gathered.data() + (AlignUp(base) - base);
+
+    scratch.inputs.resize(program.num_inputs);
+    for (uint32_t k = 0; k < program.num_inputs; ++k) {
+        if (k >= target.num_call_inputs) {
+            scratch.inputs[k] = batch.calls[0].inputs[k];
+            continue;
+        }
+        const size_t call_bytes = scratch.input_bytes[k];
+        for (size_t c = 0; c < count && call_bytes > 0; ++c) {
+            std::memcpy(region + c * call_bytes, batch.calls[c].inputs[k], call_bytes);
+        }
+        scratch.inputs[k] = region;
+        region += AlignUp(count * call_bytes);
+    }
+    scratch.outputs.resize(program.outputs.size());
+    for (size_t k = 0; k < program.outputs.size(); ++k) {
+        scratch.outputs[k] = region;
+        region += AlignUp(count * out_elements * DataTypeSize(program.types[program.outputs[k]]));
+    }
+
+    run(context, *batched_plan, scratch.inputs.data(), scratch.outputs.data());
+    CountAdd(Counter::Batches, 1);
+    CountAdd(Counter::BatchedCalls, count);
+
+    // Scatter each call's slice of the outputs back
+    for (size_t k = 0; k < program.outputs.size(); ++k) {
+        const size_t call_bytes = out_elements * DataTypeSize(program.types[program.outputs[k]]);
+        const auto* batched = static_cast<const char*>(scratch.outputs[k]);
+        for (size_t c = 0; c < count && call_bytes > 0; ++c) {
+            std::memcpy(batch.calls[c].outputs[k], batched + c * call_bytes, call_bytes);
+        }
+    }
+}
@@ -0,0 +1,127 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// NumPy-style broadcasting plans for elementwise partitions
+
+#include "broadcast.h"
+
+#include <algorithm>
+#include <cstring>
+
+bool BroadcastShapes(const std::vector<int64_t>& a, const std::vector<int64_t>& b,
+                     std::vector<int64_t>* out) {
+    const size_t rank = std::max(a.size(), b.size());
+    out->assign(rank, 1);
+    for (size_t d = 0; d < rank; ++d) {
+        int64_t da = d < rank - a.size() ? 1 : a[d - (rank - a.size())];
+        int64_t db = d < rank - b.size() ? 1 : b[d - (rank - b.size())];
+        if (da != db && da != 1 && db != 1) return false;
+        (*out)[d] = da == 1 ? db : da;
+    }
+    return true;
+}
+
+bool ComputeBroadcastPlan(const std::vector<ShapeRef>& inputs, BroadcastPlan* plan) {
+    const size_t num_inputs = inputs.size();
+
+    // Output shape: right-aligned broadcast of every input
+    size_t rank = 0;
+    for (const ShapeRef& in : inputs) rank = std::max(rank, in.rank);
+    plan->output_dims.assign(rank, 1);
+    for (const ShapeRef& in : inputs) {
+        for (size_t d = 0; d < in.rank; ++d) {
+            int64_t dim = in.dims[d];
+            int64_t& out = plan->output_dims[rank - in.rank + d];
+            if (dim == out || dim == 1) continue;
+            if (out != 1) return false;
+            out = dim;
+        }
+    }
+
+    plan->total = 1;
+    for (int64_t d : plan->output_dims) plan->total *= static_cast<size_t>(d);
+
+    // Element strides of each input over the output dims (0 where the input is broadcast)
+    std::vector<std::vector<size_t>> strides(num_inputs, std::vector<size_t>(rank, 0));
+    for (size_t k = 0; k < num_inputs; ++k) {
+        size_t stride = 1;
+        for (size_t d = inputs[k].rank; d-- > 0;) {
+            const size_t out_d = rank - inputs[k].rank + d;
+            const auto dim = static_cast<size_t>(inputs[k].dims[d]);
+            strides[k][out_d] = dim == 1 ? 0 : stride;
+            stride *= dim;
+        }
+    }
+
+    // Collapse from the innermost dim outwards. Size-1 dims are dropped, and a dim merges into
+    // the one inside it when every input stays linear across the pair.
+    std::vector<size_t> dims;                           // Innermost first while collapsing
+    std::vector<std::vector<size_t>> cstrides(num_inputs);
+    for (size_t d = rank; d-- > 0;) {
+        const auto dim = static_cast<size_t>(plan->output_dims[d]);
+        if (dim == 1) continue;
+
+        bool merge = !dims.empty();
+        for (size_t k = 0; k < num_inputs && merge; ++k) {
+            merge = strides[k][d] == cstrides[k].back() * dims.back();
+        }
+
+        if (merge) {
+            dims.back() *= dim;
+        } else {
+            dims.push_back(dim);
+            for (size_t k = 0; k < num_inputs; ++k) cstrides[k].push_back(strides[k][d]);
+        }
+    }
+    if (dims.empty()) {  // Scalar output
+        dims.push_back(1);
+        for (size_t k = 0; k < num_inputs; ++k) cstrides[k].push_back(0);
+    }
+
+    plan->inner = dims[0];
+    plan->outer_dims.assign(dims.rbegin(), dims.rend() - 1);
+    plan->outer_strides.assign(num_inputs, {});
+    plan->inner_stride.assign(num_inputs, 0);
+    for (size_t k = 0; k < num_inputs; ++k) {
+        plan->inner_stride[k] = cstrides[k][0] != 0 ? 1 : 0;
+        plan->outer_strides[k].assign(cstrides[k].rbegin(), cstrides[k].rend() - 1);
+    }
+    plan->repeat = 1;
+    plan->replicate.assign(num_inputs, 0);
+
+    // Widen short rows. This applies when every input is either contiguous, a single scalar,
+    // or the same row vector for every row (e.g. a bias add [N, C] + [C]); the row vectors
+    // are then tiled `repeat` times so kernels see long contiguous spans.
+    if (plan->inner >= kMinInnerElements || plan->outer_dims.empty()) return true;
+
+    const size_t last = plan->outer_dims.size() - 1;
+    const size_t rows = plan->outer_dims[last];
+    for (size_t k = 0; k < num_inputs; ++k) {
+        const bool contiguous = plan->inner_stride[k] == 1 && plan->outer_strides[k][last] == plan->inner;
+        bool uniform = true;  // Same values for every row
+        for (size_t s : plan->outer_strides[k]) uniform = uniform && s == 0;
+        if (!contiguous && !uniform) return true;
+    }
+
+    size_t repeat = 1;
+    for (size_t r = 2; r <= rows && r * plan->inner <= kMaxWidenedElements; ++r) {
+        if (rows % r == 0) repeat = r;
+    }
+    if (repeat == 1) return true;
+
+    plan->repeat = repeat;
+    plan->outer_dims[last] = rows / repeat;
+    for (size_t k = 0; k < num_inputs; ++k) {
+        if (plan->inner_stride[k] == 1 && plan->outer_strides[k][last] == 0) {
+            plan->replicate[k] = 1;  // Uniform row vector
+        } else if (plan->inner_stride[k] == 1) {
+            plan->outer_strides[k][last] *= repeat;
+        }
+    }
+    plan->inner *= repeat;
+    return true;
+}
+
+void ReplicateRows(const void* row, size_t row_bytes, size_t repeat, void* out) {
+    for (size_t r = 0; r < repeat; ++r) {
+        std::memcpy(static_cast<char*>(out) + r * row_bytes, row, row_bytes);
+    }
+}
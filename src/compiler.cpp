@@ -0,0 +1,499 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Lowering of fused ORT subgraphs into expression programs
+
+#include "compiler.h"
+#include "ort_utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+// Turn ONNX axes (negative counting from the back, empty meaning all) into the contiguous
+// range a row op runs over. Returns false for axes out of range or with gaps between them.
+bool AxisRange(std::vector<int64_t> axes, size_t rank, RowSpec* row) {
+    const auto r = static_cast<int64_t>(rank);
+    if (axes.empty()) {
+        row->axis_begin = 0;
+        row->axis_end = static_cast<uint32_t>(rank);
+        return true;
+    }
+    for (int64_t& axis : axes) {
+        if (axis < -r || axis >= r) return false;
+        if (axis < 0) axis += r;
+    }
+    std::sort(axes.begin(), axes.end());
+    axes.erase(std::unique(axes.begin(), axes.end()), axes.end());
+    if (axes.back() - axes.front() + 1 != static_cast<int64_t>(axes.size())) return false;
+    row->axis_begin = static_cast<uint32_t>(axes.front());
+    row->axis_end = static_cast<uint32_t>(axes.back() + 1);
+    return true;
+}
+
+// Rank of a tensor input, or 0 when it is unknown (or a scalar, which no row op accepts)
+OrtStatus* GetRank(const OrtApi* api, const OrtValueInfo* value, size_t* rank) {
+    std::vector<int64_t> dims;
+    bool found = false;
+    RETURN_IF_ERROR(GetValueDims(api, value, &dims, &found));
+    *rank = found ? dims.size() : 0;
+    return nullptr;
+}
+
+}  // namespace
+
+bool LookupDataType(ONNXTensorElementDataType elem_type, DataType* type) {
+    switch (elem_type) {
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT: *type = DataType::Float; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE: *type = DataType::Double; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16: *type = DataType::Float16; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16: *type = DataType::BFloat16; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8: *type = DataType::Int8; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32: *type = DataType::Int32; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64: *type = DataType::Int64; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL: *type = DataType::Bool; return true;
+        default: return false;
+    }
+}
+
+OrtStatus* LowerNode(const OrtApi* api, const OrtNode* node, NodeLowering* lowering, bool* supported) {
+    using Step = NodeLowering::Step;
+    constexpr uint8_t kPrevious = NodeLowering::kPrevious;
+    *supported = false;
+    lowering->steps.clear();
+    lowering->has_row_op = false;
+    lowering->row = RowSpec{};
+
+    const char* op_type = nullptr;
+    const char* domain = nullptr;
+    int since_version = 0;
+    RETURN_IF_ERROR(api->Node_GetOperatorType(node, &op_type));
+    RETURN_IF_ERROR(api->Node_GetDomain(node, &domain));
+    const OpDescriptor* desc = FindOp(domain, op_type);
+    if (desc == nullptr) return nullptr;
+    RETURN_IF_ERROR(api->Node_GetSinceVersion(node, &since_version));
+    if (!desc->SupportsVersion(since_version)) return nullptr;
+    lowering->descriptor = desc;
+
+    std::vector<const OrtValueInfo*> inputs;
+    std::vector<const OrtValueInfo*> outputs;
+    RETURN_IF_ERROR(GetNodeInputs(api, node, &inputs));
+    RETURN_IF_ERROR(GetNodeOutputs(api, node, &outputs));
+    if (inputs.empty() || inputs[0] == nullptr || inputs.size() >= kPrevious || outputs.size() != 1) {
+        return nullptr;
+    }
+
+    auto present = [&](size_t k) { return k < inputs.size() && inputs[k] != nullptr; };
+    bool all_present = true;
+    for (size_t k = 0; k < inputs.size(); ++k) all_present = all_present && present(k);
+
+    // Element types of the inputs (missing optional inputs have none) and of the output
+    std::vector<DataType> types(inputs.size(), DataType::Float);
+    std::string shape_key;
+    std::string data_shape_key;
+    for (size_t k = 0; k < inputs.size(); ++k) {
+        if (inputs[k] == nullptr) continue;
+        ONNXTensorElementDataType elem_type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+        RETURN_IF_ERROR(GetValueTensorInfo(api, inputs[k], &elem_type, &shape_key));
+        if (!LookupDataType(elem_type, &types[k])) return nullptr;
+        if (k == 0) data_shape_key = shape_key;
+    }
+    ONNXTensorElementDataType elem_type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+    RETURN_IF_ERROR(GetValueTensorInfo(api, outputs[0], &elem_type, &shape_key));
+    if (!LookupDataType(elem_type, &lowering->type)) return nullptr;
+
+    // Where is keyed by the type it selects rather than its condition
+    const size_t data = desc->op == OpCode::Where ? 1 : 0;
+    if (!present(data) || !desc->SupportsType(types[data])) return nullptr;
+
+    // Only multidirectional ops may grow the data input's shape, only reductions shrink it and
+    // only contractions change its last dim
+    if (desc->broadcast != BroadcastRule::Multidirectional && desc->broadcast != BroadcastRule::Reduction &&
+        desc->broadcast != BroadcastRule::Contraction && !data_shape_key.empty() &&
+        !shape_key.empty() && data_shape_key != shape_key) {
+        return nullptr;
+    }
+
+    OpCode op = desc->op;
+    switch (desc->form) {
+        case OpForm::Basic: {
+            if (inputs.size() != OpArity(op) || !all_present) return nullptr;
+            if (op == OpCode::Gelu) {
+                std::string approximate;
+                bool found = false;
+                RETURN_IF_ERROR(GetStringAttribute(api, node, "approximate", &approximate, &found));
+                if (found && approximate == "tanh") {
+                    op = OpCode::GeluTanh;
+                } else if (found && approximate != "none") {
+                    return nullptr;
+                }
+            }
+            Step step{op, {0, 0, 0}};
+            for (size_t k = 0; k < inputs.size(); ++k) step.src[k] = static_cast<uint8_t>(k);
+            lowering->steps.push_back(step);
+            break;
+        }
+        case OpForm::Variadic:
+            if (inputs.size() < 2 || !all_present) return nullptr;
+            lowering->steps.push_back({op, {0, 1, 0}});
+            for (size_t k = 2; k < inputs.size(); ++k) {
+                lowering->steps.push_back({op, {kPrevious, static_cast<uint8_t>(k), 0}});
+            }
+            break;
+        case OpForm::Clip:
+            if (inputs.size() > 3 || (!present(1) && !present(2))) return nullptr;
+            if (present(1)) lowering->steps.push_back({OpCode::Max, {0, 1, 0}});
+            if (present(2)) lowering->steps.push_back({OpCode::Min, {present(1) ? kPrevious : uint8_t(0), 2, 0}});
+            break;
+        case OpForm::Bias:
+            if (inputs.size() > 2) return nullptr;
+            if (present(1)) lowering->steps.push_back({OpCode::Add, {0, 1, 0}});
+            lowering->steps.push_back({op, {present(1) ? kPrevious : uint8_t(0), 0, 0}});
+            break;
+        case OpForm::Reduce: {
+            size_t rank = 0;
+            RETURN_IF_ERROR(GetRank(api, inputs[0], &rank));
+            if (inputs.size() > 2 || rank == 0) return nullptr;
+
+            // Axes come from the attribute before opset 18 (13 for ReduceSum), from a constant
+            // input after
+            std::vector<int64_t> axes;
+            bool found = false;
+            RETURN_IF_ERROR(GetIntsAttribute(api, node, "axes", &axes, &found));
+            if (present(1)) {
+                if (found) return nullptr;
+                RETURN_IF_ERROR(GetInitializerInts(api, inputs[1], &axes, &found));
+                if (!found) return nullptr;
+            }
+            int64_t keep_dims = 1;
+            int64_t noop_with_empty_axes = 0;
+            RETURN_IF_ERROR(GetIntAttribute(api, node, "keepdims", &keep_dims, &found));
+            RETURN_IF_ERROR(GetIntAttribute(api, node, "noop_with_empty_axes", &noop_with_empty_axes, &found));
+            if (axes.empty() && noop_with_empty_axes != 0) return nullptr;  // An identity
+            if (!AxisRange(axes, rank, &lowering->row)) return nullptr;
+            lowering->row.keep_dims = keep_dims != 0;
+            lowering->steps.push_back({op, {0, 0, 0}});
+            break;
+        }
+        case OpForm::Softmax: {
+            size_t rank = 0;
+            RETURN_IF_ERROR(GetRank(api, inputs[0], &rank));
+            if (inputs.size() != 1 || rank == 0) return nullptr;
+
+            // Before opset 13 the input is flattened to 2D at axis; from 13 only that axis is
+            // normalized, which runs here when it is the last
+            int64_t axis = since_version >= 13 ? -1 : 1;
+            bool found = false;
+            RETURN_IF_ERROR(GetIntAttribute(api, node, "axis", &axis, &found));
+            const auto r = static_cast<int64_t>(rank);
+            if (axis < -r || axis >= r) return nullptr;
+            if (axis < 0) axis += r;
+            if (since_version >= 13 && axis != r - 1) return nullptr;
+            lowering->row.axis_begin = static_cast<uint32_t>(axis);
+            lowering->row.axis_end = static_cast<uint32_t>(rank);
+            lowering->steps.push_back({op, {0, 0, 0}});
+            break;
+        }
+        case OpForm::LayerNorm: {
+            size_t rank = 0;
+            RETURN_IF_ERROR(GetRank(api, inputs[0], &rank));
+            if (inputs.size() < 2 || inputs.size() > 3 || !present(1) || rank == 0) return nullptr;
+
+            int64_t axis = -1;
+            int64_t stash_type = 1;
+            float epsilon = 1e-5f;
+            bool found = false;
+            RETURN_IF_ERROR(GetIntAttribute(api, node, "axis", &axis, &found));
+            RETURN_IF_ERROR(GetIntAttribute(api, node, "stash_type", &stash_type, &found));
+            RETURN_IF_ERROR(GetFloatAttribute(api, node, "epsilon", &epsilon, &found));
+            const auto r = static_cast<int64_t>(rank);
+            if (axis < -r || axis >= r || stash_type != 1) return nullptr;
+            if (axis < 0) axis += r;
+
+            // Scale and bias broadcast within the normalized dims, so neither grows the output
+            for (size_t k = 1; k < inputs.size(); ++k) {
+                size_t param_rank = 0;
+                if (present(k)) RETURN_IF_ERROR(GetRank(api, inputs[k], &param_rank));
+                if (param_rank > static_cast<size_t>(r - axis)) return nullptr;
+            }
+            lowering->row.axis_begin = static_cast<uint32_t>(axis);
+            lowering->row.axis_end = static_cast<uint32_t>(rank);
+            lowering->row.epsilon = epsilon;
+            lowering->steps.push_back({op, {0, 0, 0}});
+            lowering->steps.push_back({OpCode::Mul, {kPrevious, 1, 0}});
+            if (present(2)) lowering->steps.push_back({OpCode::Add, {kPrevious, 2, 0}});
+            break;
+        }
+        case OpForm::MatMul: {
+            // The weight is packed once per session, so it must be a 2D constant
+            const bool gemm = std::strcmp(op_type, "Gemm") == 0;
+            size_t rank = 0;
+            size_t weight_rank = 0;
+            RETURN_IF_ERROR(GetRank(api, inputs[0], &rank));
+            if (inputs.size() < 2 || inputs.size() > (gemm ? 3u : 2u) || !present(1) || rank == 0) return nullptr;
+            if (gemm && rank != 2) return nullptr;
+            bool constant = false;
+            RETURN_IF_ERROR(api->ValueInfo_IsConstantInitializer(inputs[1], &constant));
+            RETURN_IF_ERROR(GetRank(api, inputs[1], &weight_rank));
+            if (!constant || weight_rank != 2) return nullptr;
+
+            // Gemm: alpha * A' * B' + beta * C, run here without scaling or a transposed A
+            if (gemm) {
+                int64_t trans_a = 0;
+                int64_t trans_b = 0;
+                float alpha = 1.0f;
+                float beta = 1.0f;
+                bool found = false;
+                RETURN_IF_ERROR(GetIntAttribute(api, node, "transA", &trans_a, &found));
+                RETURN_IF_ERROR(GetIntAttribute(api, node, "transB", &trans_b, &found));
+                RETURN_IF_ERROR(GetFloatAttribute(api, node, "alpha", &alpha, &found));
+                RETURN_IF_ERROR(GetFloatAttribute(api, node, "beta", &beta, &found));
+                if (trans_a != 0 || alpha != 1.0f || (present(2) && beta != 1.0f)) return nullptr;
+                lowering->row.transposed = trans_b != 0;
+            }
+            lowering->row.axis_begin = static_cast<uint32_t>(rank - 1);
+            lowering->row.axis_end = static_cast<uint32_t>(rank);
+            lowering->steps.push_back({op, {0, 1, 0}});
+            if (present(2)) lowering->steps.push_back({OpCode::Add, {kPrevious, 2, 0}});
+            break;
+        }
+    }
+    lowering->has_row_op = IsRowOp(lowering->steps.front().op);
+
+    // Intermediate steps produce the node's output type too
+    for (const Step& step : lowering->steps) {
+        DataType src[3] = {};
+        for (size_t k = 0; k < OpArity(step.op); ++k) {
+            src[k] = step.src[k] == kPrevious ? lowering->type : types[step.src[k]];
+        }
+        if (!IsSupportedInstr(step.op, Activation::None, src, lowering->type)) return nullptr;
+    }
+
+    *supported = true;
+    return nullptr;
+}
+
+OrtStatus* CompileFusedGraph(const ApiPtrs& apis, const OrtGraph* graph,
+                             const OrtNode* fused_node, ExprProgram* program) {
+    const OrtApi* api = apis.ort_api;
+    std::unordered_map<std::string, uint32_t> register_of;
+
+    std::vector<const OrtValueInfo*> inputs;
+    RETURN_IF_ERROR(GetNodeInputs(api, fused_node, &inputs));
+    if (inputs.empty()) {
+        return api->CreateStatus(ORT_EP_FAIL, "Fused graph has no inputs");
+    }
+
+    program->num_inputs = static_cast<uint32_t>(inputs.size());
+    program->num_registers = program->num_inputs;
+    program->types.assign(inputs.size(), DataType::Float);
+    program->code.clear();
+    program->row = RowSpec{};
+
+    for (size_t k = 0; k < inputs.size(); ++k) {
+        if (inputs[k] == nullptr) continue;
+        const char* name = nullptr;
+        RETURN_IF_ERROR(api->GetValueInfoName(inputs[k], &name));
+        register_of[name] = static_cast<uint32_t>(k);
+
+        ONNXTensorElementDataType elem_type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+        std::string shape_key;
+        RETURN_IF_ERROR(GetValueTensorInfo(api, inputs[k], &elem_type, &shape_key));
+        if (!LookupDataType(elem_type, &program->types[k])) {
+            return api->CreateStatus(ORT_EP_FAIL, "Fused graph has an unsupported element type");
+        }
+    }
+
+    std::vector<const OrtValueInfo*> outputs;
+    RETURN_IF_ERROR(GetNodeOutputs(api, fused_node, &outputs));
+
+    std::vector<const OrtNode*> nodes;
+    RETURN_IF_ERROR(GetGraphNodes(api, graph, &nodes));
+
+    // Emit nodes once all of their inputs have registers, so the code runs in dependency order
+    std::vector<bool> emitted(nodes.size(), false);
+    NodeLowering lowering;
+    std::vector<uint32_t> node_registers;
+    for (size_t num_emitted = 0; num_emitted < nodes.size();) {
+        size_t emitted_before = num_emitted;
+
+        for (size_t n = 0; n < nodes.size(); ++n) {
+            if (emitted[n]) continue;
+
+            std::vector<const OrtValueInfo*> node_inputs;
+            std::vector<const OrtValueInfo*> node_outputs;
+            RETURN_IF_ERROR(GetNodeInputs(api, nodes[n], &node_inputs));
+            RETURN_IF_ERROR(GetNodeOutputs(api, nodes[n], &node_outputs));
+
+            bool ready = true;
+            node_registers.assign(node_inputs.size(), 0);
+            for (size_t k = 0; k < node_inputs.size() && ready; ++k) {
+                if (node_inputs[k] == nullptr) continue;  // Missing optional input
+                const char* name = nullptr;
+                RETURN_IF_ERROR(api->GetValueInfoName(node_inputs[k], &name));
+                auto it = register_of.find(name);
+                ready = it != register_of.end();
+                if (ready) node_registers[k] = it->second;
+            }
+            if (!ready) continue;
+
+            bool supported = false;
+            RETURN_IF_ERROR(LowerNode(api, nodes[n], &lowering, &supported));
+            if (!supported) {
+                return api->CreateStatus(ORT_EP_FAIL, "Fused graph contains an unsupported op");
+            }
+            if (program->num_registers + lowering.steps.size() >= std::numeric_limits<uint16_t>::max()) {
+                return api->CreateStatus(ORT_EP_FAIL, "Fused graph is too large");
+            }
+
+            if (lowering.has_row_op) {
+                if (FindRowInstr(*program) != program->code.size()) {
+                    return api->CreateStatus(ORT_EP_FAIL, "Fused graph has more than one row op");
+                }
+                program->row = lowering.row;
+            }
+
+            for (const NodeLowering::Step& step : lowering.steps) {
+                Instr instr{};
+                instr.op = step.op;
+                for (size_t k = 0; k < OpArity(step.op); ++k) {
+                    instr.src[k] = static_cast<uint16_t>(step.src[k] == NodeLowering::kPrevious
+                                                             ? program->num_registers - 1
+                                                             : node_registers[step.src[k]]);
+                }
+                instr.dst = static_cast<uint16_t>(program->num_registers++);
+                program->types.push_back(lowering.type);
+                program->code.push_back(instr);
+            }
+
+            const char* output_name = nullptr;
+            RETURN_IF_ERROR(api->GetValueInfoName(node_outputs[0], &output_name));
+            register_of[output_name] = program->num_registers - 1;
+
+            emitted[n] = true;
+            num_emitted++;
+        }
+
+        if (num_emitted == emitted_before) {
+            return api->CreateStatus(ORT_EP_FAIL, "Fused graph has unresolved inputs");
+        }
+    }
+
+    // Resolve the register holding each partition output
+    program->outputs.assign(outputs.size(), 0);
+    for (size_t k = 0; k < outputs.size(); ++k) {
+        const char* name = nullptr;
+        RETURN_IF_ERROR(api->GetValueInfoName(outputs[k], &name));
+        auto it = register_of.find(name);
+        if (it == register_of.end() || it->second < program->num_inputs) {
+            return api->CreateStatus(ORT_EP_FAIL, "Fused graph output is not computed");
+        }
+        program->outputs[k] = it->second;
+    }
+
+    FuseEpilogues(program);
+    return nullptr;
+}
+
+OrtStatus* ReadConstantInputs(const OrtApi* api, const OrtGraph* graph, const OrtNode* fused_node,
+                              const ExprProgram& program, std::vector<std::unique_ptr<ConstantTensor>>* values,
+                              std::vector<std::vector<int64_t>>* dims) {
+    std::vector<const OrtValueInfo*> inputs;
+    RETURN_IF_ERROR(GetNodeInputs(api, fused_node, &inputs));
+    if (inputs.size() != program.num_inputs) {
+        return api->CreateStatus(ORT_EP_FAIL, "Fused node inputs do not match the program");
+    }
+    values->clear();
+    values->resize(inputs.size());
+    dims->assign(inputs.size(), {});
+    for (size_t k = 0; k < inputs.size(); ++k) {
+        if (inputs[k] == nullptr) continue;
+        bool found = false;
+        RETURN_IF_ERROR(GetValueDims(api, inputs[k], &(*dims)[k], &found));
+
+        // Initializers belong to the subgraph, which holds the value when the node has one
+        const char* name = nullptr;
+        const OrtValueInfo* initializer = nullptr;
+        RETURN_IF_ERROR(api->GetValueInfoName(inputs[k], &name));
+        RETURN_IF_ERROR(FindGraphInitializer(api, graph, name, &initializer));
+        if (initializer == nullptr) continue;
+
+        ONNXTensorElementDataType elem_type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+        std::vector<int64_t> value_dims;
+        const void* data = nullptr;
+        RETURN_IF_ERROR(GetInitializerTensor(api, initializer, &elem_type, &value_dims, &data));
+        DataType type;
+        if (data == nullptr || !LookupDataType(elem_type, &type) || type != program.types[k]) continue;
+        size_t count = 1;
+        for (int64_t d : value_dims) count *= static_cast<size_t>(d);
+        if (count == 0 || count > kMaxFoldedElements) continue;
+
+        auto value = std::make_unique<ConstantTensor>();
+        value->dims = value_dims;
+        value->Allocate(count * DataTypeSize(type));
+        std::memcpy(value->data(), data, value->bytes());
+        (*values)[k] = std::move(value);
+    }
+    return nullptr;
+}
+
+void FuseEpilogues(ExprProgram* program) {
+    const uint32_t num_inputs = program->num_inputs;
+
+    // Reads of each register, counting partition outputs as reads
+    std::vector<uint32_t> uses(program->num_registers, 0);
+    for (const Instr& instr : program->code) {
+        for (size_t k = 0; k < OpArity(instr.op); ++k) uses[instr.src[k]]++;
+    }
+    for (uint32_t reg : program->outputs) uses[reg]++;
+
+    // Fold, marking each absorbed activation by pointing its register at the fused result
+    std::vector<uint32_t> alias(program->num_registers);
+    for (uint32_t r = 0; r < program->num_registers; ++r) alias[r] = r;
+    std::vector<bool> removed(program->code.size(), false);
+    for (size_t j = 0; j < program->code.size(); ++j) {
+        const Instr& act = program->code[j];
+        Activation activation = Activation::None;
+        for (size_t a = 1; a < kNumActivations; ++a) {
+            if (ActivationOp(static_cast<Activation>(a)) == act.op) activation = static_cast<Activation>(a);
+        }
+        const uint32_t src = act.src[0];
+        if (activation == Activation::None || src < num_inputs || uses[src] != 1) continue;
+
+        Instr& producer = program->code[src - num_inputs];
+        if (producer.epilogue != Activation::None ||
+            !HasEpilogue(producer.op, program->types[producer.src[0]])) {
+            continue;
+        }
+        producer.epilogue = activation;
+        alias[act.dst] = src;
+        removed[j] = true;
+    }
+
+    // Renumber the surviving instructions
+    std::vector<uint32_t> renumber(program->num_registers);
+    for (uint32_t r = 0; r < num_inputs; ++r) renumber[r] = r;
+    std::vector<Instr> code;
+    std::vector<DataType> types(program->types.begin(), program->types.begin() + num_inputs);
+    for (size_t i = 0; i < program->code.size(); ++i) {
+        Instr instr = program->code[i];
+        if (removed[i]) {
+            renumber[instr.dst] = renumber[alias[instr.dst]];
+            continue;
+        }
+        for (size_t k = 0; k < OpArity(instr.op); ++k) {
+            instr.src[k] = static_cast<uint16_t>(renumber[instr.src[k]]);
+        }
+        renumber[instr.dst] = static_cast<uint32_t>(num_inputs + code.size());
+        types.push_back(program->types[instr.dst]);
+        instr.dst = static_cast<uint16_t>(renumber[instr.dst]);
+        code.push_back(instr);
+    }
+    for (uint32_t& reg : program->outputs) reg = renumber[reg];
+
+    program->code = std::move(code);
+    program->types = std::move(types);
+    program->num_registers = static_cast<uint32_t>(num_inputs + program->code.size());
+}
@@ -0,0 +1,219 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Compile-time folding of a partition's constant inputs
+
+#include "constant_folding.h"
+#include "execution_plan.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+void ConstantTensor::Allocate(size_t bytes) {
+    storage_.assign((bytes + sizeof(Line) - 1) / sizeof(Line), Line{});
+    bytes_ = bytes;
+}
+
+namespace {
+
+constexpr uint32_t kNoRegister = std::numeric_limits<uint32_t>::max();
+
+// Evaluate one instruction over known operands into *result. False if the operands do not
+// broadcast or the result is too large to keep.
+bool Evaluate(const ExprProgram& program, const Instr& instr, const std::vector<const ConstantTensor*>& values,
+              const KernelTable& kernels, ConstantTensor* result) {
+    const size_t arity = OpArity(instr.op);
+    ExprProgram sub;
+    sub.num_inputs = static_cast<uint32_t>(arity);
+    Instr single = instr;
+    std::vector<ShapeRef> shapes;
+    std::vector<const void*> inputs;
+    for (size_t k = 0; k < arity; ++k) {
+        const ConstantTensor& value = *values[instr.src[k]];
+        sub.types.push_back(program.types[instr.src[k]]);
+        shapes.push_back(ShapeRef{value.dims.data(), value.dims.size()});
+        inputs.push_back(value.data());
+        single.src[k] = static_cast<uint16_t>(k);
+    }
+    single.dst = static_cast<uint16_t>(arity);
+    sub.types.push_back(program.types[instr.dst]);
+    sub.code.push_back(single);
+    sub.num_registers = static_cast<uint32_t>(arity + 1);
+    sub.outputs.push_back(single.dst);
+
+    PlanOptions options;
+    options.parallel_threshold = std::numeric_limits<size_t>::max();
+    ExecutionPlan plan;
+    if (BuildExecutionPlan(sub, kernels, shapes.data(), options, &plan) != PlanStatus::Ok) return false;
+    const size_t total = plan.broadcast.total;
+    if (total > kMaxFoldedElements) return false;
+
+    std::vector<char> replicated(plan.replicated_bytes);
+    ReplicateInputs(sub, plan, inputs.data(), replicated.data());
+    result->dims = plan.broadcast.output_dims;
+    result->Allocate(total * DataTypeSize(program.types[instr.dst]));
+    void* out = result->data();
+    if (total > 0) ExecuteProgram(sub, plan, inputs.data(), &out, 0, total);
+    return true;
+}
+
+// Collapse to 1 each dim d with collapsible[d] along which every slice equals the first.
+// Returns whether any dim collapsed.
+bool CollapseRepeats(ConstantTensor* value, size_t elem_size, const std::vector<bool>& collapsible) {
+    bool collapsed = false;
+    for (size_t d = 0; d < value->dims.size(); ++d) {
+        const auto n = static_cast<size_t>(value->dims[d]);
+        if (n <= 1 || !collapsible[d]) continue;
+        size_t outer = 1;
+        size_t slice = elem_size;
+        for (size_t i = 0; i < d; ++i) outer *= static_cast<size_t>(value->dims[i]);
+        for (size_t i = d + 1; i < value->dims.size(); ++i) slice *= static_cast<size_t>(value->dims[i]);
+
+        const auto* p = static_cast<const char*>(value->data());
+        bool repeats = true;
+        for (size_t o = 0; o < outer && repeats; ++o) {
+            const char* first = p + o * n * slice;
+            for (size_t j = 1; j < n && repeats; ++j) repeats = std::memcmp(first + j * slice, first, slice) == 0;
+        }
+        if (!repeats) continue;
+
+        ConstantTensor smaller;
+        smaller.dims = value->dims;
+        smaller.dims[d] = 1;
+        smaller.Allocate(outer * slice);
+        for (size_t o = 0; o < outer; ++o) {
+            std::memcpy(static_cast<char*>(smaller.data()) + o * slice, p + o * n * slice, slice);
+        }
+        *value = std::move(smaller);
+        collapsed = true;
+    }
+    return collapsed;
+}
+
+// Right-aligned dim `axis` of a rank-`rank` result, from `dims`: 1 where `dims` is shorter
+int64_t AlignedDim(const std::vector<int64_t>& dims, size_t rank, size_t axis) {
+    const size_t offset = rank - dims.size();
+    return axis < offset ? 1 : dims[axis - offset];
+}
+
+}  // namespace
+
+void FoldConstants(ExprProgram* program, const std::vector<std::unique_ptr<ConstantTensor>>& inputs,
+                   const std::vector<std::vector<int64_t>>& input_dims, const KernelTable& kernels,
+                   std::vector<ConstantTensor>* folded) {
+    const uint32_t num_inputs = program->num_inputs;
+    const uint32_t num_registers = program->num_registers;
+
+    std::vector<bool> is_output(num_registers, false);
+    for (uint32_t reg : program->outputs) is_output[reg] = true;
+
+    // Evaluate, in order, every elementwise instruction whose operands are all known. Outputs
+    // are still computed per call, since they must be written to ORT's buffers.
+    std::vector<const ConstantTensor*> value(num_registers, nullptr);
+    for (uint32_t r = 0; r < num_inputs; ++r) value[r] = inputs[r].get();
+    std::vector<std::unique_ptr<ConstantTensor>> computed(num_registers);
+    std::vector<bool> removed(program->code.size(), false);
+    for (size_t i = 0; i < program->code.size(); ++i) {
+        const Instr& instr = program->code[i];
+        if (IsRowOp(instr.op) || is_output[instr.dst]) continue;
+        bool known = true;
+        for (size_t k = 0; k < OpArity(instr.op); ++k) known = known && value[instr.src[k]] != nullptr;
+        if (!known) continue;
+
+        auto result = std::make_unique<ConstantTensor>();
+        if (!Evaluate(*program, instr, value, kernels, result.get())) continue;
+        value[instr.dst] = result.get();
+        computed[instr.dst] = std::move(result);
+        removed[i] = true;
+    }
+
+    // Dims each register is known to have, propagated through the elementwise code: a dim
+    // longer than 1 in any operand is the result's too, anything else (-1) is not known
+    std::vector<std::vector<int64_t>> dims(num_registers);
+    for (uint32_t r = 0; r < num_inputs; ++r) dims[r] = value[r] ? value[r]->dims : input_dims[r];
+    for (const Instr& instr : program->code) {
+        if (value[instr.dst] != nullptr) {
+            dims[instr.dst] = value[instr.dst]->dims;
+            continue;
+        }
+        if (IsRowOp(instr.op)) continue;  // Not needed: such programs are not collapsed
+        size_t rank = 0;
+        for (size_t k = 0; k < OpArity(instr.op); ++k) rank = std::max(rank, dims[instr.src[k]].size());
+        dims[instr.dst].assign(rank, -1);
+        for (size_t a = 0; a < rank; ++a) {
+            for (size_t k = 0; k < OpArity(instr.op); ++k) {
+                const int64_t dim = AlignedDim(dims[instr.src[k]], rank, a);
+                if (dim > 1) dims[instr.dst][a] = dim;
+            }
+        }
+    }
+
+    // A known register's dim may collapse when, for every remaining instruction reading it,
+    // the other operands are known to have the same length there. Row programs take their
+    // operand's shape from the prologue's inputs, so nothing in them collapses.
+    const bool collapse = FindRowInstr(*program) == program->code.size();
+    std::vector<bool> read(num_registers, false);
+    std::vector<std::vector<bool>> collapsible(num_registers);
+    for (uint32_t r = 0; r < num_registers; ++r) {
+        if (value[r] != nullptr) collapsible[r].assign(value[r]->dims.size(), collapse);
+    }
+    for (size_t i = 0; i < program->code.size(); ++i) {
+        if (removed[i]) continue;
+        const Instr& instr = program->code[i];
+        for (size_t k = 0; k < OpArity(instr.op); ++k) {
+            const uint32_t src = instr.src[k];
+            read[src] = true;
+            if (value[src] == nullptr) continue;
+            const std::vector<int64_t>& own = value[src]->dims;
+            for (size_t a = 0; a < own.size(); ++a) {
+                bool covered = false;
+                for (size_t j = 0; j < OpArity(instr.op); ++j) {
+                    const std::vector<int64_t>& other = dims[instr.src[j]];
+                    if (instr.src[j] == src || other.size() < own.size() - a) continue;
+                    covered = covered || other[other.size() - own.size() + a] == own[a];
+                }
+                if (!covered) collapsible[src][a] = false;
+            }
+        }
+    }
+
+    // Folded results the remaining code reads become inputs, as do given constants whose
+    // repeats collapse; the rest of the program is renumbered after them
+    std::vector<uint32_t> renumber(num_registers, kNoRegister);
+    for (uint32_t r = 0; r < num_inputs; ++r) renumber[r] = r;
+    std::vector<DataType> types(program->types.begin(), program->types.begin() + num_inputs);
+    for (uint32_t r = 0; r < num_registers; ++r) {
+        if (!read[r] || value[r] == nullptr) continue;
+        const size_t elem_size = DataTypeSize(program->types[r]);
+        ConstantTensor tensor;
+        if (r < num_inputs) {
+            tensor.dims = value[r]->dims;
+            tensor.Allocate(value[r]->bytes());
+            if (tensor.bytes() > 0) std::memcpy(tensor.data(), value[r]->data(), tensor.bytes());
+            if (!CollapseRepeats(&tensor, elem_size, collapsible[r])) continue;
+        } else {
+            tensor = std::move(*computed[r]);
+            CollapseRepeats(&tensor, elem_size, collapsible[r]);
+        }
+        renumber[r] = static_cast<uint32_t>(types.size());
+        types.push_back(program->types[r]);
+        folded->push_back(std::move(tensor));
+    }
+    const auto new_inputs = static_cast<uint32_t>(types.size());
+
+    std::vector<Instr> code;
+    for (size_t i = 0; i < program->code.size(); ++i) {
+        if (removed[i]) continue;
+        Instr instr = program->code[i];
+        for (size_t k = 0; k < OpArity(instr.op); ++k) instr.src[k] = static_cast<uint16_t>(renumber[instr.src[k]]);
+        renumber[instr.dst] = static_cast<uint32_t>(types.size());
+        types.push_back(program->types[instr.dst]);
+        instr.dst = static_cast<uint16_t>(renumber[instr.dst]);
+        code.push_back(instr);
+    }
+    for (uint32_t& reg : program->outputs) reg = renumber[reg];
+
+    program->num_inputs = new_inputs;
+    program->num_registers = static_cast<uint32_t>(types.size());
+    program->types = std::move(types);
+    program->code = std::move(code);
+}
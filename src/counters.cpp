@@ -0,0 +1,133 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Always-on aggregate performance counters
+
+#include "counters.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+const char* const kCounterNames[] = {
+    "compute_calls",
+    "output_elements",
+    "generic_calls",
+    "hot_path_calls",
+    "row_op_calls",
+    "plan_cache_hits",
+    "plan_cache_misses",
+    "plan_cache_overflows",
+    "batches",
+    "batched_calls",
+    "pool_bytes_in_use",
+    "pool_bytes_cached",
+    "stream_queue_depth",
+    "parallel_loops",
+    "busy_pool_loops",
+    "stolen_chunks",
+};
+static_assert(sizeof(kCounterNames) / sizeof(kCounterNames[0]) == static_cast<size_t>(Counter::OpElements),
+              "every counter needs a name");
+
+// In OpCode order
+const char* const kOpElementNames[] = {
+    "op_elements.add",
+    "op_elements.sub",
+    "op_elements.mul",
+    "op_elements.div",
+    "op_elements.max",
+    "op_elements.min",
+    "op_elements.pow",
+    "op_elements.equal",
+    "op_elements.less",
+    "op_elements.greater",
+    "op_elements.less_or_equal",
+    "op_elements.greater_or_equal",
+    "op_elements.neg",
+    "op_elements.abs",
+    "op_elements.relu",
+    "op_elements.sigmoid",
+    "op_elements.tanh",
+    "op_elements.gelu",
+    "op_elements.gelu_tanh",
+    "op_elements.erf",
+    "op_elements.exp",
+    "op_elements.log",
+    "op_elements.sqrt",
+    "op_elements.reciprocal",
+    "op_elements.where",
+    "op_elements.cast",
+    "op_elements.reduce_sum",
+    "op_elements.reduce_mean",
+    "op_elements.reduce_max",
+    "op_elements.softmax",
+    "op_elements.layer_norm",
+    "op_elements.matmul",
+};
+static_assert(sizeof(kOpElementNames) / sizeof(kOpElementNames[0]) == kNumOpCodes, "every op needs a name");
+
+// One thread's counters, on cache lines of their own. Only the owning thread writes them.
+struct alignas(64) CounterBlock {
+    std::atomic<uint64_t> values[kNumCounters] = {};
+};
+
+// Every live block, and the sums of the blocks of threads that have exited
+struct Registry {
+    std::mutex mutex;
+    std::vector<CounterBlock*> blocks;
+    uint64_t retired[kNumCounters] = {};
+};
+
+Registry& GetRegistry() {
+    static Registry* registry = new Registry();  // Never destroyed: threads may exit after static destructors run
+    return *registry;
+}
+
+// Registers the calling thread's block on first use and folds it into the retired sums when
+// the thread exits
+struct ThreadCounters {
+    CounterBlock block;
+
+    ThreadCounters() {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.blocks.push_back(&block);
+    }
+
+    ~ThreadCounters() {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (size_t i = 0; i < kNumCounters; ++i) registry.retired[i] += block.values[i].load(std::memory_order_relaxed);
+        for (size_t i = 0; i < registry.blocks.size(); ++i) {
+            if (registry.blocks[i] == &block) {
+                registry.blocks[i] = registry.blocks.back();
+                registry.blocks.pop_back();
+                break;
+            }
+        }
+    }
+};
+
+}  // namespace
+
+void CountAdd(size_t index, uint64_t delta) {
+    static thread_local ThreadCounters counters;
+    std::atomic<uint64_t>& value = counters.block.values[index];
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+const char* CounterName(size_t index) {
+    const auto first_op = static_cast<size_t>(Counter::OpElements);
+    if (index < first_op) return kCounterNames[index];
+    return index < kNumCounters ? kOpElementNames[index - first_op] : "";
+}
+
+void ReadCounters(uint64_t* values) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (size_t i = 0; i < kNumCounters; ++i) values[i] = registry.retired[i];
+    for (const CounterBlock* block : registry.blocks) {
+        for (size_t i = 0; i < kNumCounters; ++i) values[i] += block->values[i].load(std::memory_order_relaxed);
+    }
+}
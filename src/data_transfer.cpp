@@ -0,0 +1,168 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Copies between host memory and the EP's memory at partition boundaries
+
+#include "data_transfer.h"
+#include "ort_utils.h"
+#include "stream.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SAMPLE_EP_STREAMING_STORES 1
+#endif
+
+namespace {
+
+// Unit of work handed to each thread: large enough to amortize the hand-off, small enough
+// that a few threads share a copy evenly
+constexpr size_t kCopyChunkBytes = size_t(256) << 10;
+
+// Memory bandwidth saturates well before every core is copying
+constexpr size_t kMaxCopyThreads = 4;
+
+// Copy with stores that bypass the cache. Unaligned edges go through memcpy.
+void StreamingCopy(char* dst, const char* src, size_t bytes) {
+#if defined(SAMPLE_EP_STREAMING_STORES)
+    const size_t head = std::min(bytes, (16 - reinterpret_cast<uintptr_t>(dst) % 16) % 16);
+    std::memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    bytes -= head;
+
+    size_t i = 0;
+    for (; i + 64 <= bytes; i += 64) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 32));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i), a);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 16), b);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 32), c);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 48), d);
+    }
+    std::memcpy(dst + i, src + i, bytes - i);
+
+    // Streaming stores are weakly ordered; make them visible before the copy is reported done
+    _mm_sfence();
+#else
+    std::memcpy(dst, src, bytes);
+#endif
+}
+
+}  // namespace
+
+void CopyBuffer(void* dst, const void* src, size_t bytes, ThreadPool* pool) {
+    if (bytes < kStreamingCopyBytes) {
+        std::memcpy(dst, src, bytes);
+        return;
+    }
+
+    auto* d = static_cast<char*>(dst);
+    auto* s = static_cast<const char*>(src);
+    const size_t num_chunks = (bytes + kCopyChunkBytes - 1) / kCopyChunkBytes;
+    if (pool == nullptr || pool->NumThreads() == 1) {
+        StreamingCopy(d, s, bytes);
+        return;
+    }
+
+    auto copy_chunk = [&](size_t chunk) {
+        const size_t begin = chunk * kCopyChunkBytes;
+        StreamingCopy(d + begin, s + begin, std::min(kCopyChunkBytes, bytes - begin));
+    };
+    pool->ParallelFor(num_chunks, copy_chunk);
+}
+
+// ============================================================================
+// SampleDataTransfer Implementation
+// ============================================================================
+
+SampleDataTransfer* SampleDataTransfer::FromOrt(OrtDataTransferImpl* ort_data_transfer) {
+    return CONTAINER_OF(ort_data_transfer, SampleDataTransfer, data_transfer_);
+}
+
+const SampleDataTransfer* SampleDataTransfer::FromOrt(const OrtDataTransferImpl* ort_data_transfer) {
+    return CONTAINER_OF_CONST(ort_data_transfer, SampleDataTransfer, data_transfer_);
+}
+
+SampleDataTransfer::SampleDataTransfer(const OrtApi* api, const OrtEpApi* ep_api,
+                                       const OrtMemoryInfo* memory_info, std::shared_ptr<StreamSet> streams)
+    : api_(api), ep_api_(ep_api), memory_device_(ep_api->MemoryInfo_GetMemoryDevice(memory_info)),
+      streams_(std::move(streams)) {
+    std::memset(&data_transfer_, 0, sizeof(data_transfer_));
+    data_transfer_.ort_version_supported = ORT_API_VERSION;
+    data_transfer_.Release = ReleaseImpl;
+    data_transfer_.CanCopy = CanCopyImpl;
+    data_transfer_.CopyTensors = CopyTensorsImpl;
+}
+
+ThreadPool* SampleDataTransfer::GetCopyPool() {
+    std::call_once(pool_once_, [this] {
+        const size_t threads = std::min<size_t>(kMaxCopyThreads, std::max(1u, std::thread::hardware_concurrency()));
+        copy_pool_ = std::make_unique<ThreadPool>(threads);
+    });
+    return copy_pool_.get();
+}
+
+void ORT_API_CALL SampleDataTransfer::ReleaseImpl(OrtDataTransferImpl* this_ptr) noexcept {
+    delete FromOrt(this_ptr);
+}
+
+bool ORT_API_CALL SampleDataTransfer::CanCopyImpl(const OrtDataTransferImpl* this_ptr,
+                                                  const OrtMemoryDevice* src_memory_device,
+                                                  const OrtMemoryDevice* dst_memory_device) noexcept {
+    const auto* transfer = FromOrt(this_ptr);
+    const OrtEpApi* ep_api = transfer->ep_api_;
+
+    // Host memory on both sides, at least one of them ours
+    if (ep_api->MemoryDevice_GetDeviceType(src_memory_device) != OrtMemoryInfoDeviceType_CPU ||
+        ep_api->MemoryDevice_GetDeviceType(dst_memory_device) != OrtMemoryInfoDeviceType_CPU) {
+        return false;
+    }
+    return ep_api->MemoryDevice_AreEqual(src_memory_device, transfer->memory_device_) ||
+           ep_api->MemoryDevice_AreEqual(dst_memory_device, transfer->memory_device_);
+}
+
+OrtStatus* ORT_API_CALL SampleDataTransfer::CopyTensorsImpl(OrtDataTransferImpl* this_ptr,
+                                                           const OrtValue** src_tensors,
+                                                           OrtValue** dst_tensors,
+                                                           OrtSyncStream** streams,
+                                                           size_t num_tensors) noexcept {
+    auto* transfer = FromOrt(this_ptr);
+    const OrtApi* api = transfer->api_;
+
+    for (size_t i = 0; i < num_tensors; ++i) {
+        // Copies run on ORT's thread, and partitions queued on a stream may still be writing a
+        // source in our memory. Not every copy comes with the producer's stream (the public
+        // CopyTensors takes none), so without one of ours every stream that could hold the
+        // producer is drained.
+        CpuStream* stream = streams != nullptr ? CpuStream::FromOrtStream(transfer->ep_api_, streams[i]) : nullptr;
+        if (stream != nullptr) {
+            stream->Drain();
+        } else {
+            const OrtMemoryInfo* src_info = nullptr;
+            RETURN_IF_ERROR(api->GetTensorMemoryInfo(src_tensors[i], &src_info));
+            const OrtMemoryDevice* src_device = transfer->ep_api_->MemoryInfo_GetMemoryDevice(src_info);
+            if (transfer->ep_api_->MemoryDevice_AreEqual(src_device, transfer->memory_device_)) {
+                transfer->streams_->DrainAll();
+            }
+        }
+
+        const void* src = nullptr;
+        void* dst = nullptr;
+        size_t bytes = 0;
+        RETURN_IF_ERROR(api->GetTensorData(src_tensors[i], &src));
+        RETURN_IF_ERROR(api->GetTensorMutableData(dst_tensors[i], &dst));
+        RETURN_IF_ERROR(api->GetTensorSizeInBytes(src_tensors[i], &bytes));
+
+        // Both sides are host memory, so a tensor already in place needs nothing
+        if (src == dst || bytes == 0) continue;
+
+        CopyBuffer(dst, src, bytes, bytes >= kStreamingCopyBytes ? transfer->GetCopyPool() : nullptr);
+    }
+    return nullptr;
+}
@@ -0,0 +1,233 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// EPContext nodes: compiled partitions saved into the model and loaded back without recompiling
+
+#include "ep_context.h"
+#include "ort_utils.h"
+
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+constexpr const char* kEpContextOpType = "EPContext";
+constexpr const char* kEpContextDomain = "com.microsoft";
+constexpr const char* kMagic = "SampleEP";
+
+bool ParseDataType(const std::string& name, DataType* type) {
+    for (size_t t = 0; t < kNumDataTypes; ++t) {
+        if (name == DataTypeName(static_cast<DataType>(t))) {
+            *type = static_cast<DataType>(t);
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+// Whitespace-separated tokens:
+//   SampleEP <format> isa <name> inputs <n> registers <n> types <dtype>...
+//   code <n> (<op> <epilogue> <dst> <src0> <src1> <src2>)... outputs <n> <reg>...
+//   row <axis_begin> <axis_end> <keep_dims> <epsilon bits> <transposed>
+// OpCode and Activation values are part of the format.
+std::string SerializeProgram(const ExprProgram& program, const KernelTable& kernels) {
+    std::ostringstream out;
+    out << kMagic << ' ' << kEpContextFormatVersion
+        << " isa " << kernels.name
+        << " inputs " << program.num_inputs
+        << " registers " << program.num_registers
+        << " types";
+    for (DataType type : program.types) out << ' ' << DataTypeName(type);
+    out << " code " << program.code.size();
+    for (const Instr& instr : program.code) {
+        out << ' ' << static_cast<unsigned>(instr.op) << ' ' << static_cast<unsigned>(instr.epilogue)
+            << ' ' << instr.dst << ' ' << instr.src[0] << ' ' << instr.src[1] << ' ' << instr.src[2];
+    }
+    out << " outputs " << program.outputs.size();
+    for (uint32_t reg : program.outputs) out << ' ' << reg;
+
+    // epsilon as its bit pattern, which round-trips exactly
+    uint32_t epsilon_bits = 0;
+    std::memcpy(&epsilon_bits, &program.row.epsilon, sizeof(epsilon_bits));
+    out << " row " << program.row.axis_begin << ' ' << program.row.axis_end << ' '
+        << (program.row.keep_dims ? 1 : 0) << ' ' << epsilon_bits << ' ' << (program.row.transposed ? 1 : 0);
+    return out.str();
+}
+
+bool DeserializeProgram(const std::string& blob, ExprProgram* program) {
+    std::istringstream in(blob);
+    std::string magic, key, isa, type;
+    int format = 0;
+    if (!(in >> magic >> format) || magic != kMagic || format != kEpContextFormatVersion) return false;
+    if (!(in >> key >> isa) || key != "isa") return false;  // Informational only
+    if (!(in >> key >> program->num_inputs) || key != "inputs") return false;
+    if (!(in >> key >> program->num_registers) || key != "registers") return false;
+    if (program->num_registers > 0xffff) return false;
+
+    if (!(in >> key) || key != "types") return false;
+    program->types.resize(program->num_registers);
+    for (DataType& register_type : program->types) {
+        if (!(in >> type) || !ParseDataType(type, &register_type)) return false;
+    }
+
+    size_t count = 0;
+    if (!(in >> key >> count) || key != "code" || count > program->num_registers) return false;
+    program->code.resize(count);
+    for (Instr& instr : program->code) {
+        unsigned op = 0, epilogue = 0, dst = 0, src[3] = {};
+        if (!(in >> op >> epilogue >> dst >> src[0] >> src[1] >> src[2]) || op > 0xff || epilogue > 0xff ||
+            dst > 0xffff || src[0] > 0xffff || src[1] > 0xffff || src[2] > 0xffff) {
+            return false;
+        }
+        instr.op = static_cast<OpCode>(op);
+        instr.epilogue = static_cast<Activation>(epilogue);
+        instr.dst = static_cast<uint16_t>(dst);
+        for (size_t k = 0; k < 3; ++k) instr.src[k] = static_cast<uint16_t>(src[k]);
+    }
+
+    if (!(in >> key >> count) || key != "outputs" || count > program->num_registers) return false;
+    program->outputs.resize(count);
+    for (uint32_t& reg : program->outputs) {
+        if (!(in >> reg)) return false;
+    }
+
+    unsigned keep_dims = 0;
+    unsigned transposed = 0;
+    uint32_t epsilon_bits = 0;
+    if (!(in >> key >> program->row.axis_begin >> program->row.axis_end >> keep_dims >> epsilon_bits >>
+          transposed) ||
+        key != "row" || keep_dims > 1 || transposed > 1) {
+        return false;
+    }
+    program->row.keep_dims = keep_dims != 0;
+    program->row.transposed = transposed != 0;
+    std::memcpy(&program->row.epsilon, &epsilon_bits, sizeof(epsilon_bits));
+
+    in >> std::ws;
+    return in.eof() && ValidateProgram(*program);
+}
+
+std::string GetCompatibilityInfo(const KernelTable& kernels) {
+    return std::string(kMagic) + ";format=" + std::to_string(kEpContextFormatVersion) +
+           ";isa=" + kernels.name;
+}
+
+OrtCompiledModelCompatibility CheckCompatibilityInfo(const char* compatibility_info) {
+    const std::string prefix = std::string(kMagic) + ";";
+    if (compatibility_info == nullptr || std::strncmp(compatibility_info, prefix.c_str(), prefix.size()) != 0) {
+        return OrtCompiledModelCompatibility_EP_NOT_APPLICABLE;
+    }
+
+    // Programs do not depend on the ISA they were compiled on, so only the format matters
+    const std::string format = "format=" + std::to_string(kEpContextFormatVersion) + ";";
+    if (std::strncmp(compatibility_info + prefix.size(), format.c_str(), format.size()) != 0) {
+        return OrtCompiledModelCompatibility_EP_UNSUPPORTED;
+    }
+    return OrtCompiledModelCompatibility_EP_SUPPORTED_OPTIMAL;
+}
+
+OrtStatus* IsOwnEpContextNode(const OrtApi* api, const OrtNode* node, const std::string& ep_name,
+                              bool* result) {
+    *result = false;
+
+    const char* op_type = nullptr;
+    const char* domain = nullptr;
+    RETURN_IF_ERROR(api->Node_GetOperatorType(node, &op_type));
+    RETURN_IF_ERROR(api->Node_GetDomain(node, &domain));
+    if (op_type == nullptr || domain == nullptr ||
+        std::strcmp(op_type, kEpContextOpType) != 0 || std::strcmp(domain, kEpContextDomain) != 0) {
+        return nullptr;
+    }
+
+    std::string source;
+    bool found = false;
+    RETURN_IF_ERROR(GetStringAttribute(api, node, "source", &source, &found));
+    *result = found && source == ep_name;
+    return nullptr;
+}
+
+OrtStatus* CreateEpContextNode(const ApiPtrs& apis, const OrtNode* fused_node,
+                               const std::string& ep_name, const std::string& blob,
+                               OrtNode** ep_context_node) {
+    const OrtApi* api = apis.ort_api;
+    const OrtModelEditorApi* model_api = api->GetModelEditorApi();
+    if (model_api == nullptr) {
+        return api->CreateStatus(ORT_NOT_IMPLEMENTED, "EPContext generation needs the model editor API");
+    }
+
+    const char* node_name = nullptr;
+    RETURN_IF_ERROR(api->Node_GetName(fused_node, &node_name));
+
+    std::vector<const OrtValueInfo*> inputs;
+    std::vector<const OrtValueInfo*> outputs;
+    RETURN_IF_ERROR(GetNodeInputs(api, fused_node, &inputs));
+    RETURN_IF_ERROR(GetNodeOutputs(api, fused_node, &outputs));
+
+    std::vector<const char*> input_names(inputs.size(), "");
+    std::vector<const char*> output_names(outputs.size(), "");
+    for (size_t k = 0; k < inputs.size(); ++k) {
+        if (inputs[k] != nullptr) RETURN_IF_ERROR(api->GetValueInfoName(inputs[k], &input_names[k]));
+    }
+    for (size_t k = 0; k < outputs.size(); ++k) {
+        RETURN_IF_ERROR(api->GetValueInfoName(outputs[k], &output_names[k]));
+    }
+
+    const int64_t embed_mode = 1;
+    const int64_t main_context = 1;
+    OrtOpAttr* attrs[4] = {};
+    OrtStatus* status = api->CreateOpAttr("ep_cache_context", blob.data(), static_cast<int>(blob.size()),
+                                          ORT_OP_ATTR_STRING, &attrs[0]);
+    if (status == nullptr) status = api->CreateOpAttr("embed_mode", &embed_mode, 1, ORT_OP_ATTR_INT, &attrs[1]);
+    if (status == nullptr) status = api->CreateOpAttr("main_context", &main_context, 1, ORT_OP_ATTR_INT, &attrs[2]);
+    if (status == nullptr) {
+        status = api->CreateOpAttr("source", ep_name.data(), static_cast<int>(ep_name.size()),
+                                   ORT_OP_ATTR_STRING, &attrs[3]);
+    }
+
+    if (status == nullptr) {
+        status = model_api->CreateNode(kEpContextOpType, kEpContextDomain, node_name ? node_name : "",
+                                       input_names.data(), input_names.size(),
+                                       output_names.data(), output_names.size(),
+                                       attrs, 4, ep_context_node);
+    }
+
+    // CreateNode copies the attributes
+    for (OrtOpAttr* attr : attrs) {
+        if (attr != nullptr) api->ReleaseOpAttr(attr);
+    }
+    return status;
+}
+
+OrtStatus* LoadEpContextProgram(const ApiPtrs& apis, const OrtGraph* graph,
+                                const OrtNode* fused_node, ExprProgram* program, bool* loaded) {
+    const OrtApi* api = apis.ort_api;
+    *loaded = false;
+
+    std::vector<const OrtNode*> nodes;
+    RETURN_IF_ERROR(GetGraphNodes(api, graph, &nodes));
+    if (nodes.size() != 1) return nullptr;
+
+    const char* op_type = nullptr;
+    RETURN_IF_ERROR(api->Node_GetOperatorType(nodes[0], &op_type));
+    if (op_type == nullptr || std::strcmp(op_type, kEpContextOpType) != 0) return nullptr;
+
+    std::string blob;
+    bool found = false;
+    RETURN_IF_ERROR(GetStringAttribute(api, nodes[0], "ep_cache_context", &blob, &found));
+    if (!found || !DeserializeProgram(blob, program)) {
+        return api->CreateStatus(ORT_INVALID_GRAPH,
+                                 "EPContext node does not hold a program this SampleEP version can load");
+    }
+
+    size_t num_inputs = 0;
+    size_t num_outputs = 0;
+    RETURN_IF_ERROR(api->Node_GetNumInputs(fused_node, &num_inputs));
+    RETURN_IF_ERROR(api->Node_GetNumOutputs(fused_node, &num_outputs));
+    if (num_inputs != program->num_inputs || num_outputs != program->outputs.size()) {
+        return api->CreateStatus(ORT_INVALID_GRAPH, "EPContext program does not match the node's inputs and outputs");
+    }
+
+    *loaded = true;
+    return nullptr;
+}
@@ -0,0 +1,276 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Session options understood by the Sample EP
+
+#include "ep_options.h"
+#include "numa.h"
+#include "ort_utils.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+// Look up a session config entry. found is false if no entry exists.
+OrtStatus* GetConfigEntry(const OrtApi* api, const OrtSessionOptions* session_options,
+                          const std::string& config_key, std::string* value, bool* found) {
+    *found = false;
+
+    int has_entry = 0;
+    RETURN_IF_ERROR(api->HasSessionConfigEntry(session_options, config_key.c_str(), &has_entry));
+    if (!has_entry) return nullptr;
+
+    size_t size = 0;
+    RETURN_IF_ERROR(api->GetSessionConfigEntry(session_options, config_key.c_str(), nullptr, &size));
+    std::vector<char> buffer(size + 1, '\0');
+    RETURN_IF_ERROR(api->GetSessionConfigEntry(session_options, config_key.c_str(), buffer.data(), &size));
+
+    *value = buffer.data();
+    *found = true;
+    return nullptr;
+}
+
+// Look up "<prefix><key>" for each accepted prefix. found is false if no entry exists.
+OrtStatus* GetOption(const OrtApi* api, const OrtSessionOptions* session_options,
+                     const std::string& ep_name, const char* key,
+                     std::string* value, bool* found) {
+    std::string long_prefix = "ep.";
+    for (char c : ep_name) long_prefix += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    long_prefix += '.';
+
+    *found = false;
+    for (const std::string& prefix : {long_prefix, std::string("ep.sampleep.")}) {
+        RETURN_IF_ERROR(GetConfigEntry(api, session_options, prefix + key, value, found));
+        if (*found) return nullptr;
+    }
+    return nullptr;
+}
+
+OrtStatus* ParseSize(const OrtApi* api, const char* key, const std::string& value, size_t* out) {
+    errno = 0;
+    char* end = nullptr;
+    unsigned long long parsed = std::strtoull(value.c_str(), &end, 10);
+    if (value.empty() || value[0] == '-' || *end != '\0' || errno != 0) {
+        std::string msg = std::string("Invalid value for EP option '") + key + "': " + value;
+        return api->CreateStatus(ORT_INVALID_ARGUMENT, msg.c_str());
+    }
+    *out = static_cast<size_t>(parsed);
+    return nullptr;
+}
+
+OrtStatus* ParseBool(const OrtApi* api, const char* key, const std::string& value, bool* out) {
+    if (value != "0" && value != "1") {
+        std::string msg = std::string("Invalid value for EP option '") + key + "': " + value;
+        return api->CreateStatus(ORT_INVALID_ARGUMENT, msg.c_str());
+    }
+    *out = value == "1";
+    return nullptr;
+}
+
+OrtStatus* ParseLayout(const OrtApi* api, const char* key, const std::string& value,
+                       OrtEpDataLayout* out) {
+    if (value == "NCHW") {
+        *out = OrtEpDataLayout_NCHW;
+    } else if (value == "NHWC") {
+        *out = OrtEpDataLayout_NHWC;
+    } else {
+        std::string msg = std::string("Invalid value for EP option '") + key + "': " + value +
+                          " (expected NCHW or NHWC)";
+        return api->CreateStatus(ORT_INVALID_ARGUMENT, msg.c_str());
+    }
+    return nullptr;
+}
+
+OrtStatus* ParsePolicy(const OrtApi* api, const char* key, const std::string& value, bool* by_cost) {
+    if (value == "cost" || value == "all") {
+        *by_cost = value == "cost";
+        return nullptr;
+    }
+    std::string msg = std::string("Invalid value for EP option '") + key + "': " + value +
+                      " (expected cost or all)";
+    return api->CreateStatus(ORT_INVALID_ARGUMENT, msg.c_str());
+}
+
+OrtStatus* ParseIsa(const OrtApi* api, const char* key, const std::string& value, Isa* out) {
+    for (Isa isa : {Isa::Scalar, Isa::Sse4, Isa::Avx2, Isa::Avx512, Isa::Neon}) {
+        if (value == IsaName(isa)) {
+            *out = isa;
+            return nullptr;
+        }
+    }
+    std::string msg = std::string("Invalid value for EP option '") + key + "': " + value +
+                      " (expected scalar, sse4, avx2, avx512 or neon)";
+    return api->CreateStatus(ORT_INVALID_ARGUMENT, msg.c_str());
+}
+
+OrtStatus* ParsePriority(const OrtApi* api, const char* key, const std::string& value, ThreadPriority* out) {
+    if (value == "normal" || value == "low") {
+        *out = value == "low" ? ThreadPriority::Low : ThreadPriority::Normal;
+        return nullptr;
+    }
+    std::string msg = std::string("Invalid value for EP option '") + key + "': " + value +
+                      " (expected normal or low)";
+    return api->CreateStatus(ORT_INVALID_ARGUMENT, msg.c_str());
+}
+
+// ============================================================================
+// Option table
+// ============================================================================
+
+using ParseFn = OrtStatus* (*)(const OrtApi* api, const char* key, const std::string& value,
+                               SampleEpOptions* options);
+
+template <size_t SampleEpOptions::*kField>
+OrtStatus* SizeOption(const OrtApi* api, const char* key, const std::string& value, SampleEpOptions* options) {
+    return ParseSize(api, key, value, &(options->*kField));
+}
+
+template <bool SampleEpOptions::*kField>
+OrtStatus* BoolOption(const OrtApi* api, const char* key, const std::string& value, SampleEpOptions* options) {
+    return ParseBool(api, key, value, &(options->*kField));
+}
+
+template <std::string SampleEpOptions::*kField>
+OrtStatus* StringOption(const OrtApi*, const char*, const std::string& value, SampleEpOptions* options) {
+    options->*kField = value;
+    return nullptr;
+}
+
+OrtStatus* LayoutOption(const OrtApi* api, const char* key, const std::string& value, SampleEpOptions* options) {
+    return ParseLayout(api, key, value, &options->preferred_layout);
+}
+
+OrtStatus* PriorityOption(const OrtApi* api, const char* key, const std::string& value, SampleEpOptions* options) {
+    return ParsePriority(api, key, value, &options->thread_priority);
+}
+
+OrtStatus* IsaOption(const OrtApi* api, const char* key, const std::string& value, SampleEpOptions* options) {
+    options->force_isa = true;
+    return ParseIsa(api, key, value, &options->isa);
+}
+
+OrtStatus* PolicyOption(const OrtApi* api, const char* key, const std::string& value, SampleEpOptions* options) {
+    return ParsePolicy(api, key, value, &options->partition_by_cost);
+}
+
+OrtStatus* ProfileFileOption(const OrtApi*, const char*, const std::string& value, SampleEpOptions* options) {
+    if (!value.empty()) options->profile_file = value;
+    return nullptr;
+}
+
+OrtStatus* CostModelOption(const OrtApi* api, const char* key, const std::string& value, SampleEpOptions* options) {
+    if (options->cost_model.Parse(value)) return nullptr;
+    std::string msg = std::string("Invalid value for EP option '") + key + "': " + value;
+    return api->CreateStatus(ORT_INVALID_ARGUMENT, msg.c_str());
+}
+
+OrtStatus* NumaNodeOption(const OrtApi* api, const char* key, const std::string& value, SampleEpOptions* options) {
+    char* end = nullptr;
+    const long node = std::strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || (node != -1 && FindNumaNode(static_cast<int>(node)) == nullptr)) {
+        std::string msg = std::string("Invalid value for EP option '") + key + "': " + value +
+                          " (expected -1 or a NUMA node with CPUs; see the device's numa_nodes metadata)";
+        return api->CreateStatus(ORT_INVALID_ARGUMENT, msg.c_str());
+    }
+    options->numa_node = static_cast<int>(node);
+    return nullptr;
+}
+
+OrtStatus* AllocatorOption(const OrtApi* api, const char* key, const std::string& value, SampleEpOptions* options) {
+    PoolAllocatorOptions& allocator = options->allocator;
+    allocator = PoolAllocatorOptions();
+    if (value == "huge_pages") {
+        allocator.huge_pages = true;
+    } else if (value == "system") {
+        allocator.max_cached_bytes = 0;
+    } else if (value != "pool") {
+        std::string msg = std::string("Invalid value for EP option '") + key + "': " + value +
+                          " (expected pool, huge_pages or system)";
+        return api->CreateStatus(ORT_INVALID_ARGUMENT, msg.c_str());
+    }
+    return nullptr;
+}
+
+struct OptionDef {
+    const char* key;
+    bool dynamic;  // May be changed on a live session through SetEpDynamicOptions
+    ParseFn parse;
+};
+
+const OptionDef kOptions[] = {
+    {"num_threads", true, SizeOption<&SampleEpOptions::num_threads>},
+    {"numa_node", false, NumaNodeOption},
+    {"thread_priority", true, PriorityOption},
+    {"stream_execution", false, BoolOption<&SampleEpOptions::stream_execution>},
+    {"parallel_threshold", false, SizeOption<&SampleEpOptions::parallel_threshold>},
+    {"specialize_after", false, SizeOption<&SampleEpOptions::specialize_after>},
+    {"batch_window_us", false, SizeOption<&SampleEpOptions::batch_window_us>},
+    {"deterministic_reductions", false, BoolOption<&SampleEpOptions::deterministic_reductions>},
+    {"fold_constants", false, BoolOption<&SampleEpOptions::fold_constants>},
+    {"preferred_layout", false, LayoutOption},
+    {"isa", false, IsaOption},
+    {"max_partition_nodes", false, SizeOption<&SampleEpOptions::max_partition_nodes>},
+    {"allocator", false, AllocatorOption},
+    {"enable_profiling", true, BoolOption<&SampleEpOptions::enable_profiling>},
+    {"profile_file", false, ProfileFileOption},
+    {"partition_policy", false, PolicyOption},
+    {"cost_model", false, CostModelOption},
+    {"partition_log", false, BoolOption<&SampleEpOptions::partition_log>},
+    {"program_cache_dir", false, StringOption<&SampleEpOptions::program_cache_dir>},
+};
+
+}  // namespace
+
+OrtStatus* ParseEpOptions(const OrtApi* api, const OrtSessionOptions* session_options,
+                          const std::string& ep_name, SampleEpOptions* options) {
+    if (session_options == nullptr) return nullptr;
+
+    std::string value;
+    bool found = false;
+
+    for (const OptionDef& option : kOptions) {
+        RETURN_IF_ERROR(GetOption(api, session_options, ep_name, option.key, &value, &found));
+        if (found) RETURN_IF_ERROR(option.parse(api, option.key, value, options));
+    }
+
+    options->allocator.numa_node = options->numa_node;
+
+    // Session-wide option set by ORT's model compilation API, not an EP option
+    RETURN_IF_ERROR(GetConfigEntry(api, session_options, "ep.context_enable", &value, &found));
+    if (found) RETURN_IF_ERROR(ParseBool(api, "ep.context_enable", value, &options->ep_context_enable));
+
+    return nullptr;
+}
+
+OrtStatus* ParseDynamicEpOptions(const OrtApi* api, const char* const* keys, const char* const* values,
+                                 size_t num_options, SampleEpOptions* options) {
+    SampleEpOptions updated = *options;
+    for (size_t i = 0; i < num_options; ++i) {
+        if (keys[i] == nullptr || values[i] == nullptr) continue;
+        const std::string key = keys[i];
+        const std::string value = values[i];
+
+        // ORT's standard workload hint: "Efficient" asks EPs to trade speed for power
+        if (key == "ep.dynamic.workload_type") {
+            if (value != "Default" && value != "Efficient") {
+                std::string msg = "Invalid value for 'ep.dynamic.workload_type': " + value +
+                                  " (expected Default or Efficient)";
+                return api->CreateStatus(ORT_INVALID_ARGUMENT, msg.c_str());
+            }
+            updated.thread_priority = value == "Efficient" ? ThreadPriority::Low : ThreadPriority::Normal;
+            continue;
+        }
+
+        for (const OptionDef& option : kOptions) {
+            if (key != option.key) continue;
+            if (!option.dynamic) {
+                std::string msg = "EP option '" + key + "' cannot be changed after the session is created";
+                return api->CreateStatus(ORT_INVALID_ARGUMENT, msg.c_str());
+            }
+            RETURN_IF_ERROR(option.parse(api, option.key, value, &updated));
+        }
+    }
+    *options = updated;
+    return nullptr;
+}
@@ -0,0 +1,335 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Shape-specialized execution plans and their per-partition cache
+
+#include "execution_plan.h"
+#include "row_ops.h"
+
+#include <algorithm>
+
+uint64_t HashShapes(const ShapeRef* shapes, size_t count) {
+    uint64_t h = 0x9E3779B97F4A7C15ull;
+    auto mix = [&h](uint64_t v) {
+        h ^= v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    };
+    for (size_t k = 0; k < count; ++k) {
+        mix(shapes[k].rank);
+        for (size_t d = 0; d < shapes[k].rank; ++d) mix(static_cast<uint64_t>(shapes[k].dims[d]));
+    }
+    // Finish so the low bits used as the slot index depend on every dim
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    return h;
+}
+
+ExecutionPlan::ExecutionPlan() = default;
+ExecutionPlan::~ExecutionPlan() { delete hot.load(std::memory_order_acquire); }
+
+bool ExecutionPlan::Matches(const ShapeRef* shapes, size_t count) const {
+    size_t pos = 0;
+    for (size_t k = 0; k < count; ++k) {
+        if (pos >= key.size() || key[pos] != static_cast<int64_t>(shapes[k].rank)) return false;
+        if (pos + 1 + shapes[k].rank > key.size()) return false;
+        if (!std::equal(shapes[k].dims, shapes[k].dims + shapes[k].rank, key.begin() + pos + 1)) {
+            return false;
+        }
+        pos += 1 + shapes[k].rank;
+    }
+    return pos == key.size();
+}
+
+namespace {
+
+// Give each intermediate register a scratch tile for as long as it is live. A source's tile is
+// released at its last read; the instruction doing that read may take it over and compute in
+// place when the element size and the scalar kind match, since every kernel reads element i
+// before writing it. Otherwise released tiles only become available to later instructions.
+void AssignTiles(const ExprProgram& program, ExecutionPlan* plan) {
+    constexpr uint16_t kNoTile = ExecutionPlan::kNoTile;
+    constexpr size_t kNotRead = SIZE_MAX;
+
+    std::vector<size_t> last_read(program.num_registers, kNotRead);
+    for (size_t i = 0; i < program.code.size(); ++i) {
+        const Instr& instr = program.code[i];
+        for (size_t k = 0; k < OpArity(instr.op); ++k) last_read[instr.src[k]] = i;
+    }
+    std::vector<uint8_t> is_output(program.num_registers, 0);
+    for (uint32_t out_reg : program.outputs) is_output[out_reg] = 1;
+
+    plan->tile.assign(program.num_registers, kNoTile);
+    plan->num_tiles = 0;
+    std::vector<uint16_t> free_tiles;
+    std::vector<uint16_t> released;
+    for (size_t i = 0; i < program.code.size(); ++i) {
+        const Instr& instr = program.code[i];
+        const uint32_t dst = instr.dst;
+
+        uint16_t in_place = kNoTile;
+        released.clear();
+        for (size_t k = 0; k < OpArity(instr.op); ++k) {
+            const uint32_t src = instr.src[k];
+            const uint16_t tile = plan->tile[src];
+            if (tile == kNoTile || last_read[src] != i ||
+                std::find(released.begin(), released.end(), tile) != released.end()) {
+                continue;  // No tile, read again later, or already released (Mul(t, t))
+            }
+            released.push_back(tile);
+            if (in_place == kNoTile && !is_output[dst] && plan->scalar[src] == plan->scalar[dst] &&
+                DataTypeSize(program.types[src]) == DataTypeSize(program.types[dst])) {
+                in_place = tile;
+            }
+        }
+
+        if (!is_output[dst]) {
+            if (in_place != kNoTile) {
+                plan->tile[dst] = in_place;
+            } else if (!free_tiles.empty()) {
+                plan->tile[dst] = free_tiles.back();
+                free_tiles.pop_back();
+            } else {
+                plan->tile[dst] = static_cast<uint16_t>(plan->num_tiles++);
+            }
+        }
+        for (uint16_t tile : released) {
+            if (tile != plan->tile[dst]) free_tiles.push_back(tile);
+        }
+
+        // A result nobody reads frees its tile straight away
+        if (plan->tile[dst] != kNoTile && last_read[dst] == kNotRead) free_tiles.push_back(plan->tile[dst]);
+    }
+}
+
+// The kernel for one elementwise instruction, given which registers hold a single value per
+// row. With `full_tile`, its fixed-length variant where there is one; instructions computing
+// a single value always take the generic kernel, which they run over one element.
+Kernel SelectKernel(const ExprProgram& program, const Instr& instr, const std::vector<uint8_t>& scalar,
+                    const KernelTable& kernels, bool full_tile) {
+    const auto op = static_cast<size_t>(instr.op);
+    const DataType type = program.types[instr.src[instr.op == OpCode::Where ? 1 : 0]];
+    const TypedKernels& typed = kernels.For(type);
+    full_tile = full_tile && !scalar[instr.dst];
+
+    if (IsBinaryOp(instr.op)) {
+        const bool scalar_a = scalar[instr.src[0]];
+        const bool scalar_b = scalar[instr.src[1]];
+        Operands operands = Operands::VectorVector;
+        if (scalar_a != scalar_b) operands = scalar_b ? Operands::VectorScalar : Operands::ScalarVector;
+        const auto epilogue = static_cast<size_t>(instr.epilogue);
+        const auto kind = static_cast<size_t>(operands);
+        if (full_tile && op < kNumVectorOps) return typed.tile_binary[op][epilogue][kind];
+        return typed.binary[op][epilogue][kind];
+    }
+    if (IsUnaryOp(instr.op)) {
+        return full_tile ? typed.tile_unary[op - kFirstUnaryOp] : typed.unary[op - kFirstUnaryOp];
+    }
+    if (instr.op == OpCode::Where) {
+        size_t mask = 0;
+        for (size_t k = 0; k < 3; ++k) mask |= size_t(scalar[instr.src[k]]) << k;
+        return typed.where[mask];
+    }
+    return typed.cast[static_cast<size_t>(program.types[instr.dst])];
+}
+
+}  // namespace
+
+PlanStatus BuildExecutionPlan(const ExprProgram& program, const KernelTable& kernels,
+                              const ShapeRef* shapes, const PlanOptions& options,
+                              ExecutionPlan* plan) {
+    plan->key.clear();
+    for (size_t k = 0; k < program.num_inputs; ++k) {
+        plan->key.push_back(static_cast<int64_t>(shapes[k].rank));
+        plan->key.insert(plan->key.end(), shapes[k].dims, shapes[k].dims + shapes[k].rank);
+    }
+    plan->key_hash = HashShapes(shapes, program.num_inputs);
+
+    if (FindRowInstr(program) < program.code.size()) {
+        return BuildRowPlan(program, kernels, shapes, options, plan);
+    }
+
+    std::vector<ShapeRef> inputs(shapes, shapes + program.num_inputs);
+    if (!ComputeBroadcastPlan(inputs, &plan->broadcast)) {
+        return PlanStatus::IncompatibleShapes;
+    }
+    const BroadcastPlan& bcast = plan->broadcast;
+
+    // Inputs no instruction reads, such as constants folded at compile time, still shape the
+    // output but are neither replicated nor counted as streams
+    std::vector<uint8_t> read(program.num_inputs, 0);
+    for (const Instr& instr : program.code) {
+        for (size_t k = 0; k < OpArity(instr.op); ++k) {
+            if (instr.src[k] < program.num_inputs) read[instr.src[k]] = 1;
+        }
+    }
+    for (uint32_t k = 0; k < program.num_inputs; ++k) {
+        if (!read[k]) plan->broadcast.replicate[k] = 0;
+    }
+
+    // Every output must cover the whole iteration space, since outputs are written densely
+    std::vector<std::vector<int64_t>> register_shapes(program.num_registers);
+    for (uint32_t r = 0; r < program.num_inputs; ++r) {
+        register_shapes[r].assign(shapes[r].dims, shapes[r].dims + shapes[r].rank);
+    }
+    for (const Instr& instr : program.code) {
+        std::vector<int64_t>& shape = register_shapes[instr.dst];
+        shape = register_shapes[instr.src[0]];
+        for (size_t k = 1; k < OpArity(instr.op); ++k) {
+            std::vector<int64_t> operand = std::move(shape);
+            if (!BroadcastShapes(operand, register_shapes[instr.src[k]], &shape)) {
+                return PlanStatus::IncompatibleShapes;
+            }
+        }
+    }
+    for (uint32_t out_reg : program.outputs) {
+        if (register_shapes[out_reg] != bcast.output_dims) {
+            return PlanStatus::UnsupportedShapes;
+        }
+    }
+
+    // Inputs broadcast along the inner dim hold one value per row, and so does anything
+    // computed only from them
+    plan->scalar.assign(program.num_registers, 0);
+    for (uint32_t r = 0; r < program.num_inputs; ++r) {
+        plan->scalar[r] = bcast.inner > 1 && bcast.inner_stride[r] == 0;
+    }
+    for (const Instr& instr : program.code) {
+        uint8_t scalar = 1;
+        for (size_t k = 0; k < OpArity(instr.op); ++k) scalar &= plan->scalar[instr.src[k]];
+        plan->scalar[instr.dst] = scalar;
+    }
+
+    // Pick each instruction's kernel now so the executor never dispatches on type. An
+    // instruction whose operands are all scalar runs the vector form over one element.
+    plan->kernels.clear();
+    for (const Instr& instr : program.code) {
+        plan->kernels.push_back(SelectKernel(program, instr, plan->scalar, kernels, false));
+    }
+
+    AssignTiles(program, plan);
+
+    plan->replicated_bytes = 0;
+    for (uint32_t k = 0; k < program.num_inputs; ++k) {
+        if (bcast.replicate[k]) plan->replicated_bytes += bcast.inner * DataTypeSize(program.types[k]);
+    }
+
+    // Split large partitions into chunks sized so each one's input and output streams fit in
+    // a core's L2
+    constexpr size_t kChunkBytes = 256 * 1024;
+    size_t bytes_per_element = 0;
+    for (uint32_t k = 0; k < program.num_inputs; ++k) {
+        if (read[k]) bytes_per_element += DataTypeSize(program.types[k]);
+    }
+    for (uint32_t out_reg : program.outputs) bytes_per_element += DataTypeSize(program.types[out_reg]);
+    plan->chunk_elements = bcast.total;
+    plan->num_chunks = 1;
+    if (bcast.total >= options.parallel_threshold) {
+        plan->chunk_elements =
+            std::max(kTileElements, kChunkBytes / bytes_per_element / kTileElements * kTileElements);
+        plan->num_chunks = (bcast.total + plan->chunk_elements - 1) / plan->chunk_elements;
+    }
+    return PlanStatus::Ok;
+}
+
+void ReplicateInputs(const ExprProgram& program, const ExecutionPlan& plan, const void** inputs,
+                     char* replicated) {
+    const BroadcastPlan& bcast = plan.broadcast;
+    for (size_t k = 0; k < program.num_inputs; ++k) {
+        if (!bcast.replicate[k]) continue;
+        const size_t elem_size = DataTypeSize(program.types[k]);
+        ReplicateRows(inputs[k], bcast.inner / bcast.repeat * elem_size, bcast.repeat, replicated);
+        inputs[k] = replicated;
+        replicated += bcast.inner * elem_size;
+    }
+}
+
+void RecordPlanCall(const ExprProgram& program, const KernelTable& kernels, size_t hot_calls,
+                    const ExecutionPlan& plan) {
+    if (hot_calls == 0 || plan.row || plan.hot.load(std::memory_order_acquire) != nullptr) return;
+
+    // Exactly one call sees the count reach hot_calls; it builds and publishes the hot path
+    // while calls running meanwhile stay on the generic one
+    if (plan.calls.fetch_add(1, std::memory_order_relaxed) + 1 != hot_calls) return;
+
+    auto hot = std::make_unique<HotPath>();
+    for (const Instr& instr : program.code) {
+        hot->tile_kernels.push_back(SelectKernel(program, instr, plan.scalar, kernels, true));
+    }
+
+    const BroadcastPlan& bcast = plan.broadcast;
+    const size_t rows = bcast.inner > 0 ? bcast.total / bcast.inner : 0;
+    if (rows * program.num_inputs <= kMaxRowOffsets) {
+        hot->row_offsets.resize(rows * program.num_inputs);
+        std::vector<size_t> index(bcast.outer_dims.size(), 0);
+        for (size_t row = 0; row < rows; ++row) {
+            for (uint32_t k = 0; k < program.num_inputs; ++k) {
+                size_t offset = 0;
+                for (size_t d = 0; d < index.size(); ++d) offset += index[d] * bcast.outer_strides[k][d];
+                hot->row_offsets[row * program.num_inputs + k] = offset;
+            }
+            for (size_t d = index.size(); d-- > 0;) {
+                if (++index[d] < bcast.outer_dims[d]) break;
+                index[d] = 0;
+            }
+        }
+    }
+    plan.hot.store(hot.release(), std::memory_order_release);
+}
+
+PlanCache::~PlanCache() {
+    // Every plan is in the newest table
+    if (!tables_.empty()) {
+        const Table& table = *tables_.back();
+        for (size_t i = 0; i <= table.mask; ++i) delete table.slots[i].load(std::memory_order_relaxed);
+    }
+}
+
+const ExecutionPlan* PlanCache::Find(const ShapeRef* shapes, size_t count) const {
+    const Table* table = table_.load(std::memory_order_acquire);
+    if (table == nullptr) return nullptr;
+
+    const uint64_t hash = HashShapes(shapes, count);
+    for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+        const ExecutionPlan* plan = table->slots[i].load(std::memory_order_acquire);
+        if (plan == nullptr) return nullptr;
+        if (plan->key_hash == hash && plan->Matches(shapes, count)) return plan;
+    }
+}
+
+const ExecutionPlan* PlanCache::Insert(std::unique_ptr<ExecutionPlan>& plan) {
+    std::lock_guard<std::mutex> lock(insert_mutex_);
+    Table* table = tables_.empty() ? nullptr : tables_.back().get();
+
+    // Another thread may have published the same shapes first
+    if (table != nullptr) {
+        for (size_t i = plan->key_hash & table->mask;; i = (i + 1) & table->mask) {
+            const ExecutionPlan* cached = table->slots[i].load(std::memory_order_relaxed);
+            if (cached == nullptr) break;
+            if (cached->key_hash == plan->key_hash && cached->key == plan->key) return cached;
+        }
+        if (table->size >= kCapacity) return nullptr;
+    }
+
+    auto place = [](Table* t, const ExecutionPlan* p) {
+        size_t i = p->key_hash & t->mask;
+        while (t->slots[i].load(std::memory_order_relaxed) != nullptr) i = (i + 1) & t->mask;
+        t->slots[i].store(p, std::memory_order_release);
+        t->size++;
+    };
+
+    // Grow before the table gets more than half full; readers keep using the old one until
+    // the new pointer is published, which happens after the copy is complete
+    if (table == nullptr || 2 * (table->size + 1) > table->mask + 1) {
+        auto grown = std::make_unique<Table>(table == nullptr ? 8 : 2 * (table->mask + 1));
+        if (table != nullptr) {
+            for (size_t i = 0; i <= table->mask; ++i) {
+                if (const ExecutionPlan* p = table->slots[i].load(std::memory_order_relaxed)) place(grown.get(), p);
+            }
+        }
+        table = grown.get();
+        tables_.push_back(std::move(grown));
+        place(table, plan.get());
+        table_.store(table, std::memory_order_release);
+    } else {
+        place(table, plan.get());
+    }
+    return plan.release();
+}
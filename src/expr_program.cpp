@@ -0,0 +1,200 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Tiled executor for compiled expression programs
+
+#include "expr_program.h"
+#include "execution_plan.h"
+
+#include <algorithm>
+
+namespace {
+
+// Per-thread register file, reused across calls so the hot path does not allocate
+struct RegisterFile {
+    std::vector<const char*> read;   // Where each register is read from
+    std::vector<char*> write;        // Where each non-input register is written to
+    std::vector<char> scratch;       // Tiles for intermediate registers, as assigned by the plan
+
+    std::vector<size_t> size;        // Element size of each register
+
+    std::vector<size_t> index;       // Position of the current row in the outer dims
+    std::vector<size_t> offset;      // Element offset of the current row, per input
+
+    size_t tile_bytes = 0;
+
+    void Prepare(const ExprProgram& program, const ExecutionPlan& exec_plan) {
+        const BroadcastPlan& plan = exec_plan.broadcast;
+        size.resize(program.num_registers);
+        size_t widest = 1;
+        for (uint32_t r = 0; r < program.num_registers; ++r) {
+            size[r] = DataTypeSize(program.types[r]);
+            widest = std::max(widest, size[r]);
+        }
+        tile_bytes = kTileElements * widest;
+        read.assign(program.num_registers, nullptr);
+        write.assign(program.num_registers, nullptr);
+        scratch.resize(exec_plan.num_tiles * tile_bytes + 64);
+        index.assign(plan.outer_dims.size(), 0);
+        offset.assign(program.num_inputs, 0);
+    }
+
+    // Scratch tile number `index`, aligned to a 64-byte cache line
+    char* Tile(size_t tile) {
+        auto addr = reinterpret_cast<uintptr_t>(scratch.data());
+        auto aligned = reinterpret_cast<char*>((addr + 63) & ~uintptr_t(63));
+        return aligned + tile * tile_bytes;
+    }
+};
+
+}  // namespace
+
+bool IsSupportedInstr(OpCode op, Activation epilogue, const DataType* src, DataType dst) {
+    if (static_cast<size_t>(op) >= kNumOpCodes || static_cast<size_t>(epilogue) >= kNumActivations) {
+        return false;
+    }
+    const DataType type = op == OpCode::Where ? src[1] : src[0];
+    if (!HasKernel(op, type)) return false;
+    if (epilogue != Activation::None && !HasEpilogue(op, type)) return false;
+
+    switch (op) {
+        case OpCode::Where:
+            return src[0] == DataType::Bool && src[2] == type && dst == type;
+        case OpCode::Cast:
+            return true;
+        default:
+            if ((IsBinaryOp(op) || op == OpCode::MatMul) && src[1] != type) return false;
+            return dst == (IsCompareOp(op) ? DataType::Bool : type);
+    }
+}
+
+size_t FindRowInstr(const ExprProgram& program) {
+    for (size_t i = 0; i < program.code.size(); ++i) {
+        if (IsRowOp(program.code[i].op)) return i;
+    }
+    return program.code.size();
+}
+
+bool ValidateProgram(const ExprProgram& program) {
+    if (program.num_inputs == 0 || program.code.empty() || program.outputs.empty()) return false;
+    if (program.num_registers != program.num_inputs + program.code.size()) return false;
+    if (program.types.size() != program.num_registers) return false;
+    for (DataType type : program.types) {
+        if (static_cast<size_t>(type) >= kNumDataTypes) return false;
+    }
+
+    size_t row_instrs = 0;
+    for (size_t i = 0; i < program.code.size(); ++i) {
+        const Instr& instr = program.code[i];
+        if (instr.dst != program.num_inputs + i) return false;
+        if (static_cast<size_t>(instr.op) >= kNumOpCodes) return false;
+        if (IsRowOp(instr.op) && ++row_instrs > 1) return false;
+        if (instr.op == OpCode::MatMul && instr.src[1] >= program.num_inputs) return false;
+
+        DataType src_types[3];
+        for (size_t k = 0; k < OpArity(instr.op); ++k) {
+            if (instr.src[k] >= instr.dst) return false;
+            src_types[k] = program.types[instr.src[k]];
+        }
+        for (size_t k = OpArity(instr.op); k < 3; ++k) {
+            if (instr.src[k] != 0) return false;
+        }
+        if (!IsSupportedInstr(instr.op, instr.epilogue, src_types, program.types[instr.dst])) return false;
+    }
+    for (uint32_t reg : program.outputs) {
+        if (reg < program.num_inputs || reg >= program.num_registers) return false;
+    }
+    return program.row.axis_begin <= program.row.axis_end;
+}
+
+void ExecuteProgram(const ExprProgram& program, const ExecutionPlan& exec_plan,
+                    const void* const* inputs, void* const* outputs, size_t begin, size_t end) {
+    if (begin >= end) return;  // Empty outputs may have an empty inner dim
+
+    const BroadcastPlan& plan = exec_plan.broadcast;
+    const uint8_t* scalar = exec_plan.scalar.data();
+    const Kernel* kernels = exec_plan.kernels.data();
+    const size_t inner = plan.inner;
+
+    // Hot plans run full tiles through fixed-length kernels and look row offsets up
+    const HotPath* hot = exec_plan.hot.load(std::memory_order_acquire);
+    const Kernel* tile_kernels = hot ? hot->tile_kernels.data() : kernels;
+    const size_t* row_offsets = hot && !hot->row_offsets.empty() ? hot->row_offsets.data() : nullptr;
+
+    static thread_local RegisterFile regs;
+    regs.Prepare(program, exec_plan);
+    const size_t* size = regs.size.data();
+
+    // Outputs are written in place; all other computed registers use their scratch tile
+    for (uint32_t r = program.num_inputs; r < program.num_registers; ++r) {
+        if (exec_plan.tile[r] != ExecutionPlan::kNoTile) regs.write[r] = regs.Tile(exec_plan.tile[r]);
+    }
+
+    // Locate the row containing `begin`
+    const size_t num_outer = plan.outer_dims.size();
+    size_t row = begin / inner;
+    size_t col = begin % inner;
+    if (row_offsets == nullptr) {
+        size_t rest = row;
+        for (size_t d = num_outer; d-- > 0;) {
+            regs.index[d] = rest % plan.outer_dims[d];
+            rest /= plan.outer_dims[d];
+        }
+        for (uint32_t k = 0; k < program.num_inputs; ++k) {
+            for (size_t d = 0; d < num_outer; ++d) {
+                regs.offset[k] += regs.index[d] * plan.outer_strides[k][d];
+            }
+        }
+    }
+
+    auto run_tile = [&](const Kernel* tile_code, size_t n) {
+        for (size_t i = 0; i < program.code.size(); ++i) {
+            const Instr& instr = program.code[i];
+            char* out = regs.write[instr.dst];
+            const void* src[3] = {regs.read[instr.src[0]], regs.read[instr.src[1]],
+                                  regs.read[instr.src[2]]};
+            tile_code[i](src, out, scalar[instr.dst] ? 1 : n);
+            regs.read[instr.dst] = out;
+        }
+
+        // Advance the registers that stream through memory to the next tile
+        for (uint32_t k = 0; k < program.num_inputs; ++k) {
+            if (!scalar[k]) regs.read[k] += n * size[k];
+        }
+        for (uint32_t out_reg : program.outputs) {
+            regs.write[out_reg] += n * size[out_reg];
+        }
+    };
+
+    for (size_t e = begin; e < end;) {
+        const size_t len = std::min(inner - col, end - e);
+        const size_t* offset = row_offsets ? row_offsets + row * program.num_inputs : regs.offset.data();
+
+        for (uint32_t k = 0; k < program.num_inputs; ++k) {
+            const size_t first = offset[k] + (plan.inner_stride[k] ? col : 0);
+            regs.read[k] = static_cast<const char*>(inputs[k]) + first * size[k];
+        }
+        for (size_t k = 0; k < program.outputs.size(); ++k) {
+            const uint32_t out_reg = program.outputs[k];
+            regs.write[out_reg] = static_cast<char*>(outputs[k]) + e * size[out_reg];
+        }
+
+        // Full tiles, then the remainder peeled off the end of the row
+        const size_t full = len - len % kTileElements;
+        for (size_t t = 0; t < full; t += kTileElements) run_tile(tile_kernels, kTileElements);
+        if (full < len) run_tile(kernels, len - full);
+
+        e += len;
+        col = 0;
+        ++row;
+        if (row_offsets != nullptr) continue;
+
+        // Step to the next row
+        for (size_t d = num_outer; d-- > 0;) {
+            for (uint32_t k = 0; k < program.num_inputs; ++k) regs.offset[k] += plan.outer_strides[k][d];
+            if (++regs.index[d] < plan.outer_dims[d]) break;
+            for (uint32_t k = 0; k < program.num_inputs; ++k) {
+                regs.offset[k] -= plan.outer_strides[k][d] * plan.outer_dims[d];
+            }
+            regs.index[d] = 0;
+        }
+    }
+}
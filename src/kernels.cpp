@@ -0,0 +1,121 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Runtime ISA detection and kernel table selection
+
+#include "kernels.h"
+
+#if defined(SAMPLE_EP_X86_KERNELS) && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+#if defined(SAMPLE_EP_NEON_KERNELS) && defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+namespace {
+
+#if defined(SAMPLE_EP_X86_KERNELS)
+bool CpuSupports(Isa isa) {
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0);
+    const int max_leaf = regs[0];
+
+    __cpuid(regs, 1);
+    const bool sse41 = (regs[2] & (1 << 19)) != 0;
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx = (regs[2] & (1 << 28)) != 0;
+    const bool fma = (regs[2] & (1 << 12)) != 0;
+    const bool f16c = (regs[2] & (1 << 29)) != 0;
+
+    // The OS must save the YMM (and for AVX-512, opmask/ZMM) state on context switch
+    const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    const bool os_ymm = (xcr0 & 0x6) == 0x6;
+    const bool os_zmm = (xcr0 & 0xE6) == 0xE6;
+
+    bool avx2 = false;
+    bool avx512 = false;
+    if (max_leaf >= 7) {
+        __cpuidex(regs, 7, 0);
+        const auto ebx = static_cast<unsigned>(regs[1]);
+        avx2 = (ebx & (1u << 5)) != 0;
+        // F, DQ, BW and VL: everything /arch:AVX512 lets the compiler emit
+        avx512 = (ebx & (1u << 16)) != 0 && (ebx & (1u << 17)) != 0 && (ebx & (1u << 30)) != 0 &&
+                 (ebx & (1u << 31)) != 0;
+    }
+
+    switch (isa) {
+        case Isa::Sse4: return sse41;
+        case Isa::Avx2: return avx && avx2 && fma && f16c && os_ymm;
+        case Isa::Avx512: return avx512 && avx2 && fma && f16c && os_ymm && os_zmm;
+        default: return false;
+    }
+#else
+    // libgcc/compiler-rt also check that the OS enables the extended register state
+    __builtin_cpu_init();
+    switch (isa) {
+        case Isa::Sse4: return __builtin_cpu_supports("sse4.1");
+        case Isa::Avx2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+                   __builtin_cpu_supports("f16c");
+        case Isa::Avx512:
+            // Every extension kernels_avx512.cpp is built with, so none of its code can fault
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+                   __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl") &&
+                   __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c");
+        default: return false;
+    }
+#endif
+}
+#endif
+
+#if defined(SAMPLE_EP_NEON_KERNELS)
+bool CpuSupports(Isa isa) {
+    if (isa != Isa::Neon) return false;
+#if defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#else
+    return true;  // Advanced SIMD is mandatory on AArch64
+#endif
+}
+#endif
+
+}  // namespace
+
+Isa DetectIsa() {
+#if defined(SAMPLE_EP_X86_KERNELS)
+    for (Isa isa : {Isa::Avx512, Isa::Avx2, Isa::Sse4}) {
+        if (CpuSupports(isa)) return isa;
+    }
+#elif defined(SAMPLE_EP_NEON_KERNELS)
+    if (CpuSupports(Isa::Neon)) return Isa::Neon;
+#endif
+    return Isa::Scalar;
+}
+
+const KernelTable* GetKernelTable(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar:
+            return &GetScalarKernelTable();
+#if defined(SAMPLE_EP_X86_KERNELS)
+        case Isa::Sse4:
+            return CpuSupports(isa) ? &GetSse4KernelTable() : nullptr;
+        case Isa::Avx2:
+            return CpuSupports(isa) ? &GetAvx2KernelTable() : nullptr;
+        case Isa::Avx512:
+            return CpuSupports(isa) ? &GetAvx512KernelTable() : nullptr;
+#endif
+#if defined(SAMPLE_EP_NEON_KERNELS)
+        case Isa::Neon:
+            return CpuSupports(isa) ? &GetNeonKernelTable() : nullptr;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+const KernelTable& SelectKernelTable() {
+    const KernelTable* table = GetKernelTable(DetectIsa());
+    return table != nullptr ? *table : GetScalarKernelTable();
+}
@@ -0,0 +1,55 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// AVX2 kernels. Built with AVX2/FMA/F16C enabled; only called when the CPU supports them.
+
+#include "kernels_impl.h"
+
+#include <immintrin.h>
+
+namespace {
+
+struct Avx2Traits {
+    using Elem = float;
+    using V = __m256;
+    static constexpr size_t kWidth = 8;
+
+    static V Load(const float* p) { return _mm256_loadu_ps(p); }
+    static void Store(float* p, V v) { _mm256_storeu_ps(p, v); }
+    static V Add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static V Div(V a, V b) { return _mm256_div_ps(a, b); }
+};
+
+struct Avx2DoubleTraits {
+    using Elem = double;
+    using V = __m256d;
+    static constexpr size_t kWidth = 4;
+
+    static V Load(const double* p) { return _mm256_loadu_pd(p); }
+    static void Store(double* p, V v) { _mm256_storeu_pd(p, v); }
+    static V Add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V Sub(V a, V b) { return _mm256_sub_pd(a, b); }
+    static V Mul(V a, V b) { return _mm256_mul_pd(a, b); }
+    static V Div(V a, V b) { return _mm256_div_pd(a, b); }
+};
+
+// fp16 converted with F16C and computed in float
+struct Avx2HalfTraits : Avx2Traits {
+    using Elem = uint16_t;
+    using Compute = Avx2Traits;
+
+    static V Load(const uint16_t* p) {
+        return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+    static void Store(uint16_t* p, V v) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+    }
+};
+
+}  // namespace
+
+const KernelTable& GetAvx2KernelTable() {
+    static const KernelTable table =
+        MakeKernelTable<Avx2Traits, Avx2DoubleTraits, Avx2HalfTraits>(Isa::Avx2, "avx2");
+    return table;
+}
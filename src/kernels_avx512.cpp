@@ -0,0 +1,56 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// AVX-512 kernels. Built with AVX-512F/BW/DQ/VL, FMA and F16C enabled; only called when the CPU
+// supports all of them (see CpuSupports in kernels.cpp).
+
+#include "kernels_impl.h"
+
+#include <immintrin.h>
+
+namespace {
+
+struct Avx512Traits {
+    using Elem = float;
+    using V = __m512;
+    static constexpr size_t kWidth = 16;
+
+    static V Load(const float* p) { return _mm512_loadu_ps(p); }
+    static void Store(float* p, V v) { _mm512_storeu_ps(p, v); }
+    static V Add(V a, V b) { return _mm512_add_ps(a, b); }
+    static V Sub(V a, V b) { return _mm512_sub_ps(a, b); }
+    static V Mul(V a, V b) { return _mm512_mul_ps(a, b); }
+    static V Div(V a, V b) { return _mm512_div_ps(a, b); }
+};
+
+struct Avx512DoubleTraits {
+    using Elem = double;
+    using V = __m512d;
+    static constexpr size_t kWidth = 8;
+
+    static V Load(const double* p) { return _mm512_loadu_pd(p); }
+    static void Store(double* p, V v) { _mm512_storeu_pd(p, v); }
+    static V Add(V a, V b) { return _mm512_add_pd(a, b); }
+    static V Sub(V a, V b) { return _mm512_sub_pd(a, b); }
+    static V Mul(V a, V b) { return _mm512_mul_pd(a, b); }
+    static V Div(V a, V b) { return _mm512_div_pd(a, b); }
+};
+
+// fp16 converted with the AVX-512F forms of the F16C instructions and computed in float
+struct Avx512HalfTraits : Avx512Traits {
+    using Elem = uint16_t;
+    using Compute = Avx512Traits;
+
+    static V Load(const uint16_t* p) {
+        return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+    }
+    static void Store(uint16_t* p, V v) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm512_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+    }
+};
+
+}  // namespace
+
+const KernelTable& GetAvx512KernelTable() {
+    static const KernelTable table =
+        MakeKernelTable<Avx512Traits, Avx512DoubleTraits, Avx512HalfTraits>(Isa::Avx512, "avx512");
+    return table;
+}
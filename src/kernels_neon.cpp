@@ -0,0 +1,51 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// NEON kernels for AArch64, where Advanced SIMD is part of the baseline.
+
+#include "kernels_impl.h"
+
+#include <arm_neon.h>
+
+namespace {
+
+struct NeonTraits {
+    using Elem = float;
+    using V = float32x4_t;
+    static constexpr size_t kWidth = 4;
+
+    static V Load(const float* p) { return vld1q_f32(p); }
+    static void Store(float* p, V v) { vst1q_f32(p, v); }
+    static V Add(V a, V b) { return vaddq_f32(a, b); }
+    static V Sub(V a, V b) { return vsubq_f32(a, b); }
+    static V Mul(V a, V b) { return vmulq_f32(a, b); }
+    static V Div(V a, V b) { return vdivq_f32(a, b); }
+};
+
+struct NeonDoubleTraits {
+    using Elem = double;
+    using V = float64x2_t;
+    static constexpr size_t kWidth = 2;
+
+    static V Load(const double* p) { return vld1q_f64(p); }
+    static void Store(double* p, V v) { vst1q_f64(p, v); }
+    static V Add(V a, V b) { return vaddq_f64(a, b); }
+    static V Sub(V a, V b) { return vsubq_f64(a, b); }
+    static V Mul(V a, V b) { return vmulq_f64(a, b); }
+    static V Div(V a, V b) { return vdivq_f64(a, b); }
+};
+
+// fp16 converted with the baseline FCVTL/FCVTN instructions and computed in float
+struct NeonHalfTraits : NeonTraits {
+    using Elem = uint16_t;
+    using Compute = NeonTraits;
+
+    static V Load(const uint16_t* p) { return vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(p))); }
+    static void Store(uint16_t* p, V v) { vst1_u16(p, vreinterpret_u16_f16(vcvt_f16_f32(v))); }
+};
+
+}  // namespace
+
+const KernelTable& GetNeonKernelTable() {
+    static const KernelTable table =
+        MakeKernelTable<NeonTraits, NeonDoubleTraits, NeonHalfTraits>(Isa::Neon, "neon");
+    return table;
+}
@@ -0,0 +1,28 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Portable kernels, built for the baseline target
+
+#include "kernels_impl.h"
+
+namespace {
+
+template <class E>
+struct ScalarTraits {
+    using Elem = E;
+    using V = E;
+    static constexpr size_t kWidth = 1;
+
+    static V Load(const E* p) { return *p; }
+    static void Store(E* p, V v) { *p = v; }
+    static V Add(V a, V b) { return a + b; }
+    static V Sub(V a, V b) { return a - b; }
+    static V Mul(V a, V b) { return a * b; }
+    static V Div(V a, V b) { return a / b; }
+};
+
+}  // namespace
+
+const KernelTable& GetScalarKernelTable() {
+    static const KernelTable table =
+        MakeKernelTable<ScalarTraits<float>, ScalarTraits<double>>(Isa::Scalar, "scalar");
+    return table;
+}
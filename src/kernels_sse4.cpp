@@ -0,0 +1,42 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// SSE4.1 kernels. Built with SSE4.1 enabled; only called when the CPU supports it.
+
+#include "kernels_impl.h"
+
+#include <smmintrin.h>
+
+namespace {
+
+struct Sse4Traits {
+    using Elem = float;
+    using V = __m128;
+    static constexpr size_t kWidth = 4;
+
+    static V Load(const float* p) { return _mm_loadu_ps(p); }
+    static void Store(float* p, V v) { _mm_storeu_ps(p, v); }
+    static V Add(V a, V b) { return _mm_add_ps(a, b); }
+    static V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static V Div(V a, V b) { return _mm_div_ps(a, b); }
+};
+
+struct Sse4DoubleTraits {
+    using Elem = double;
+    using V = __m128d;
+    static constexpr size_t kWidth = 2;
+
+    static V Load(const double* p) { return _mm_loadu_pd(p); }
+    static void Store(double* p, V v) { _mm_storeu_pd(p, v); }
+    static V Add(V a, V b) { return _mm_add_pd(a, b); }
+    static V Sub(V a, V b) { return _mm_sub_pd(a, b); }
+    static V Mul(V a, V b) { return _mm_mul_pd(a, b); }
+    static V Div(V a, V b) { return _mm_div_pd(a, b); }
+};
+
+}  // namespace
+
+const KernelTable& GetSse4KernelTable() {
+    static const KernelTable table =
+        MakeKernelTable<Sse4Traits, Sse4DoubleTraits>(Isa::Sse4, "sse4");
+    return table;
+}
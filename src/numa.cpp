@@ -0,0 +1,153 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// NUMA topology discovery, thread pinning and memory placement
+
+#include "numa.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#if defined(__linux__)
+// From <linux/mempolicy.h>, which is not always installed
+constexpr int kMpolPreferred = 1;
+constexpr unsigned kMpolMfMove = 1u << 1;
+
+std::vector<NumaNode> ReadSysfsNodes() {
+    std::vector<NumaNode> nodes;
+    DIR* dir = opendir("/sys/devices/system/node");
+    if (dir == nullptr) return nodes;
+
+    while (dirent* entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name.size() <= 4 || name.compare(0, 4, "node") != 0 ||
+            name.find_first_not_of("0123456789", 4) != std::string::npos) {
+            continue;
+        }
+
+        std::ifstream file("/sys/devices/system/node/" + name + "/cpulist");
+        std::string list;
+        NumaNode node{std::atoi(name.c_str() + 4), {}};
+        if (std::getline(file, list) && ParseCpuList(list, &node.cpus) && !node.cpus.empty()) {
+            nodes.push_back(std::move(node));
+        }
+    }
+    closedir(dir);
+
+    std::sort(nodes.begin(), nodes.end(), [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+    return nodes;
+}
+#endif
+
+std::vector<NumaNode> DiscoverNumaNodes() {
+    std::vector<NumaNode> nodes;
+#if defined(__linux__)
+    nodes = ReadSysfsNodes();
+#endif
+    if (nodes.empty()) {
+        NumaNode all{0, {}};
+        const int count = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        for (int cpu = 0; cpu < count; ++cpu) all.cpus.push_back(cpu);
+        nodes.push_back(std::move(all));
+    }
+    return nodes;
+}
+
+}  // namespace
+
+const std::vector<NumaNode>& GetNumaNodes() {
+    static const std::vector<NumaNode> nodes = DiscoverNumaNodes();
+    return nodes;
+}
+
+const NumaNode* FindNumaNode(int id) {
+    for (const NumaNode& node : GetNumaNodes()) {
+        if (node.id == id) return &node;
+    }
+    return nullptr;
+}
+
+bool ParseCpuList(const std::string& list, std::vector<int>* cpus) {
+    cpus->clear();
+    size_t pos = 0;
+    while (pos < list.size() && list[pos] != '\n') {
+        char* end = nullptr;
+        const long first = std::strtol(list.c_str() + pos, &end, 10);
+        if (end == list.c_str() + pos || first < 0) return false;
+        long last = first;
+        if (*end == '-') {
+            const char* start = end + 1;
+            last = std::strtol(start, &end, 10);
+            if (end == start || last < first) return false;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) cpus->push_back(static_cast<int>(cpu));
+
+        pos = static_cast<size_t>(end - list.c_str());
+        if (pos < list.size() && list[pos] == ',') {
+            ++pos;
+        } else if (pos < list.size() && list[pos] != '\n') {
+            return false;
+        }
+    }
+    std::sort(cpus->begin(), cpus->end());
+    cpus->erase(std::unique(cpus->begin(), cpus->end()), cpus->end());
+    return true;
+}
+
+std::string FormatCpuList(const std::vector<int>& cpus) {
+    std::string list;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) ++j;
+        if (!list.empty()) list += ',';
+        list += std::to_string(cpus[i]);
+        if (j > i) list += '-' + std::to_string(cpus[j]);
+        i = j + 1;
+    }
+    return list;
+}
+
+bool PinCurrentThread(const std::vector<int>& cpus) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return CPU_COUNT(&set) > 0 && sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+void BindMemoryToNode(void* p, size_t bytes, int node) {
+#if defined(__linux__)
+    if (node < 0 || node >= 64 || GetNumaNodes().size() < 2) return;
+
+    const auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const auto addr = reinterpret_cast<uintptr_t>(p);
+    const uintptr_t begin = (addr + page - 1) / page * page;
+    const uintptr_t end = (addr + bytes) / page * page;
+    if (end <= begin) return;
+
+    // A failure (e.g. no such node) only loses the placement hint
+    const unsigned long mask = 1ul << node;
+    (void)syscall(SYS_mbind, reinterpret_cast<void*>(begin), end - begin, kMpolPreferred, &mask,
+                  sizeof(mask) * 8, kMpolMfMove);
+#else
+    (void)p;
+    (void)bytes;
+    (void)node;
+#endif
+}
@@ -0,0 +1,145 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// The supported-op table and its compile-time perfect hash
+
+#include "op_registry.h"
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+namespace {
+
+// Element types with a kernel for `op`, as an OpDescriptor::types mask
+constexpr uint16_t KernelTypes(OpCode op) {
+    uint16_t types = 0;
+    for (size_t t = 0; t < kNumDataTypes; ++t) {
+        if (HasKernel(op, static_cast<DataType>(t))) types |= uint16_t(1u << t);
+    }
+    return types;
+}
+
+constexpr OpDescriptor Op(const char* domain, const char* op_type, int min_version, OpCode op, OpForm form,
+                          BroadcastRule broadcast, uint8_t cost) {
+    return {domain, op_type, min_version, OpDescriptor::kLatest, op, form, KernelTypes(op), broadcast, true, cost};
+}
+
+constexpr const char* kOnnx = "";
+constexpr const char* kMicrosoft = "com.microsoft";
+
+using B = BroadcastRule;
+
+// Minimum versions are where each op gained the semantics lowered here: multidirectional
+// broadcasting (7, Max/Min 8), no legacy consumed_inputs attribute (6), input-form Clip (11),
+// axes as either an attribute or an input (13; ReduceMean and ReduceMax take the input from 18),
+// an optional Gemm bias (11).
+constexpr OpDescriptor kOps[] = {
+    Op(kOnnx, "Add", 7, OpCode::Add, OpForm::Basic, B::Multidirectional, 1),
+    Op(kOnnx, "Sub", 7, OpCode::Sub, OpForm::Basic, B::Multidirectional, 1),
+    Op(kOnnx, "Mul", 7, OpCode::Mul, OpForm::Basic, B::Multidirectional, 1),
+    Op(kOnnx, "Div", 7, OpCode::Div, OpForm::Basic, B::Multidirectional, 2),
+    Op(kOnnx, "Max", 8, OpCode::Max, OpForm::Variadic, B::Multidirectional, 1),
+    Op(kOnnx, "Min", 8, OpCode::Min, OpForm::Variadic, B::Multidirectional, 1),
+    Op(kOnnx, "Pow", 7, OpCode::Pow, OpForm::Basic, B::Multidirectional, 12),
+    Op(kOnnx, "Equal", 7, OpCode::Equal, OpForm::Basic, B::Multidirectional, 1),
+    Op(kOnnx, "Less", 7, OpCode::Less, OpForm::Basic, B::Multidirectional, 1),
+    Op(kOnnx, "Greater", 7, OpCode::Greater, OpForm::Basic, B::Multidirectional, 1),
+    Op(kOnnx, "LessOrEqual", 12, OpCode::LessOrEqual, OpForm::Basic, B::Multidirectional, 1),
+    Op(kOnnx, "GreaterOrEqual", 12, OpCode::GreaterOrEqual, OpForm::Basic, B::Multidirectional, 1),
+    Op(kOnnx, "Neg", 6, OpCode::Neg, OpForm::Basic, B::None, 1),
+    Op(kOnnx, "Abs", 6, OpCode::Abs, OpForm::Basic, B::None, 1),
+    Op(kOnnx, "Relu", 6, OpCode::Relu, OpForm::Basic, B::None, 1),
+    Op(kOnnx, "Sigmoid", 6, OpCode::Sigmoid, OpForm::Basic, B::None, 6),
+    Op(kOnnx, "Tanh", 6, OpCode::Tanh, OpForm::Basic, B::None, 6),
+    Op(kOnnx, "Gelu", 20, OpCode::Gelu, OpForm::Basic, B::None, 10),
+    Op(kOnnx, "Erf", 9, OpCode::Erf, OpForm::Basic, B::None, 8),
+    Op(kOnnx, "Exp", 6, OpCode::Exp, OpForm::Basic, B::None, 5),
+    Op(kOnnx, "Log", 6, OpCode::Log, OpForm::Basic, B::None, 6),
+    Op(kOnnx, "Sqrt", 6, OpCode::Sqrt, OpForm::Basic, B::None, 2),
+    Op(kOnnx, "Reciprocal", 6, OpCode::Reciprocal, OpForm::Basic, B::None, 2),
+    Op(kOnnx, "Where", 9, OpCode::Where, OpForm::Basic, B::Multidirectional, 1),
+    Op(kOnnx, "Clip", 11, OpCode::Max, OpForm::Clip, B::Unidirectional, 2),
+    Op(kOnnx, "Cast", 6, OpCode::Cast, OpForm::Basic, B::None, 1),
+    Op(kOnnx, "ReduceSum", 13, OpCode::ReduceSum, OpForm::Reduce, B::Reduction, 1),
+    Op(kOnnx, "ReduceMean", 13, OpCode::ReduceMean, OpForm::Reduce, B::Reduction, 1),
+    Op(kOnnx, "ReduceMax", 13, OpCode::ReduceMax, OpForm::Reduce, B::Reduction, 1),
+    Op(kOnnx, "Softmax", 1, OpCode::Softmax, OpForm::Softmax, B::None, 8),
+    Op(kOnnx, "LayerNormalization", 17, OpCode::LayerNorm, OpForm::LayerNorm, B::Unidirectional, 5),
+    Op(kOnnx, "MatMul", 9, OpCode::MatMul, OpForm::MatMul, B::Contraction, 64),
+    Op(kOnnx, "Gemm", 11, OpCode::MatMul, OpForm::MatMul, B::Contraction, 64),
+    Op(kMicrosoft, "Gelu", 1, OpCode::Gelu, OpForm::Basic, B::None, 10),
+    Op(kMicrosoft, "BiasGelu", 1, OpCode::Gelu, OpForm::Bias, B::Unidirectional, 11),
+    Op(kMicrosoft, "FastGelu", 1, OpCode::GeluTanh, OpForm::Bias, B::Unidirectional, 9),
+};
+
+constexpr size_t kNumOps = sizeof(kOps) / sizeof(kOps[0]);
+
+// ============================================================================
+// Perfect hash: a seeded string hash chosen so that every key lands in its own slot
+// ============================================================================
+
+constexpr uint8_t kEmpty = 0xFF;
+static_assert(kNumOps < kEmpty, "Slot indices are one byte");
+
+constexpr size_t NextPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n) p *= 2;
+    return p;
+}
+
+// About 8 slots per key, so a seed without collisions turns up within a few tries
+constexpr size_t kSlots = NextPowerOfTwo(8 * kNumOps);
+
+// FNV-1a over "domain\0op_type", finished with a multiply-xorshift so the low bits used as
+// the slot index depend on every byte
+constexpr uint32_t HashKey(std::string_view domain, std::string_view op_type, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (char c : domain) h = (h ^ static_cast<uint8_t>(c)) * 16777619u;
+    h = h * 16777619u;
+    for (char c : op_type) h = (h ^ static_cast<uint8_t>(c)) * 16777619u;
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    return h;
+}
+
+struct PerfectHash {
+    static constexpr uint32_t kNoSeed = 0xFFFFFFFFu;
+
+    uint32_t seed = kNoSeed;
+    uint8_t slot[kSlots] = {};  // Index into kOps, or kEmpty
+};
+
+constexpr PerfectHash BuildPerfectHash() {
+    PerfectHash hash;
+    for (uint32_t seed = 0; seed < 4096; ++seed) {
+        for (uint8_t& slot : hash.slot) slot = kEmpty;
+        bool collision = false;
+        for (size_t i = 0; i < kNumOps && !collision; ++i) {
+            uint8_t& slot = hash.slot[HashKey(kOps[i].domain, kOps[i].op_type, seed) & (kSlots - 1)];
+            collision = slot != kEmpty;
+            slot = static_cast<uint8_t>(i);
+        }
+        if (!collision) {
+            hash.seed = seed;
+            return hash;
+        }
+    }
+    return hash;
+}
+
+constexpr PerfectHash kHash = BuildPerfectHash();
+
+// Also fails if two entries share a key, since those always collide
+static_assert(kHash.seed != PerfectHash::kNoSeed, "No collision-free seed found; check kOps for duplicates");
+
+}  // namespace
+
+const OpDescriptor* FindOp(const char* domain, const char* op_type) {
+    if (domain == nullptr || op_type == nullptr) return nullptr;
+    if (std::strcmp(domain, "ai.onnx") == 0) domain = kOnnx;
+
+    const uint8_t index = kHash.slot[HashKey(domain, op_type, kHash.seed) & (kSlots - 1)];
+    if (index == kEmpty) return nullptr;
+    const OpDescriptor& op = kOps[index];
+    return std::strcmp(op.op_type, op_type) == 0 && std::strcmp(op.domain, domain) == 0 ? &op : nullptr;
+}
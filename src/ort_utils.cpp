@@ -0,0 +1,325 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Small helpers shared by the Sample EP's use of the ONNX Runtime C API
+
+#include "ort_utils.h"
+
+#include <cstring>
+
+OrtStatus* GetValueTensorInfo(const OrtApi* api, const OrtValueInfo* value_info,
+                              ONNXTensorElementDataType* elem_type, std::string* shape_key) {
+    *elem_type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+    shape_key->clear();
+
+    const OrtTypeInfo* type_info = nullptr;
+    RETURN_IF_ERROR(api->GetValueInfoTypeInfo(value_info, &type_info));
+
+    const OrtTensorTypeAndShapeInfo* tensor_info = nullptr;
+    RETURN_IF_ERROR(api->CastTypeInfoToTensorInfo(type_info, &tensor_info));
+    if (tensor_info == nullptr) return nullptr;  // Not a tensor
+
+    RETURN_IF_ERROR(api->GetTensorElementType(tensor_info, elem_type));
+
+    size_t num_dims = 0;
+    RETURN_IF_ERROR(api->GetDimensionsCount(tensor_info, &num_dims));
+    std::vector<int64_t> dims(num_dims);
+    std::vector<const char*> dim_params(num_dims, nullptr);
+    RETURN_IF_ERROR(api->GetDimensions(tensor_info, dims.data(), num_dims));
+    RETURN_IF_ERROR(api->GetSymbolicDimensions(tensor_info, dim_params.data(), num_dims));
+
+    std::string key = "[";
+    for (size_t d = 0; d < num_dims; ++d) {
+        if (dims[d] >= 0) {
+            key += std::to_string(dims[d]);
+        } else if (dim_params[d] != nullptr && dim_params[d][0] != '\0') {
+            key += dim_params[d];
+        } else {
+            return nullptr;  // Unknown dim, leave shape_key empty
+        }
+        key += ',';
+    }
+    key += ']';
+    *shape_key = std::move(key);
+    return nullptr;
+}
+
+OrtStatus* GetValueDims(const OrtApi* api, const OrtValueInfo* value_info,
+                        std::vector<int64_t>* dims, bool* found) {
+    *found = false;
+    dims->clear();
+
+    const OrtTypeInfo* type_info = nullptr;
+    RETURN_IF_ERROR(api->GetValueInfoTypeInfo(value_info, &type_info));
+
+    const OrtTensorTypeAndShapeInfo* tensor_info = nullptr;
+    RETURN_IF_ERROR(api->CastTypeInfoToTensorInfo(type_info, &tensor_info));
+    if (tensor_info == nullptr) return nullptr;  // Not a tensor
+
+    size_t num_dims = 0;
+    RETURN_IF_ERROR(api->GetDimensionsCount(tensor_info, &num_dims));
+    dims->resize(num_dims);
+    RETURN_IF_ERROR(api->GetDimensions(tensor_info, dims->data(), num_dims));
+    *found = true;
+    return nullptr;
+}
+
+OrtStatus* GetStaticTensorSize(const OrtApi* api, const OrtValueInfo* value_info,
+                               size_t* elements, size_t* bytes) {
+    *elements = 0;
+    *bytes = 0;
+
+    const OrtTypeInfo* type_info = nullptr;
+    RETURN_IF_ERROR(api->GetValueInfoTypeInfo(value_info, &type_info));
+
+    const OrtTensorTypeAndShapeInfo* tensor_info = nullptr;
+    RETURN_IF_ERROR(api->CastTypeInfoToTensorInfo(type_info, &tensor_info));
+    if (tensor_info == nullptr) return nullptr;  // Not a tensor
+
+    ONNXTensorElementDataType elem_type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+    RETURN_IF_ERROR(api->GetTensorElementType(tensor_info, &elem_type));
+    size_t elem_size = 0;
+    switch (elem_type) {
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8: elem_size = 1; break;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16: elem_size = 2; break;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32: elem_size = 4; break;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64: elem_size = 8; break;
+        default: return nullptr;
+    }
+
+    size_t num_dims = 0;
+    RETURN_IF_ERROR(api->GetDimensionsCount(tensor_info, &num_dims));
+    std::vector<int64_t> dims(num_dims);
+    RETURN_IF_ERROR(api->GetDimensions(tensor_info, dims.data(), num_dims));
+    size_t count = 1;
+    for (int64_t d : dims) {
+        if (d < 0) return nullptr;
+        count *= static_cast<size_t>(d);
+    }
+    *elements = count;
+    *bytes = count * elem_size;
+    return nullptr;
+}
+
+OrtStatus* GetNodeInputs(const OrtApi* api, const OrtNode* node,
+                         std::vector<const OrtValueInfo*>* inputs) {
+    size_t num_inputs = 0;
+    RETURN_IF_ERROR(api->Node_GetNumInputs(node, &num_inputs));
+    inputs->assign(num_inputs, nullptr);
+    return api->Node_GetInputs(node, inputs->data(), num_inputs);
+}
+
+OrtStatus* GetNodeOutputs(const OrtApi* api, const OrtNode* node,
+                          std::vector<const OrtValueInfo*>* outputs) {
+    size_t num_outputs = 0;
+    RETURN_IF_ERROR(api->Node_GetNumOutputs(node, &num_outputs));
+    outputs->assign(num_outputs, nullptr);
+    return api->Node_GetOutputs(node, outputs->data(), num_outputs);
+}
+
+OrtStatus* GetGraphNodes(const OrtApi* api, const OrtGraph* graph,
+                         std::vector<const OrtNode*>* nodes) {
+    size_t num_nodes = 0;
+    RETURN_IF_ERROR(api->Graph_GetNumNodes(graph, &num_nodes));
+    nodes->assign(num_nodes, nullptr);
+    return api->Graph_GetNodes(graph, nodes->data(), num_nodes);
+}
+
+OrtStatus* FindAttribute(const OrtApi* api, const OrtNode* node, const char* name,
+                         const OrtOpAttr** attr) {
+    *attr = nullptr;
+
+    // Missing attributes are reported as ORT_NOT_FOUND or as a null attribute
+    OrtStatus* status = api->Node_GetAttributeByName(node, name, attr);
+    if (status != nullptr) {
+        *attr = nullptr;
+        if (api->GetErrorCode(status) != ORT_NOT_FOUND) return status;
+        api->ReleaseStatus(status);
+    }
+    return nullptr;
+}
+
+OrtStatus* GetStringAttribute(const OrtApi* api, const OrtNode* node, const char* name,
+                              std::string* value, bool* found) {
+    *found = false;
+    value->clear();
+
+    const OrtOpAttr* attr = nullptr;
+    RETURN_IF_ERROR(FindAttribute(api, node, name, &attr));
+    if (attr == nullptr) return nullptr;
+
+    OrtOpAttrType type = ORT_OP_ATTR_UNDEFINED;
+    RETURN_IF_ERROR(api->OpAttr_GetType(attr, &type));
+    if (type != ORT_OP_ATTR_STRING) return nullptr;
+
+    // The first call only reports the size; it may do so through an error status
+    size_t size = 0;
+    OrtStatus* status = api->ReadOpAttr(attr, ORT_OP_ATTR_STRING, nullptr, 0, &size);
+    if (status != nullptr) {
+        if (size == 0) return status;
+        api->ReleaseStatus(status);
+    }
+
+    std::vector<char> buffer(size);
+    if (size > 0) {
+        RETURN_IF_ERROR(api->ReadOpAttr(attr, ORT_OP_ATTR_STRING, buffer.data(), size, &size));
+    }
+    value->assign(buffer.data(), size);
+    *found = true;
+    return nullptr;
+}
+
+namespace {
+
+// Read a fixed-size attribute value into `data`. found is false if it is missing or of
+// another type.
+OrtStatus* ReadAttribute(const OrtApi* api, const OrtNode* node, const char* name, OrtOpAttrType type,
+                         void* data, size_t size, bool* found) {
+    *found = false;
+    const OrtOpAttr* attr = nullptr;
+    RETURN_IF_ERROR(FindAttribute(api, node, name, &attr));
+    if (attr == nullptr) return nullptr;
+
+    OrtOpAttrType actual = ORT_OP_ATTR_UNDEFINED;
+    RETURN_IF_ERROR(api->OpAttr_GetType(attr, &actual));
+    if (actual != type) return nullptr;
+
+    size_t written = 0;
+    RETURN_IF_ERROR(api->ReadOpAttr(attr, type, data, size, &written));
+    *found = true;
+    return nullptr;
+}
+
+}  // namespace
+
+OrtStatus* GetIntAttribute(const OrtApi* api, const OrtNode* node, const char* name,
+                           int64_t* value, bool* found) {
+    return ReadAttribute(api, node, name, ORT_OP_ATTR_INT, value, sizeof(*value), found);
+}
+
+OrtStatus* GetFloatAttribute(const OrtApi* api, const OrtNode* node, const char* name,
+                             float* value, bool* found) {
+    return ReadAttribute(api, node, name, ORT_OP_ATTR_FLOAT, value, sizeof(*value), found);
+}
+
+OrtStatus* GetIntsAttribute(const OrtApi* api, const OrtNode* node, const char* name,
+                            std::vector<int64_t>* values, bool* found) {
+    *found = false;
+    values->clear();
+
+    const OrtOpAttr* attr = nullptr;
+    RETURN_IF_ERROR(FindAttribute(api, node, name, &attr));
+    if (attr == nullptr) return nullptr;
+
+    OrtOpAttrType type = ORT_OP_ATTR_UNDEFINED;
+    RETURN_IF_ERROR(api->OpAttr_GetType(attr, &type));
+    if (type != ORT_OP_ATTR_INTS) return nullptr;
+
+    // As for strings, the first call only reports the size in bytes
+    size_t size = 0;
+    OrtStatus* status = api->ReadOpAttr(attr, ORT_OP_ATTR_INTS, nullptr, 0, &size);
+    if (status != nullptr) {
+        if (size == 0) return status;
+        api->ReleaseStatus(status);
+    }
+
+    values->resize(size / sizeof(int64_t));
+    if (size > 0) {
+        RETURN_IF_ERROR(api->ReadOpAttr(attr, ORT_OP_ATTR_INTS, values->data(), size, &size));
+    }
+    *found = true;
+    return nullptr;
+}
+
+OrtStatus* GetInitializerTensor(const OrtApi* api, const OrtValueInfo* value_info,
+                                ONNXTensorElementDataType* elem_type, std::vector<int64_t>* dims,
+                                const void** data) {
+    *elem_type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+    *data = nullptr;
+    dims->clear();
+
+    bool constant = false;
+    RETURN_IF_ERROR(api->ValueInfo_IsConstantInitializer(value_info, &constant));
+    if (!constant) return nullptr;
+
+    const OrtValue* value = nullptr;
+    RETURN_IF_ERROR(api->ValueInfo_GetInitializerValue(value_info, &value));
+    if (value == nullptr) return nullptr;
+
+    const int64_t* shape = nullptr;
+    size_t rank = 0;
+    RETURN_IF_ERROR(api->GetTensorElementTypeAndShapeDataReference(value, elem_type, &shape, &rank));
+    dims->assign(shape, shape + rank);
+    return api->GetTensorData(value, data);
+}
+
+namespace {
+
+// The data and dims of a constant initializer of type `want`. *data is null for any other value.
+OrtStatus* GetInitializerData(const OrtApi* api, const OrtValueInfo* value_info, ONNXTensorElementDataType want,
+                              const void** data, std::vector<int64_t>* dims) {
+    ONNXTensorElementDataType elem_type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+    RETURN_IF_ERROR(GetInitializerTensor(api, value_info, &elem_type, dims, data));
+    if (elem_type != want) *data = nullptr;
+    return nullptr;
+}
+
+size_t ElementCount(const std::vector<int64_t>& dims) {
+    size_t count = 1;
+    for (int64_t d : dims) count *= static_cast<size_t>(d);
+    return count;
+}
+
+}  // namespace
+
+OrtStatus* GetInitializerInts(const OrtApi* api, const OrtValueInfo* value_info,
+                              std::vector<int64_t>* values, bool* found) {
+    const void* data = nullptr;
+    std::vector<int64_t> dims;
+    RETURN_IF_ERROR(GetInitializerData(api, value_info, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64, &data, &dims));
+    *found = data != nullptr;
+    values->clear();
+    if (*found) {
+        const auto* ints = static_cast<const int64_t*>(data);
+        values->assign(ints, ints + ElementCount(dims));
+    }
+    return nullptr;
+}
+
+OrtStatus* GetInitializerFloats(const OrtApi* api, const OrtValueInfo* value_info,
+                                std::vector<float>* values, std::vector<int64_t>* dims, bool* found) {
+    const void* data = nullptr;
+    RETURN_IF_ERROR(GetInitializerData(api, value_info, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &data, dims));
+    *found = data != nullptr;
+    values->clear();
+    if (*found) {
+        const auto* floats = static_cast<const float*>(data);
+        values->assign(floats, floats + ElementCount(*dims));
+    }
+    return nullptr;
+}
+
+OrtStatus* FindGraphInitializer(const OrtApi* api, const OrtGraph* graph, const char* name,
+                                const OrtValueInfo** value_info) {
+    *value_info = nullptr;
+    size_t count = 0;
+    RETURN_IF_ERROR(api->Graph_GetNumInitializers(graph, &count));
+    std::vector<const OrtValueInfo*> initializers(count, nullptr);
+    RETURN_IF_ERROR(api->Graph_GetInitializers(graph, initializers.data(), count));
+    for (const OrtValueInfo* initializer : initializers) {
+        const char* initializer_name = nullptr;
+        RETURN_IF_ERROR(api->GetValueInfoName(initializer, &initializer_name));
+        if (initializer_name != nullptr && std::strcmp(initializer_name, name) == 0) {
+            *value_info = initializer;
+            break;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,411 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Graph partitioning for the Sample EP
+
+#include "partitioner.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <numeric>
+#include <queue>
+#include <set>
+#include <sstream>
+
+namespace {
+
+// Graphs smaller than this are split into components on the calling thread
+constexpr size_t kParallelPartitionNodes = 4096;
+
+constexpr size_t kNoSlot = static_cast<size_t>(-1);
+
+size_t FindRoot(std::vector<size_t>& parent, size_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];  // Path halving
+        i = parent[i];
+    }
+    return i;
+}
+
+// Connected components of `members`, a topologically ordered set of nodes, through the edges
+// between them. Each lists its nodes in the same order.
+std::vector<std::vector<size_t>> Components(const PartitionGraph& graph, const std::vector<size_t>& members) {
+    std::map<size_t, size_t> index;  // node -> position in members
+    for (size_t k = 0; k < members.size(); ++k) index.emplace(members[k], k);
+    std::vector<size_t> parent(members.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    for (size_t k = 0; k < members.size(); ++k) {
+        for (size_t p : graph.ProducersOf(members[k])) {
+            auto it = index.find(p);
+            if (it != index.end()) parent[FindRoot(parent, k)] = FindRoot(parent, it->second);
+        }
+    }
+
+    std::vector<std::vector<size_t>> components;
+    std::map<size_t, size_t> component_index;  // root -> index into components
+    for (size_t k = 0; k < members.size(); ++k) {
+        auto it = component_index.emplace(FindRoot(parent, k), components.size()).first;
+        if (it->second == components.size()) components.emplace_back();
+        components[it->second].push_back(members[k]);
+    }
+    return components;
+}
+
+// Split a convex, connected partition until no piece holds two row ops. The last row op and
+// its descendants inside the partition are convex, and so is the rest: a path between two
+// nodes of the rest through the split-off part would make its end a descendant of the row op.
+void SplitRowOps(const PartitionGraph& graph, const std::vector<size_t>& part,
+                 std::vector<std::vector<size_t>>* out) {
+    size_t row_ops = 0;
+    size_t last = 0;
+    for (size_t i : part) {
+        if (!graph.row_op[i]) continue;
+        ++row_ops;
+        last = i;
+    }
+    if (row_ops < 2) {
+        out->push_back(part);
+        return;
+    }
+
+    std::set<size_t> tail = {last};
+    std::vector<size_t> rest;
+    for (size_t i : part) {
+        bool descendant = tail.count(i) > 0;
+        for (size_t p : graph.ProducersOf(i)) descendant = descendant || tail.count(p) > 0;
+        if (descendant) {
+            tail.insert(i);
+        } else {
+            rest.push_back(i);
+        }
+    }
+    for (const auto& component : Components(graph, rest)) SplitRowOps(graph, component, out);
+
+    std::vector<size_t> split;
+    for (size_t i : part) {
+        if (tail.count(i)) split.push_back(i);
+    }
+    out->push_back(std::move(split));
+}
+
+// Kahn's algorithm with separate ready queues. Unsupported nodes are always drained first so
+// that as many supported nodes as possible are ready before a group is opened. A group takes
+// ready nodes of a single shape class until none are left, which makes each group a
+// contiguous range of the resulting topological order (hence convex).
+std::vector<std::vector<size_t>> BuildGroups(const PartitionGraph& graph, size_t max_nodes) {
+    const size_t n = graph.size();
+
+    // Consumer edges, in the same flat layout as the producers
+    std::vector<size_t> consumer_begin(n + 1, 0);
+    for (size_t p : graph.producers) consumer_begin[p + 1]++;
+    std::partial_sum(consumer_begin.begin(), consumer_begin.end(), consumer_begin.begin());
+    std::vector<size_t> consumers(graph.producers.size());
+    std::vector<size_t> fill(consumer_begin.begin(), consumer_begin.end() - 1);
+    std::vector<size_t> pending(n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t p : graph.ProducersOf(i)) consumers[fill[p]++] = i;
+        pending[i] = graph.producer_begin[i + 1] - graph.producer_begin[i];
+    }
+
+    std::deque<size_t> ready_other;
+    std::map<int64_t, std::deque<size_t>> ready_supported;  // shape class -> ready nodes
+
+    // (front node, shape class) of every non-empty ready queue, oldest first. Entries whose
+    // queue has moved on since are skipped when they surface.
+    using Front = std::pair<size_t, int64_t>;
+    std::priority_queue<Front, std::vector<Front>, std::greater<Front>> fronts;
+
+    auto make_ready = [&](size_t i) {
+        if (!graph.supported[i]) {
+            ready_other.push_back(i);
+            return;
+        }
+        std::deque<size_t>& queue = ready_supported[graph.shape_class[i]];
+        if (queue.empty()) fronts.emplace(i, graph.shape_class[i]);
+        queue.push_back(i);
+    };
+
+    auto release = [&](size_t i) {
+        for (size_t k = consumer_begin[i]; k < consumer_begin[i + 1]; ++k) {
+            if (--pending[consumers[k]] == 0) make_ready(consumers[k]);
+        }
+    };
+
+    for (size_t i = 0; i < n; ++i) {
+        if (pending[i] == 0) make_ready(i);
+    }
+
+    std::vector<std::vector<size_t>> groups;
+    for (;;) {
+        if (!ready_other.empty()) {
+            size_t i = ready_other.front();
+            ready_other.pop_front();
+            release(i);
+            continue;
+        }
+
+        // Open a group for the class whose oldest ready node comes first
+        std::deque<size_t>* best = nullptr;
+        int64_t best_class = -1;
+        while (best == nullptr && !fronts.empty()) {
+            const Front front = fronts.top();
+            fronts.pop();
+            std::deque<size_t>& queue = ready_supported[front.second];
+            if (!queue.empty() && queue.front() == front.first) {
+                best = &queue;
+                best_class = front.second;
+            }
+        }
+        if (best == nullptr) break;
+
+        std::vector<size_t> group;
+        const bool fusable = best_class >= 0;
+        // Closing a group early keeps it a contiguous range, so a capped group is convex too
+        while (!best->empty() && (max_nodes == 0 || group.size() < max_nodes)) {
+            size_t i = best->front();
+            best->pop_front();
+            group.push_back(i);
+            release(i);
+            if (!fusable) break;  // Unfusable nodes always stand alone
+        }
+        if (!best->empty()) fronts.emplace(best->front(), best_class);
+        groups.push_back(std::move(group));
+    }
+    return groups;
+}
+
+// Fold each partition whose only value read outside it is a row op's operand into the row
+// op's partition, where the row plan's prologue computes it. Grouping never fuses the two
+// when the row op changes shape, as reductions and MatMul do. The merged set is convex: the
+// folded partition feeds nothing else, and a path from the row op's partition into it would
+// leave that partition and re-enter it at the row op. It lists the folded nodes first, which
+// keeps it in topological order for the same reason.
+void MergePrologues(const PartitionGraph& graph, size_t max_nodes, std::vector<std::vector<size_t>>* partitions) {
+    constexpr size_t kMany = kNoSlot - 1;
+    std::vector<size_t> partition_of(graph.size(), kNoSlot);
+    for (size_t p = 0; p < partitions->size(); ++p) {
+        for (size_t i : (*partitions)[p]) partition_of[i] = p;
+    }
+
+    // The one node outside each partition reading its values; kMany for several, or a graph output
+    std::vector<size_t> reader(partitions->size(), kNoSlot);
+    for (size_t i = 0; i < graph.size(); ++i) {
+        for (size_t p : graph.ProducersOf(i)) {
+            const size_t part = partition_of[p];
+            if (part == kNoSlot || part == partition_of[i]) continue;
+            reader[part] = reader[part] == kNoSlot || reader[part] == i ? i : kMany;
+        }
+    }
+    for (size_t p = 0; p < partitions->size(); ++p) {
+        for (size_t i : (*partitions)[p]) {
+            if (graph.graph_output[i]) reader[p] = kMany;
+        }
+    }
+
+    std::vector<bool> folded(partitions->size(), false);
+    for (size_t q = 0; q < partitions->size(); ++q) {
+        std::vector<size_t>& part = (*partitions)[q];
+        auto row = std::find_if(part.begin(), part.end(), [&](size_t i) { return graph.row_op[i] != 0; });
+        if (row == part.end() || graph.operand_producer[*row] < 0) continue;
+        const size_t p = partition_of[static_cast<size_t>(graph.operand_producer[*row])];
+        if (p == kNoSlot || p == q || reader[p] != *row) continue;
+
+        std::vector<size_t>& prologue = (*partitions)[p];
+        const bool fusable = std::all_of(prologue.begin(), prologue.end(), [&](size_t i) {
+            return graph.shape_class[i] >= 0 && !graph.row_op[i];
+        });
+        if (!fusable || (max_nodes != 0 && part.size() + prologue.size() > max_nodes)) continue;
+
+        part.insert(part.begin(), prologue.begin(), prologue.end());
+        prologue.clear();
+        folded[p] = true;
+    }
+
+    size_t kept = 0;
+    for (size_t p = 0; p < partitions->size(); ++p) {
+        if (folded[p]) continue;
+        if (kept != p) (*partitions)[kept] = std::move((*partitions)[p]);
+        ++kept;
+    }
+    partitions->resize(kept);
+}
+
+}  // namespace
+
+void PartitionGraph::Resize(size_t num_nodes) {
+    supported.assign(num_nodes, 0);
+    shape_class.assign(num_nodes, -1);
+    row_op.assign(num_nodes, 0);
+    operand_producer.assign(num_nodes, -1);
+    producer_begin.assign(num_nodes + 1, 0);
+    producers.clear();
+    elements.assign(num_nodes, 0);
+    input_bytes.assign(num_nodes, 0);
+    output_bytes.assign(num_nodes, 0);
+    cost.assign(num_nodes, 1);
+    graph_output.assign(num_nodes, 0);
+}
+
+std::vector<std::vector<size_t>> BuildPartitions(const PartitionGraph& graph, size_t max_nodes, ThreadPool* pool) {
+    const size_t n = graph.size();
+    const std::vector<std::vector<size_t>> groups = BuildGroups(graph, max_nodes);
+
+    std::vector<size_t> group_of(n, kNoSlot);
+    for (size_t g = 0; g < groups.size(); ++g) {
+        for (size_t i : groups[g]) group_of[i] = g;
+    }
+
+    // Split each group into its connected components. Every edge inside a group joins nodes
+    // of the same class, and a connected component of a convex set is itself convex. Then
+    // split components holding more than one row op. Groups are disjoint, so each only
+    // touches its own nodes' entries of the shared arrays and runs independently.
+    std::vector<size_t> parent(n);
+    std::vector<size_t> slot(n);  // Root -> index of its component within the group
+    std::vector<std::vector<std::vector<size_t>>> pieces(groups.size());
+    auto split_group = [&](size_t g) {
+        const std::vector<size_t>& group = groups[g];
+        for (size_t i : group) {
+            parent[i] = i;
+            slot[i] = kNoSlot;
+        }
+        for (size_t i : group) {
+            for (size_t p : graph.ProducersOf(i)) {
+                if (group_of[p] == g) parent[FindRoot(parent, i)] = FindRoot(parent, p);
+            }
+        }
+
+        std::vector<std::vector<size_t>> components;
+        for (size_t i : group) {
+            const size_t root = FindRoot(parent, i);
+            if (slot[root] == kNoSlot) {
+                slot[root] = components.size();
+                components.emplace_back();
+            }
+            components[slot[root]].push_back(i);
+        }
+        for (const auto& component : components) SplitRowOps(graph, component, &pieces[g]);
+    };
+
+    // Contiguous ranges of groups, a few per thread so uneven ones balance out
+    const bool parallel = pool != nullptr && pool->NumThreads() > 1 && n >= kParallelPartitionNodes;
+    const size_t num_chunks = parallel ? std::max<size_t>(1, std::min(groups.size(), pool->NumThreads() * 4)) : 1;
+    auto split_chunk = [&](size_t chunk) {
+        const size_t end = (chunk + 1) * groups.size() / num_chunks;
+        for (size_t g = chunk * groups.size() / num_chunks; g < end; ++g) split_group(g);
+    };
+    if (num_chunks == 1) {
+        split_chunk(0);
+    } else {
+        pool->ParallelFor(num_chunks, split_chunk);
+    }
+
+    std::vector<std::vector<size_t>> partitions;
+    for (auto& group_pieces : pieces) {
+        for (auto& piece : group_pieces) partitions.push_back(std::move(piece));
+    }
+    MergePrologues(graph, max_nodes, &partitions);
+    return partitions;
+}
+
+namespace {
+
+struct CostField {
+    const char* name;
+    double CostModel::*field;
+};
+
+constexpr CostField kCostFields[] = {
+    {"ep_call_ns", &CostModel::ep_call_ns},
+    {"ep_bytes_per_ns", &CostModel::ep_bytes_per_ns},
+    {"ep_ns_per_op", &CostModel::ep_ns_per_op},
+    {"cpu_node_ns", &CostModel::cpu_node_ns},
+    {"cpu_bytes_per_ns", &CostModel::cpu_bytes_per_ns},
+    {"cpu_ns_per_op", &CostModel::cpu_ns_per_op},
+};
+
+}  // namespace
+
+bool CostModel::Parse(const std::string& spec) {
+    CostModel parsed = *this;
+    std::istringstream in(spec);
+    for (std::string item; std::getline(in, item, ',');) {
+        const size_t eq = item.find('=');
+        if (eq == std::string::npos) return false;
+        const std::string name = item.substr(0, eq);
+        const std::string value = item.substr(eq + 1);
+
+        char* end = nullptr;
+        const double number = std::strtod(value.c_str(), &end);
+        if (value.empty() || *end != '\0' || !(number > 0)) return false;
+
+        bool known = false;
+        for (const CostField& f : kCostFields) {
+            if (name == f.name) {
+                parsed.*f.field = number;
+                known = true;
+            }
+        }
+        if (!known) return false;
+    }
+    *this = parsed;
+    return true;
+}
+
+std::string CostModel::ToString() const {
+    std::ostringstream out;
+    for (const CostField& f : kCostFields) {
+        out << (&f == kCostFields ? "" : ",") << f.name << "=" << this->*f.field;
+    }
+    return out.str();
+}
+
+std::vector<PartitionEstimate> EstimatePartitions(const PartitionGraph& graph,
+                                                  const std::vector<std::vector<size_t>>& partitions,
+                                                  const CostModel& model) {
+    std::vector<int64_t> partition_of(graph.size(), -1);
+    for (size_t p = 0; p < partitions.size(); ++p) {
+        for (size_t i : partitions[p]) partition_of[i] = static_cast<int64_t>(p);
+    }
+
+    // An output leaves its partition if it is read after the run or by any node outside
+    std::vector<bool> escapes(graph.size(), false);
+    for (size_t i = 0; i < graph.size(); ++i) {
+        escapes[i] = escapes[i] || graph.graph_output[i];
+        for (size_t p : graph.ProducersOf(i)) {
+            if (partition_of[p] != partition_of[i]) escapes[p] = true;
+        }
+    }
+
+    std::vector<PartitionEstimate> estimates(partitions.size());
+    for (size_t p = 0; p < partitions.size(); ++p) {
+        PartitionEstimate& e = estimates[p];
+        e.known = true;
+        double cpu_bytes = 0;
+        double ep_compute = 0;
+        double cpu_compute = 0;
+        for (size_t i : partitions[p]) {
+            e.known = e.known && graph.elements[i] > 0;
+
+            // Inputs produced inside the partition never touch memory
+            size_t read = graph.input_bytes[i];
+            for (size_t producer : graph.ProducersOf(i)) {
+                if (partition_of[producer] == static_cast<int64_t>(p)) {
+                    read -= std::min(read, graph.output_bytes[producer]);
+                }
+            }
+            e.boundary_bytes += read + (escapes[i] ? graph.output_bytes[i] : 0);
+
+            cpu_bytes += static_cast<double>(graph.input_bytes[i] + graph.output_bytes[i]);
+            const uint32_t cost = graph.cost[i];
+            const double extra_ops = static_cast<double>(graph.elements[i]) * (cost > 1 ? cost - 1 : 0);
+            ep_compute += extra_ops * model.ep_ns_per_op;
+            cpu_compute += extra_ops * model.cpu_ns_per_op;
+        }
+
+        e.ep_ns = model.ep_call_ns + static_cast<double>(e.boundary_bytes) / model.ep_bytes_per_ns + ep_compute;
+        e.cpu_ns = model.cpu_node_ns * static_cast<double>(partitions[p].size()) +
+                   cpu_bytes / model.cpu_bytes_per_ns + cpu_compute;
+    }
+    return estimates;
+}
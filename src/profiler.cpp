@@ -0,0 +1,241 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Opt-in per-partition profiler, flushed as Chrome trace events
+
+#include "profiler.h"
+
+#if defined(_WIN32)
+#include <intrin.h>
+#include <process.h>
+#define SAMPLE_EP_GETPID _getpid
+#else
+#include <unistd.h>
+#define SAMPLE_EP_GETPID getpid
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+
+std::atomic<uint64_t> g_next_profiler_id{1};
+
+// Ring of the calling thread for the profiler it was last used with
+struct ThreadRingCache {
+    uint64_t profiler_id = 0;
+    void* ring = nullptr;
+};
+thread_local ThreadRingCache t_ring_cache;
+
+struct DrainedSample {
+    uint64_t index, start, end, bytes;
+    uint32_t node, chunks, plan_built;
+};
+
+void WriteJsonString(std::FILE* file, const std::string& s) {
+    std::fputc('"', file);
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', file);
+            std::fputc(c, file);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            std::fprintf(file, "\\u%04x", static_cast<unsigned>(c));
+        } else {
+            std::fputc(c, file);
+        }
+    }
+    std::fputc('"', file);
+}
+
+}  // namespace
+
+uint64_t Profiler::Now() {
+#if defined(_M_X64) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+Profiler::Profiler(std::string path)
+    : id_(g_next_profiler_id.fetch_add(1)), path_(std::move(path)),
+      base_ticks_(Now()), base_time_(std::chrono::steady_clock::now()) {}
+
+Profiler::~Profiler() {
+    // A profiler that was never enabled leaves no file behind
+    if (Enabled() || file_ != nullptr) Flush();
+    if (file_ != nullptr) {
+        std::fputs("\n]\n", file_);
+        std::fclose(file_);
+    }
+}
+
+uint32_t Profiler::RegisterNode(const std::string& name, const std::string& kernel) {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    nodes_.push_back({name, kernel});
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+Profiler::Ring* Profiler::ThreadRing() {
+    if (t_ring_cache.profiler_id == id_) {
+        return static_cast<Ring*>(t_ring_cache.ring);
+    }
+
+    // First sample from this thread since it last used another profiler
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    const std::thread::id self = std::this_thread::get_id();
+    Ring* ring = nullptr;
+    for (const auto& r : rings_) {
+        if (r->owner == self) ring = r.get();
+    }
+    if (ring == nullptr) {
+        rings_.push_back(std::make_unique<Ring>(static_cast<uint32_t>(rings_.size()), self));
+        ring = rings_.back().get();
+    }
+
+    t_ring_cache.profiler_id = id_;
+    t_ring_cache.ring = ring;
+    return ring;
+}
+
+void Profiler::Push(Ring* ring, uint32_t node, uint64_t start, uint64_t end, uint64_t bytes,
+                    uint32_t chunks, bool plan_built) {
+    const uint64_t head = ring->head.load(std::memory_order_relaxed);
+
+    // Order the previous head update before the slot writes, so a flush that sees any of
+    // them also sees that this slot may be in flight
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Sample& s = ring->samples[head & (kRingCapacity - 1)];
+    s.start.store(start, std::memory_order_relaxed);
+    s.end.store(end, std::memory_order_relaxed);
+    s.bytes.store(bytes, std::memory_order_relaxed);
+    s.node.store(node, std::memory_order_relaxed);
+    s.chunks.store(chunks, std::memory_order_relaxed);
+    s.plan_built.store(plan_built ? 1 : 0, std::memory_order_relaxed);
+
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::RecordCompute(uint32_t node, uint64_t start, uint64_t end, uint64_t bytes,
+                             uint32_t chunks, bool plan_built) {
+    Push(ThreadRing(), node, start, end, bytes, chunks, plan_built);
+}
+
+void Profiler::RecordRunStart() {
+    ThreadRing()->run_start = Now();
+}
+
+void Profiler::RecordRunEnd() {
+    Ring* ring = ThreadRing();
+    if (ring->run_start == 0) return;  // Profiling was switched on during the run
+    Push(ring, kRunNode, ring->run_start, Now(), 0, 0, false);
+    ring->run_start = 0;
+}
+
+bool Profiler::Flush() {
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+
+    std::vector<Ring*> rings;
+    std::vector<NodeInfo> nodes;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (const auto& r : rings_) rings.push_back(r.get());
+        nodes = nodes_;
+    }
+
+    bool ok = true;
+    if (file_ == nullptr && !failed_) {
+        file_ = std::fopen(path_.c_str(), "w");
+        if (file_ == nullptr) {
+            failed_ = true;
+            ok = false;
+        } else {
+            std::fputs("[", file_);
+        }
+    }
+
+    // Ticks to microseconds since construction, calibrated over the profiler's lifetime
+    const uint64_t now_ticks = Now();
+    const double elapsed_us = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - base_time_).count();
+    const double us_per_tick = now_ticks > base_ticks_
+        ? elapsed_us / static_cast<double>(now_ticks - base_ticks_) : 0.0;
+    const int pid = static_cast<int>(SAMPLE_EP_GETPID());
+
+    std::vector<DrainedSample> drained;
+    for (Ring* ring : rings) {
+        const uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t tail = ring->tail;
+        if (head - tail > kRingCapacity) {
+            dropped_ += head - tail - kRingCapacity;
+            tail = head - kRingCapacity;
+        }
+
+        drained.clear();
+        for (uint64_t i = tail; i < head; ++i) {
+            const Sample& s = ring->samples[i & (kRingCapacity - 1)];
+            drained.push_back({i, s.start.load(std::memory_order_relaxed),
+                               s.end.load(std::memory_order_relaxed),
+                               s.bytes.load(std::memory_order_relaxed),
+                               s.node.load(std::memory_order_relaxed),
+                               s.chunks.load(std::memory_order_relaxed),
+                               s.plan_built.load(std::memory_order_relaxed)});
+        }
+        ring->tail = head;
+
+        // Slots the owner may have started overwriting while we copied them are dropped
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t head_after = ring->head.load(std::memory_order_relaxed);
+
+        if (file_ == nullptr) continue;
+        for (const DrainedSample& s : drained) {
+            if (s.index + kRingCapacity <= head_after) {
+                ++dropped_;
+                continue;
+            }
+
+            const double ts = static_cast<double>(s.start - base_ticks_) * us_per_tick;
+            const double dur = static_cast<double>(s.end - s.start) * us_per_tick;
+
+            std::fputs(first_event_ ? "\n" : ",\n", file_);
+            first_event_ = false;
+            std::fputs("{\"name\":", file_);
+            if (s.node == kRunNode) {
+                WriteJsonString(file_, "SampleEP run");
+            } else if (s.node < nodes.size()) {
+                WriteJsonString(file_, nodes[s.node].name);
+            } else {
+                WriteJsonString(file_, "unknown");
+            }
+            std::fprintf(file_, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u",
+                         s.node == kRunNode ? "Session" : "Node", ts, dur, pid, ring->tid);
+            if (s.node != kRunNode && s.node < nodes.size()) {
+                std::fputs(",\"args\":{\"op_name\":\"SampleEPFused\",\"kernel\":", file_);
+                WriteJsonString(file_, nodes[s.node].kernel);
+                std::fprintf(file_, ",\"bytes\":%llu,\"chunks\":%u,\"plan_built\":%s}",
+                             static_cast<unsigned long long>(s.bytes), s.chunks,
+                             s.plan_built ? "true" : "false");
+            }
+            std::fputs("}", file_);
+        }
+    }
+
+    if (file_ != nullptr) {
+        if (dropped_ != reported_dropped_) {
+            std::fputs(first_event_ ? "\n" : ",\n", file_);
+            std::fprintf(file_, "{\"name\":\"SampleEP dropped samples\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":%d,"
+                         "\"args\":{\"dropped\":%llu}}",
+                         elapsed_us, pid, static_cast<unsigned long long>(dropped_));
+            first_event_ = false;
+            reported_dropped_ = dropped_;
+        }
+        std::fflush(file_);
+    }
+    return ok;
+}
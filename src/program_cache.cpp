@@ -0,0 +1,427 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// On-disk cache of compiled partitions, memory-mapped and shared by every process on a host
+
+#include "program_cache.h"
+#include "ort_utils.h"
+#include "op_registry.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <process.h>
+#define SAMPLE_EP_GETPID _getpid
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SAMPLE_EP_GETPID getpid
+#endif
+
+namespace {
+
+// File layout, all fields native-endian and every offset relative to the start of the file:
+//   FileHeader
+//   FileEntry[num_entries], sorted by key
+//   records, each a RecordHeader, uint8_t types[num_registers], FlatInstr[num_code] and
+//   uint32_t outputs[num_outputs], starting on an 8-byte boundary and read with memcpy
+constexpr char kMagic[8] = {'S', 'E', 'P', 'P', 'R', 'O', 'G', '\0'};
+constexpr uint32_t kFormatVersion = 5;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t num_entries;
+};
+
+struct FileEntry {
+    uint64_t key;
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct RecordHeader {
+    uint32_t num_inputs;
+    uint32_t num_registers;
+    uint32_t num_code;
+    uint32_t num_outputs;
+    uint32_t row_axis_begin;
+    uint32_t row_axis_end;
+    uint32_t row_keep_dims;
+    float row_epsilon;
+    uint32_t row_transposed;
+};
+
+struct FlatInstr {
+    uint8_t op;
+    uint8_t epilogue;
+    uint16_t dst;
+    uint16_t src[3];
+};
+
+// FNV-1a
+struct Hasher {
+    uint64_t state = 0xcbf29ce484222325ull;
+
+    void Add(const void* data, size_t size) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            state = (state ^ bytes[i]) * 0x100000001b3ull;
+        }
+    }
+
+    // Strings are length-prefixed so that ("ab", "c") and ("a", "bc") differ
+    void Add(const char* s) {
+        const uint64_t size = s ? std::strlen(s) : 0;
+        Add(&size, sizeof(size));
+        if (size) Add(s, size);
+    }
+};
+
+OrtStatus* HashValueNames(const OrtApi* api, const std::vector<const OrtValueInfo*>& values,
+                          Hasher* hasher) {
+    const uint64_t count = values.size();
+    hasher->Add(&count, sizeof(count));
+    for (const OrtValueInfo* value : values) {
+        const char* name = nullptr;
+        if (value != nullptr) RETURN_IF_ERROR(api->GetValueInfoName(value, &name));
+        hasher->Add(name);
+    }
+    return nullptr;
+}
+
+std::vector<uint8_t> EncodeProgram(const ExprProgram& program) {
+    RecordHeader header{};
+    header.num_inputs = program.num_inputs;
+    header.num_registers = program.num_registers;
+    header.num_code = static_cast<uint32_t>(program.code.size());
+    header.num_outputs = static_cast<uint32_t>(program.outputs.size());
+    header.row_axis_begin = program.row.axis_begin;
+    header.row_axis_end = program.row.axis_end;
+    header.row_keep_dims = program.row.keep_dims ? 1 : 0;
+    header.row_epsilon = program.row.epsilon;
+    header.row_transposed = program.row.transposed ? 1 : 0;
+
+    std::vector<uint8_t> record(sizeof(header) + program.types.size() +
+                                program.code.size() * sizeof(FlatInstr) +
+                                program.outputs.size() * sizeof(uint32_t));
+    uint8_t* p = record.data();
+    std::memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    for (DataType type : program.types) *p++ = static_cast<uint8_t>(type);
+    for (const Instr& instr : program.code) {
+        FlatInstr flat{static_cast<uint8_t>(instr.op), static_cast<uint8_t>(instr.epilogue), instr.dst,
+                       {instr.src[0], instr.src[1], instr.src[2]}};
+        std::memcpy(p, &flat, sizeof(flat));
+        p += sizeof(flat);
+    }
+    if (!program.outputs.empty()) {
+        std::memcpy(p, program.outputs.data(), program.outputs.size() * sizeof(uint32_t));
+    }
+    return record;
+}
+
+bool DecodeProgram(const uint8_t* data, size_t size, ExprProgram* program) {
+    RecordHeader header;
+    if (size < sizeof(header)) return false;
+    std::memcpy(&header, data, sizeof(header));
+
+    const uint64_t expected = sizeof(header) + uint64_t(header.num_registers) +
+                              uint64_t(header.num_code) * sizeof(FlatInstr) +
+                              uint64_t(header.num_outputs) * sizeof(uint32_t);
+    if (expected != size) return false;
+
+    program->num_inputs = header.num_inputs;
+    program->num_registers = header.num_registers;
+    program->row.axis_begin = header.row_axis_begin;
+    program->row.axis_end = header.row_axis_end;
+    program->row.keep_dims = header.row_keep_dims != 0;
+    program->row.epsilon = header.row_epsilon;
+    program->row.transposed = header.row_transposed != 0;
+
+    const uint8_t* p = data + sizeof(header);
+    program->types.resize(header.num_registers);
+    for (DataType& type : program->types) type = static_cast<DataType>(*p++);  // Checked by ValidateProgram
+    program->code.resize(header.num_code);
+    for (Instr& instr : program->code) {
+        FlatInstr flat;
+        std::memcpy(&flat, p, sizeof(flat));
+        p += sizeof(flat);
+        instr.op = static_cast<OpCode>(flat.op);
+        instr.epilogue = static_cast<Activation>(flat.epilogue);
+        instr.dst = flat.dst;
+        for (size_t k = 0; k < 3; ++k) instr.src[k] = flat.src[k];
+    }
+    program->outputs.resize(header.num_outputs);
+    if (header.num_outputs > 0) {
+        std::memcpy(program->outputs.data(), p, header.num_outputs * sizeof(uint32_t));
+    }
+    return ValidateProgram(*program);
+}
+
+// Header and entry table of a mapping, or false if it is not a valid cache file
+bool ReadTable(const uint8_t* data, size_t size, uint64_t* num_entries) {
+    FileHeader header;
+    if (data == nullptr || size < sizeof(header)) return false;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kFormatVersion ||
+        header.byte_order != kByteOrderMark) {
+        return false;
+    }
+    if (header.num_entries > (size - sizeof(header)) / sizeof(FileEntry)) return false;
+    *num_entries = header.num_entries;
+    return true;
+}
+
+FileEntry EntryAt(const uint8_t* data, uint64_t index) {
+    FileEntry entry;
+    std::memcpy(&entry, data + sizeof(FileHeader) + index * sizeof(FileEntry), sizeof(entry));
+    return entry;
+}
+
+}  // namespace
+
+OrtStatus* HashFusedGraph(const OrtApi* api, const OrtGraph* graph, const OrtNode* fused_node,
+                          const KernelTable& kernels, uint64_t* key) {
+    Hasher hasher;
+    hasher.Add(&kFormatVersion, sizeof(kFormatVersion));
+    hasher.Add(kernels.name);
+
+    // Partition boundary: value names order the registers, types and shapes pick the plan
+    std::vector<const OrtValueInfo*> inputs;
+    std::vector<const OrtValueInfo*> outputs;
+    RETURN_IF_ERROR(GetNodeInputs(api, fused_node, &inputs));
+    RETURN_IF_ERROR(GetNodeOutputs(api, fused_node, &outputs));
+    RETURN_IF_ERROR(HashValueNames(api, inputs, &hasher));
+    RETURN_IF_ERROR(HashValueNames(api, outputs, &hasher));
+    for (const OrtValueInfo* input : inputs) {
+        ONNXTensorElementDataType elem_type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+        std::string shape_key;
+        if (input != nullptr) RETURN_IF_ERROR(GetValueTensorInfo(api, input, &elem_type, &shape_key));
+        hasher.Add(&elem_type, sizeof(elem_type));
+        hasher.Add(shape_key.c_str());
+    }
+
+    // Subgraph: every node's op and opset version, wiring, and the output types and attributes
+    // lowering depends on. Defaults change between versions, e.g. Softmax's axis at opset 13.
+    std::vector<const OrtNode*> nodes;
+    RETURN_IF_ERROR(GetGraphNodes(api, graph, &nodes));
+    for (const OrtNode* node : nodes) {
+        const char* op_type = nullptr;
+        const char* domain = nullptr;
+        RETURN_IF_ERROR(api->Node_GetOperatorType(node, &op_type));
+        RETURN_IF_ERROR(api->Node_GetDomain(node, &domain));
+        hasher.Add(domain);
+        hasher.Add(op_type);
+        int since_version = 0;
+        RETURN_IF_ERROR(api->Node_GetSinceVersion(node, &since_version));
+        hasher.Add(&since_version, sizeof(since_version));
+
+        std::vector<const OrtValueInfo*> node_inputs;
+        std::vector<const OrtValueInfo*> node_outputs;
+        RETURN_IF_ERROR(GetNodeInputs(api, node, &node_inputs));
+        RETURN_IF_ERROR(GetNodeOutputs(api, node, &node_outputs));
+        RETURN_IF_ERROR(HashValueNames(api, node_inputs, &hasher));
+        RETURN_IF_ERROR(HashValueNames(api, node_outputs, &hasher));
+        for (const OrtValueInfo* output : node_outputs) {
+            ONNXTensorElementDataType elem_type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+            std::string shape_key;
+            if (output != nullptr) RETURN_IF_ERROR(GetValueTensorInfo(api, output, &elem_type, &shape_key));
+            hasher.Add(&elem_type, sizeof(elem_type));
+        }
+
+        std::string approximate;
+        bool found = false;
+        RETURN_IF_ERROR(GetStringAttribute(api, node, "approximate", &approximate, &found));
+        hasher.Add(found ? approximate.c_str() : nullptr);
+
+        // Row op axes and settings, including axes given as a constant input
+        for (const char* name : {"axis", "keepdims", "noop_with_empty_axes", "stash_type", "transA", "transB"}) {
+            int64_t value = 0;
+            RETURN_IF_ERROR(GetIntAttribute(api, node, name, &value, &found));
+            hasher.Add(&found, sizeof(found));
+            hasher.Add(&value, sizeof(value));
+        }
+        for (const char* name : {"epsilon", "alpha", "beta"}) {
+            float value = 0;
+            RETURN_IF_ERROR(GetFloatAttribute(api, node, name, &value, &found));
+            hasher.Add(&found, sizeof(found));
+            hasher.Add(&value, sizeof(value));
+        }
+
+        std::vector<int64_t> axes;
+        RETURN_IF_ERROR(GetIntsAttribute(api, node, "axes", &axes, &found));
+        const OpDescriptor* desc = FindOp(domain, op_type);
+        if (!found && desc != nullptr && desc->form == OpForm::Reduce && node_inputs.size() > 1 &&
+            node_inputs[1] != nullptr) {
+            RETURN_IF_ERROR(GetInitializerInts(api, node_inputs[1], &axes, &found));
+        }
+        const uint64_t num_axes = axes.size();
+        hasher.Add(&num_axes, sizeof(num_axes));
+        if (!axes.empty()) hasher.Add(axes.data(), axes.size() * sizeof(int64_t));
+    }
+
+    *key = hasher.state;
+    return nullptr;
+}
+
+ProgramCache::ProgramCache(std::string dir)
+    : path_(std::move(dir) + "/" + kFileName) {
+    Open(path_, &mapping_);
+}
+
+ProgramCache::~ProgramCache() {
+    Close(&mapping_);
+}
+
+void ProgramCache::Open(const std::string& path, Mapping* mapping) {
+#if defined(_WIN32)
+    // No mmap; read the file instead. The pages are then private to this process.
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) return;
+    uint8_t chunk[65536];
+    for (size_t n; (n = std::fread(chunk, 1, sizeof(chunk), file)) > 0;) {
+        mapping->buffer.insert(mapping->buffer.end(), chunk, chunk + n);
+    }
+    std::fclose(file);
+    mapping->data = mapping->buffer.data();
+    mapping->size = mapping->buffer.size();
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED) {
+            mapping->data = static_cast<const uint8_t*>(data);
+            mapping->size = static_cast<size_t>(st.st_size);
+            mapping->mapped = true;
+        }
+    }
+    ::close(fd);  // The mapping stays valid, and survives the file being replaced
+#endif
+
+    uint64_t num_entries = 0;
+    if (!ReadTable(mapping->data, mapping->size, &num_entries)) Close(mapping);
+}
+
+void ProgramCache::Close(Mapping* mapping) {
+#if !defined(_WIN32)
+    if (mapping->mapped) ::munmap(const_cast<uint8_t*>(mapping->data), mapping->size);
+#endif
+    *mapping = Mapping();
+}
+
+std::pair<const uint8_t*, size_t> ProgramCache::Lookup(const Mapping& mapping, uint64_t key) {
+    uint64_t num_entries = 0;
+    if (!ReadTable(mapping.data, mapping.size, &num_entries)) return {nullptr, 0};
+
+    // Binary search over the sorted entry table
+    uint64_t lo = 0;
+    uint64_t hi = num_entries;
+    while (lo < hi) {
+        const uint64_t mid = lo + (hi - lo) / 2;
+        const FileEntry entry = EntryAt(mapping.data, mid);
+        if (entry.key < key) {
+            lo = mid + 1;
+        } else if (entry.key > key) {
+            hi = mid;
+        } else {
+            if (entry.offset > mapping.size || entry.size > mapping.size - entry.offset) return {nullptr, 0};
+            return {mapping.data + entry.offset, static_cast<size_t>(entry.size)};
+        }
+    }
+    return {nullptr, 0};
+}
+
+bool ProgramCache::Find(uint64_t key, ExprProgram* program) const {
+    const auto record = Lookup(mapping_, key);
+    return record.first != nullptr && DecodeProgram(record.first, record.second, program);
+}
+
+void ProgramCache::Add(uint64_t key, const ExprProgram& program) {
+    pending_.emplace_back(key, EncodeProgram(program));
+}
+
+bool ProgramCache::Commit() {
+    if (pending_.empty()) return true;
+
+    // Start from the file as it is now, which other processes may have extended since we
+    // mapped it
+    Mapping current;
+    Open(path_, &current);
+    uint64_t num_current = 0;
+    ReadTable(current.data, current.size, &num_current);
+
+    std::vector<std::pair<uint64_t, std::pair<const uint8_t*, size_t>>> records;
+    for (uint64_t i = 0; i < num_current; ++i) {
+        const FileEntry entry = EntryAt(current.data, i);
+        const auto record = Lookup(current, entry.key);
+        if (record.first != nullptr) records.push_back({entry.key, record});
+    }
+    for (const auto& p : pending_) {
+        records.push_back({p.first, {p.second.data(), p.second.size()}});
+    }
+
+    // Sort by key; the existing record wins over a pending one with the same key
+    std::stable_sort(records.begin(), records.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    records.erase(std::unique(records.begin(), records.end(),
+                              [](const auto& a, const auto& b) { return a.first == b.first; }),
+                  records.end());
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.byte_order = kByteOrderMark;
+    header.num_entries = records.size();
+
+    std::vector<FileEntry> entries(records.size());
+    uint64_t offset = sizeof(FileHeader) + records.size() * sizeof(FileEntry);
+    for (size_t i = 0; i < records.size(); ++i) {
+        offset = (offset + 7) & ~uint64_t(7);
+        entries[i] = {records[i].first, offset, records[i].second.second};
+        offset += records[i].second.second;
+    }
+
+    // Write a private temporary file, then rename it over the cache so the swap is atomic
+    const std::string tmp_path = path_ + "." + std::to_string(SAMPLE_EP_GETPID()) + ".tmp";
+    std::FILE* file = std::fopen(tmp_path.c_str(), "wb");
+    bool ok = file != nullptr;
+    if (ok) {
+        ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+        if (ok && !entries.empty()) {
+            ok = std::fwrite(entries.data(), sizeof(FileEntry), entries.size(), file) == entries.size();
+        }
+        uint64_t written = sizeof(FileHeader) + entries.size() * sizeof(FileEntry);
+        const uint8_t zeros[8] = {};
+        for (size_t i = 0; ok && i < records.size(); ++i) {
+            const size_t padding = static_cast<size_t>(entries[i].offset - written);
+            ok = std::fwrite(zeros, 1, padding, file) == padding &&
+                 std::fwrite(records[i].second.first, 1, records[i].second.second, file) ==
+                     records[i].second.second;
+            written = entries[i].offset + entries[i].size;
+        }
+        ok = std::fclose(file) == 0 && ok;
+    }
+    Close(&current);
+    pending_.clear();
+
+#if defined(_WIN32)
+    if (ok) std::remove(path_.c_str());  // rename does not replace existing files here
+#endif
+    if (ok) ok = std::rename(tmp_path.c_str(), path_.c_str()) == 0;
+    if (!ok) {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    Close(&mapping_);
+    Open(path_, &mapping_);
+    return true;
+}
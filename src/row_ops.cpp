@@ -0,0 +1,434 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Row ops: reductions, normalizations and MatMul fused with the elementwise code around them
+
+#include "row_ops.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// Operand bytes handed to one thread at a time, as for elementwise chunks
+constexpr size_t kRowChunkBytes = size_t(256) << 10;
+
+// Operand elements per block of a split reduction. Fixed, so that deterministic results do
+// not depend on how many threads run the blocks.
+constexpr size_t kReduceBlockElements = size_t(16) << 10;
+
+// Reductions are split along n only when there are too few rows to go around the threads
+constexpr size_t kMaxSplitRows = 8;
+
+// Weight bytes per column block of a MatMul split by columns
+constexpr size_t kColumnBlockBytes = size_t(64) << 10;
+
+// MatMul chunks hold a multiple of the GEMM tile height in rows, and at most about this many
+// multiply-adds, which bound a chunk's time better than its bytes do
+constexpr size_t kGemmRowGroup = 4;
+constexpr size_t kGemmChunkMacs = size_t(256) << 10;
+
+constexpr uint32_t kNoRegister = std::numeric_limits<uint32_t>::max();
+
+// Copy the instructions `outputs` depend on into `sub` as a program of its own. Its inputs are
+// the partition inputs it reads, listed in *inputs, then `boundary` if given: a computed
+// register whose instruction is not copied and which the sub-program reads as its last input.
+// Instructions other than the boundary's are copied wherever they are needed, so values ahead
+// of the row op are recomputed rather than kept.
+void ExtractProgram(const ExprProgram& program, const std::vector<uint32_t>& outputs, uint32_t boundary,
+                    ExprProgram* sub, std::vector<uint32_t>* inputs) {
+    std::vector<bool> needed(program.num_registers, false);
+    for (uint32_t reg : outputs) needed[reg] = true;
+    for (size_t i = program.code.size(); i-- > 0;) {
+        const Instr& instr = program.code[i];
+        if (!needed[instr.dst] || instr.dst == boundary) continue;
+        for (size_t k = 0; k < OpArity(instr.op); ++k) needed[instr.src[k]] = true;
+    }
+
+    *sub = ExprProgram();
+    inputs->clear();
+    std::vector<uint32_t> renumber(program.num_registers, kNoRegister);
+    for (uint32_t r = 0; r < program.num_inputs; ++r) {
+        if (!needed[r]) continue;
+        renumber[r] = static_cast<uint32_t>(sub->types.size());
+        inputs->push_back(r);
+        sub->types.push_back(program.types[r]);
+    }
+    if (boundary != kNoRegister) {
+        renumber[boundary] = static_cast<uint32_t>(sub->types.size());
+        sub->types.push_back(program.types[boundary]);
+    }
+    sub->num_inputs = static_cast<uint32_t>(sub->types.size());
+
+    for (const Instr& instr : program.code) {
+        if (!needed[instr.dst] || instr.dst == boundary) continue;
+        Instr copy = instr;
+        copy.dst = static_cast<uint16_t>(sub->types.size());
+        for (size_t k = 0; k < OpArity(instr.op); ++k) copy.src[k] = static_cast<uint16_t>(renumber[instr.src[k]]);
+        renumber[instr.dst] = copy.dst;
+        sub->code.push_back(copy);
+        sub->types.push_back(program.types[instr.dst]);
+    }
+    sub->num_registers = static_cast<uint32_t>(sub->types.size());
+    for (uint32_t reg : outputs) sub->outputs.push_back(renumber[reg]);
+}
+
+// ExecuteProgram addresses element e of its iteration space at base + e. A buffer holding the
+// elements from `first` on is therefore passed as a base `first` elements ahead of it.
+void* Rebase(const float* buffer, size_t first) {
+    return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(buffer) - first * sizeof(float));
+}
+
+// y[j] = sum or max over r of x[r * inner + j], for j in [0, inner)
+void ReduceRows(const RowKernels& kernels, OpCode op, const float* x, float* y, size_t rows, size_t inner) {
+    const bool max = op == OpCode::ReduceMax;
+    if (rows == 0) {
+        std::fill(y, y + inner, max ? -std::numeric_limits<float>::infinity() : 0.0f);
+    } else if (inner == 1) {
+        *y = max ? kernels.max(x, rows) : kernels.sum(x, rows);
+    } else {
+        std::memcpy(y, x, inner * sizeof(float));
+        const auto accumulate = max ? kernels.accumulate_max : kernels.accumulate_sum;
+        for (size_t r = 1; r < rows; ++r) accumulate(x + r * inner, y, inner);
+    }
+}
+
+void FinishMean(float* y, size_t inner, size_t n) {
+    const auto count = static_cast<float>(n);
+    for (size_t j = 0; j < inner; ++j) y[j] /= count;
+}
+
+// Per-thread buffers for the rows in flight, reused across calls
+struct RowBuffers {
+    std::vector<float> operand;
+    std::vector<float> result;
+    std::vector<const void*> inputs;
+};
+
+RowBuffers& ThreadBuffers() {
+    static thread_local RowBuffers buffers;
+    return buffers;
+}
+
+// Sub-program arguments for one call, set up by the calling thread and read by all
+struct RowCall {
+    std::vector<const void*> prologue_inputs;
+    std::vector<const void*> epilogue_inputs;  // The row result is filled in per chunk
+    std::vector<void*> epilogue_outputs;
+    std::vector<float> partials;  // Split reductions: per block
+    std::vector<float> reduced;   // Split reductions: the result, when no output holds it
+};
+
+// Run the epilogue over elements [begin, end) of the result, with `result` holding them
+void RunEpilogue(const RowPlan& row, const RowCall& call, const float* result, size_t begin, size_t end) {
+    std::vector<const void*>& inputs = ThreadBuffers().inputs;
+    inputs.assign(call.epilogue_inputs.begin(), call.epilogue_inputs.end());
+    inputs.back() = Rebase(result, begin);
+    ExecuteProgram(row.epilogue, row.epilogue_plan, inputs.data(), call.epilogue_outputs.data(), begin, end);
+}
+
+// All three stages for outer indices [first, first + count)
+void RunRows(const RowPlan& row, const KernelTable& table, const PackedWeight* weight, const RowCall& call,
+             const void* const* inputs, void* const* outputs, size_t first, size_t count) {
+    const RowKernels& kernels = table.row;
+    RowBuffers& buffers = ThreadBuffers();
+    const bool has_prologue = !row.prologue.code.empty();
+
+    const float* operand;
+    if (has_prologue) {
+        buffers.operand.resize(count * row.operand_slab);
+        void* out = Rebase(buffers.operand.data(), first * row.operand_slab);
+        ExecuteProgram(row.prologue, row.prologue_plan, call.prologue_inputs.data(), &out,
+                       first * row.operand_slab, (first + count) * row.operand_slab);
+        operand = buffers.operand.data();
+    } else {
+        operand = static_cast<const float*>(inputs[row.operand_input]) + first * row.operand_slab;
+    }
+
+    // Normalizations overwrite a computed operand in place
+    float* result;
+    if (row.result_output >= 0) {
+        result = static_cast<float*>(outputs[row.result_output]) + first * row.result_slab;
+    } else if (has_prologue && (row.op == OpCode::Softmax || row.op == OpCode::LayerNorm)) {
+        result = buffers.operand.data();
+    } else {
+        buffers.result.resize(count * row.result_slab);
+        result = buffers.result.data();
+    }
+
+    if (row.op == OpCode::MatMul) {
+        table.gemm.multiply(operand, count, row.n, weight->panels.data(), row.columns, 0, row.columns, result);
+    }
+    for (size_t r = 0; r < count && row.op != OpCode::MatMul; ++r) {
+        const float* x = operand + r * row.operand_slab;
+        float* y = result + r * row.result_slab;
+        switch (row.op) {
+            case OpCode::Softmax:
+                kernels.softmax(x, y, row.n);
+                break;
+            case OpCode::LayerNorm:
+                kernels.layer_norm(x, y, row.n, row.epsilon);
+                break;
+            default:
+                ReduceRows(kernels, row.op, x, y, row.n, row.inner);
+                if (row.op == OpCode::ReduceMean) FinishMean(y, row.inner, row.n);
+                break;
+        }
+    }
+
+    if (!row.epilogue.code.empty()) {
+        RunEpilogue(row, call, result, first * row.result_slab, (first + count) * row.result_slab);
+    }
+}
+
+// Reduce blocks of each row in parallel, then combine them pairwise: block b absorbs block
+// b + step for step = 1, 2, 4, ..., so the order of the additions depends only on the
+// block count
+void RunSplitReduction(const RowPlan& row, const RowKernels& kernels, ThreadPool* pool, bool deterministic,
+                       RowCall& call, const void* const* inputs, void* const* outputs) {
+    const auto* operand = static_cast<const float*>(inputs[row.operand_input]);
+    size_t block = row.reduce_block;
+    size_t blocks = (row.n + block - 1) / block;
+    if (!deterministic) {
+        const size_t threads = pool ? pool->NumThreads() : 1;
+        blocks = std::min(blocks, std::max<size_t>(1, (threads + row.outer - 1) / row.outer));
+        block = (row.n + blocks - 1) / blocks;
+        blocks = (row.n + block - 1) / block;
+    }
+
+    call.partials.resize(row.outer * blocks * row.inner);
+    float* partials = call.partials.data();
+    auto reduce_block = [&](size_t task) {
+        const size_t o = task / blocks;
+        const size_t first = task % blocks * block;
+        ReduceRows(kernels, row.op, operand + o * row.operand_slab + first * row.inner,
+                   partials + task * row.inner, std::min(block, row.n - first), row.inner);
+    };
+    const size_t tasks = row.outer * blocks;
+    if (pool != nullptr && tasks > 1) {
+        pool->ParallelFor(tasks, reduce_block);
+    } else {
+        for (size_t task = 0; task < tasks; ++task) reduce_block(task);
+    }
+
+    float* result;
+    if (row.result_output >= 0) {
+        result = static_cast<float*>(outputs[row.result_output]);
+    } else {
+        call.reduced.resize(row.outer * row.inner);
+        result = call.reduced.data();
+    }
+    const auto accumulate = row.op == OpCode::ReduceMax ? kernels.accumulate_max : kernels.accumulate_sum;
+    for (size_t o = 0; o < row.outer; ++o) {
+        float* p = partials + o * blocks * row.inner;
+        for (size_t step = 1; step < blocks; step *= 2) {
+            for (size_t b = 0; b + step < blocks; b += 2 * step) {
+                accumulate(p + (b + step) * row.inner, p + b * row.inner, row.inner);
+            }
+        }
+        float* y = result + o * row.inner;
+        std::memcpy(y, p, row.inner * sizeof(float));
+        if (row.op == OpCode::ReduceMean) FinishMean(y, row.inner, row.n);
+    }
+
+    if (!row.epilogue.code.empty()) RunEpilogue(row, call, result, 0, row.outer * row.inner);
+}
+
+// Multiply all rows by blocks of weight columns in parallel, for MatMuls with too few rows
+// to go around the threads
+void RunSplitColumns(const RowPlan& row, const GemmKernels& gemm, const PackedWeight& weight, ThreadPool* pool,
+                     RowCall& call, const void* const* inputs, void* const* outputs) {
+    const auto* operand = static_cast<const float*>(inputs[row.operand_input]);
+    float* result;
+    if (row.result_output >= 0) {
+        result = static_cast<float*>(outputs[row.result_output]);
+    } else {
+        call.reduced.resize(row.outer * row.columns);
+        result = call.reduced.data();
+    }
+
+    const size_t block_columns = row.column_block * gemm.panel_width;
+    auto multiply_block = [&](size_t block) {
+        const size_t begin = block * block_columns;
+        gemm.multiply(operand, row.outer, row.n, weight.panels.data(), row.columns, begin,
+                      std::min(row.columns, begin + block_columns), result);
+    };
+    const size_t blocks = (row.columns + block_columns - 1) / block_columns;
+    if (pool != nullptr && blocks > 1) {
+        pool->ParallelFor(blocks, multiply_block);
+    } else {
+        for (size_t block = 0; block < blocks; ++block) multiply_block(block);
+    }
+
+    if (!row.epilogue.code.empty()) RunEpilogue(row, call, result, 0, row.outer * row.columns);
+}
+
+}  // namespace
+
+void PackedWeight::Pack(const GemmKernels& kernels, const float* b, size_t k_dim, size_t n_dim, bool transposed) {
+    k = k_dim;
+    n = n_dim;
+    const size_t panels_count = (n + kernels.panel_width - 1) / kernels.panel_width;
+    panels.assign(panels_count * kernels.panel_width * k, 0.0f);
+    kernels.pack(b, k, n, transposed, panels.data());
+}
+
+PlanStatus BuildRowPlan(const ExprProgram& program, const KernelTable& kernels,
+                        const ShapeRef* shapes, const PlanOptions& options, ExecutionPlan* plan) {
+    auto row = std::make_unique<RowPlan>();
+    const Instr& instr = program.code[FindRowInstr(program)];
+    const RowSpec& spec = program.row;
+    row->op = instr.op;
+    row->epsilon = spec.epsilon;
+
+    // Sub-plans run over the ranges the row loop hands them, so they are never chunked
+    PlanOptions sub_options = options;
+    sub_options.parallel_threshold = std::numeric_limits<size_t>::max();
+
+    std::vector<ShapeRef> sub_shapes;
+    std::vector<int64_t> operand_dims;
+    const uint32_t operand = instr.src[0];
+    if (operand < program.num_inputs) {
+        row->operand_input = operand;
+        operand_dims.assign(shapes[operand].dims, shapes[operand].dims + shapes[operand].rank);
+    } else {
+        ExtractProgram(program, {operand}, kNoRegister, &row->prologue, &row->prologue_inputs);
+        for (uint32_t k : row->prologue_inputs) sub_shapes.push_back(shapes[k]);
+        const PlanStatus status =
+            BuildExecutionPlan(row->prologue, kernels, sub_shapes.data(), sub_options, &row->prologue_plan);
+        if (status != PlanStatus::Ok) return status;
+        operand_dims = row->prologue_plan.broadcast.output_dims;
+    }
+
+    if (spec.axis_end > operand_dims.size()) return PlanStatus::UnsupportedShapes;
+    if (row->op == OpCode::MatMul) {
+        const ShapeRef& weight = shapes[instr.src[1]];
+        if (weight.rank != 2 || spec.axis_end != operand_dims.size() || spec.axis_begin + 1 != spec.axis_end ||
+            weight.dims[spec.transposed ? 1 : 0] != operand_dims.back()) {
+            return PlanStatus::IncompatibleShapes;
+        }
+        row->columns = static_cast<size_t>(weight.dims[spec.transposed ? 0 : 1]);
+    }
+    std::vector<int64_t> result_dims;
+    for (size_t d = 0; d < operand_dims.size(); ++d) {
+        const auto dim = static_cast<size_t>(operand_dims[d]);
+        const bool reduced = d >= spec.axis_begin && d < spec.axis_end;
+        if (d < spec.axis_begin) row->outer *= dim;
+        else if (reduced) row->n *= dim;
+        else row->inner *= dim;
+
+        if (row->op == OpCode::MatMul && reduced) result_dims.push_back(static_cast<int64_t>(row->columns));
+        else if (!reduced || !IsReduceOp(row->op)) result_dims.push_back(operand_dims[d]);
+        else if (spec.keep_dims) result_dims.push_back(1);
+    }
+
+    // The normalization kernels work on contiguous rows
+    if (!IsReduceOp(row->op) && row->inner != 1) return PlanStatus::UnsupportedShapes;
+    row->operand_slab = row->n * row->inner;
+    row->result_slab = IsReduceOp(row->op) ? row->inner : row->op == OpCode::MatMul ? row->columns : row->operand_slab;
+
+    std::vector<uint32_t> epilogue_regs;
+    for (size_t k = 0; k < program.outputs.size(); ++k) {
+        if (program.outputs[k] == instr.dst) {
+            row->result_output = static_cast<int64_t>(k);
+        } else {
+            row->epilogue_outputs.push_back(static_cast<uint32_t>(k));
+            epilogue_regs.push_back(program.outputs[k]);
+        }
+    }
+    if (!epilogue_regs.empty()) {
+        ExtractProgram(program, epilogue_regs, instr.dst, &row->epilogue, &row->epilogue_inputs);
+        sub_shapes.clear();
+        for (uint32_t k : row->epilogue_inputs) sub_shapes.push_back(shapes[k]);
+        sub_shapes.push_back(ShapeRef{result_dims.data(), result_dims.size()});
+        const PlanStatus status =
+            BuildExecutionPlan(row->epilogue, kernels, sub_shapes.data(), sub_options, &row->epilogue_plan);
+        if (status != PlanStatus::Ok) return status;
+
+        // Outputs are written densely over the row op's result
+        if (row->epilogue_plan.broadcast.output_dims != result_dims) return PlanStatus::UnsupportedShapes;
+    }
+    row->replicated_bytes = row->prologue_plan.replicated_bytes + row->epilogue_plan.replicated_bytes;
+
+    // A MatMul's work grows with its multiply-adds rather than its operand
+    const size_t operand_elements = row->outer * row->operand_slab;
+    const size_t work = row->op == OpCode::MatMul ? operand_elements * row->columns : operand_elements;
+    const bool parallel = work >= options.parallel_threshold;
+    if (parallel && IsReduceOp(row->op) && row->prologue.code.empty() && row->outer < kMaxSplitRows) {
+        const size_t block = std::max<size_t>(1, kReduceBlockElements / std::max<size_t>(1, row->inner));
+        if (row->n > block) row->reduce_block = block;
+    }
+    row->rows_per_chunk = std::max<size_t>(1, row->outer);
+    if (parallel && row->reduce_block == 0) {
+        const size_t row_bytes = (row->operand_slab + (row->op == OpCode::MatMul ? row->result_slab : 0)) * sizeof(float);
+        row->rows_per_chunk = std::max<size_t>(1, kRowChunkBytes / std::max<size_t>(1, row_bytes));
+        if (row->op == OpCode::MatMul) {
+            const size_t row_macs = std::max<size_t>(1, row->n * row->columns);
+            row->rows_per_chunk = std::min(row->rows_per_chunk, std::max<size_t>(1, kGemmChunkMacs / row_macs));
+            row->rows_per_chunk = (row->rows_per_chunk + kGemmRowGroup - 1) / kGemmRowGroup * kGemmRowGroup;
+        }
+    }
+    row->num_chunks = (row->outer + row->rows_per_chunk - 1) / row->rows_per_chunk;
+
+    const size_t panel_width = kernels.gemm.panel_width;
+    const size_t panels = (row->columns + panel_width - 1) / panel_width;
+    if (parallel && row->op == OpCode::MatMul && row->prologue.code.empty() && row->num_chunks == 1) {
+        const size_t panel_bytes = std::max<size_t>(1, row->n * panel_width * sizeof(float));
+        const size_t block = std::max<size_t>(1, kColumnBlockBytes / panel_bytes);
+        if (panels > block) row->column_block = block;
+    }
+
+    plan->broadcast = BroadcastPlan();
+    plan->broadcast.output_dims = result_dims;
+    plan->broadcast.total = 1;
+    for (int64_t dim : result_dims) plan->broadcast.total *= static_cast<size_t>(dim);
+    plan->num_chunks = row->num_chunks;
+    if (row->reduce_block > 0) plan->num_chunks = row->outer * ((row->n + row->reduce_block - 1) / row->reduce_block);
+    if (row->column_block > 0) plan->num_chunks = (panels + row->column_block - 1) / row->column_block;
+    plan->row = std::move(row);
+    return PlanStatus::Ok;
+}
+
+void RunRowPlan(const ExecutionPlan& plan, const KernelTable& kernels, ThreadPool* pool,
+                bool deterministic, const PackedWeight* weight, const void* const* inputs,
+                void* const* outputs, std::vector<char>* replicated) {
+    const RowPlan& row = *plan.row;
+    static thread_local RowCall thread_call;
+    RowCall& call = thread_call;  // Named so the chunk lambdas see the caller's copy
+
+    // Sub-program arguments, with their row-vector inputs tiled once for all chunks
+    replicated->resize(row.replicated_bytes);
+    char* scratch = replicated->data();
+    call.prologue_inputs.clear();
+    for (uint32_t k : row.prologue_inputs) call.prologue_inputs.push_back(inputs[k]);
+    if (!row.prologue.code.empty()) {
+        ReplicateInputs(row.prologue, row.prologue_plan, call.prologue_inputs.data(), scratch);
+        scratch += row.prologue_plan.replicated_bytes;
+    }
+    call.epilogue_inputs.clear();
+    for (uint32_t k : row.epilogue_inputs) call.epilogue_inputs.push_back(inputs[k]);
+    call.epilogue_inputs.push_back(nullptr);
+    call.epilogue_outputs.clear();
+    for (uint32_t k : row.epilogue_outputs) call.epilogue_outputs.push_back(outputs[k]);
+    if (!row.epilogue.code.empty()) {
+        ReplicateInputs(row.epilogue, row.epilogue_plan, call.epilogue_inputs.data(), scratch);
+    }
+
+    if (row.reduce_block > 0) {
+        RunSplitReduction(row, kernels.row, pool, deterministic, call, inputs, outputs);
+        return;
+    }
+    if (row.column_block > 0) {
+        RunSplitColumns(row, kernels.gemm, *weight, pool, call, inputs, outputs);
+        return;
+    }
+
+    auto run_chunk = [&](size_t chunk) {
+        const size_t first = chunk * row.rows_per_chunk;
+        RunRows(row, kernels, weight, call, inputs, outputs, first, std::min(row.rows_per_chunk, row.outer - first));
+    };
+    if (row.num_chunks == 1) {
+        run_chunk(0);
+    } else if (row.num_chunks > 1) {
+        pool->ParallelFor(row.num_chunks, run_chunk);
+    }
+}
@@ -3,9 +3,24 @@
 // Compatible with ONNX Runtime 1.22+
 
 #include "sample_ep.h"
+#include "allocator.h"
+#include "batching.h"
+#include "broadcast.h"
+#include "compiler.h"
+#include "counters.h"
+#include "data_transfer.h"
+#include "ep_context.h"
+#include "execution_plan.h"
+#include "numa.h"
+#include "ort_utils.h"
+#include "partitioner.h"
+#include "row_ops.h"
 #include <cstring>
 #include <cstddef>
+#include <algorithm>
 #include <cstdio>
+#include <numeric>
+#include <unordered_map>
 
 // Platform-specific export macro
 #if defined(_WIN32)
@@ -16,13 +31,6 @@
 #define EXPORT_SYMBOL
 #endif
 
-// Helper macro to get containing object from member pointer (like container_of in Linux kernel)
-#define CONTAINER_OF(ptr, type, member) \
-    reinterpret_cast<type*>(reinterpret_cast<char*>(ptr) - offsetof(type, member))
-
-#define CONTAINER_OF_CONST(ptr, type, member) \
-    reinterpret_cast<const type*>(reinterpret_cast<const char*>(ptr) - offsetof(type, member))
-
 // Global API pointers (initialized in CreateEpFactories)
 static ApiPtrs g_apis;
 
@@ -63,6 +71,19 @@ EXPORT_SYMBOL OrtStatus* ORT_API_CALL ReleaseEpFactory(OrtEpFactory* factory) no
     return nullptr;  // Success
 }
 
+// Read the EP's performance counters, summed over every thread of the process. Fills the
+// first `capacity` names and values (either may be null) and returns the number of counters.
+// Names are static strings. Not part of ORT's plugin API: metrics agents call it directly.
+EXPORT_SYMBOL size_t SampleEpGetCounters(const char** names, uint64_t* values, size_t capacity) noexcept {
+    uint64_t all[kNumCounters];
+    ReadCounters(all);
+    for (size_t i = 0; i < capacity && i < kNumCounters; ++i) {
+        if (names != nullptr) names[i] = CounterName(i);
+        if (values != nullptr) values[i] = all[i];
+    }
+    return kNumCounters;
+}
+
 }  // extern "C"
 
 // ============================================================================
@@ -78,7 +99,8 @@ const SampleEpFactory* SampleEpFactory::FromOrt(const OrtEpFactory* ort_factory)
 }
 
 SampleEpFactory::SampleEpFactory(const char* name, const ApiPtrs& apis)
-    : ep_name_(std::string(name) + "PluginExecutionProvider"), apis_(apis) {
+    : ep_name_(std::string(name) + "PluginExecutionProvider"), apis_(apis),
+      kernels_(&SelectKernelTable()) {
 
     // Zero-initialize the OrtEpFactory struct
     std::memset(&factory_, 0, sizeof(factory_));
@@ -102,9 +124,22 @@ SampleEpFactory::SampleEpFactory(const char* name, const ApiPtrs& apis)
     factory_.CreateDataTransfer = CreateDataTransferImpl;
     factory_.IsStreamAware = IsStreamAwareImpl;
     factory_.CreateSyncStreamForDevice = CreateSyncStreamForDeviceImpl;
+
+    // Describe the memory our allocator hands out: plain CPU memory, 64-byte aligned
+    OrtStatus* status = apis_.ort_api->CreateMemoryInfo_V2(
+        "SampleEP_CPU", OrtMemoryInfoDeviceType_CPU, /*vendor_id*/ 0, /*device_id*/ 0,
+        OrtDeviceMemoryType_DEFAULT, PoolAllocator::kAlignment, OrtDeviceAllocator, &memory_info_);
+    if (status != nullptr) {
+        apis_.ort_api->ReleaseStatus(status);
+        memory_info_ = nullptr;
+    }
 }
 
-SampleEpFactory::~SampleEpFactory() = default;
+SampleEpFactory::~SampleEpFactory() {
+    if (memory_info_ != nullptr) {
+        apis_.ort_api->ReleaseMemoryInfo(memory_info_);
+    }
+}
 
 const char* ORT_API_CALL SampleEpFactory::GetNameImpl(const OrtEpFactory* this_) noexcept {
     return FromOrt(this_)->ep_name_.c_str();
@@ -138,6 +173,18 @@ OrtStatus* ORT_API_CALL SampleEpFactory::GetSupportedDevicesImpl(
 
     *num_ep_devices = 0;
 
+    // Publish the NUMA layout so callers can pick a node for the numa_node option:
+    // "numa_nodes" lists the node ids and "numa_node.<id>.cpus" each node's CPUs
+    OrtKeyValuePairs* metadata = nullptr;
+    apis.ort_api->CreateKeyValuePairs(&metadata);
+    std::string node_ids;
+    for (const NumaNode& node : GetNumaNodes()) {
+        node_ids += (node_ids.empty() ? "" : ",") + std::to_string(node.id);
+        const std::string key = "numa_node." + std::to_string(node.id) + ".cpus";
+        apis.ort_api->AddKeyValuePair(metadata, key.c_str(), FormatCpuList(node.cpus).c_str());
+    }
+    apis.ort_api->AddKeyValuePair(metadata, "numa_nodes", node_ids.c_str());
+
     // Look through available hardware devices and claim CPU devices
     for (size_t i = 0; i < num_devices && *num_ep_devices < max_ep_devices; ++i) {
         const OrtHardwareDevice* hw_device = devices[i];
@@ -151,19 +198,31 @@ OrtStatus* ORT_API_CALL SampleEpFactory::GetSupportedDevicesImpl(
             OrtStatus* status = apis.ep_api->CreateEpDevice(
                 this_,
                 hw_device,
-                nullptr,  // ep_metadata
-                nullptr,  // ep_options
+                metadata,  // Copied into the device
+                nullptr,   // ep_options
                 &ep_device);
 
             if (status != nullptr) {
+                apis.ort_api->ReleaseKeyValuePairs(metadata);
                 return status;
             }
 
+            // Have ORT allocate this device's tensors through CreateAllocatorImpl
+            if (factory->memory_info_ != nullptr) {
+                status = apis.ep_api->EpDevice_AddAllocatorInfo(ep_device, factory->memory_info_);
+                if (status != nullptr) {
+                    apis.ep_api->ReleaseEpDevice(ep_device);
+                    apis.ort_api->ReleaseKeyValuePairs(metadata);
+                    return status;
+                }
+            }
+
             ep_devices[*num_ep_devices] = ep_device;
             (*num_ep_devices)++;
         }
     }
 
+    apis.ort_api->ReleaseKeyValuePairs(metadata);
     return nullptr;  // Success
 }
 
@@ -179,10 +238,24 @@ OrtStatus* ORT_API_CALL SampleEpFactory::CreateEpImpl(
     (void)devices;
     (void)ep_metadata_pairs;
     (void)num_devices;
-    (void)session_options;
 
     auto* factory = FromOrt(this_);
-    auto* sample_ep = new SampleEp(factory, logger);
+    const OrtApi* api = factory->GetApis().ort_api;
+
+    SampleEpOptions options;
+    RETURN_IF_ERROR(ParseEpOptions(api, session_options, factory->GetEpName(), &options));
+
+    const KernelTable* kernels = &factory->GetKernels();
+    if (options.force_isa) {
+        kernels = GetKernelTable(options.isa);
+        if (kernels == nullptr) {
+            std::string msg = std::string("EP option 'isa': ") + IsaName(options.isa) +
+                              " kernels are not available on this CPU or in this build";
+            return api->CreateStatus(ORT_INVALID_ARGUMENT, msg.c_str());
+        }
+    }
+
+    auto* sample_ep = new SampleEp(factory, logger, options, *kernels);
     *ep = sample_ep->GetOrtEp();
     return nullptr;
 }
@@ -202,8 +275,7 @@ OrtStatus* ORT_API_CALL SampleEpFactory::ValidateCompiledModelCompatibilityInfoI
     (void)this_;
     (void)devices;
     (void)num_devices;
-    (void)compatibility_info;
-    *model_compatibility = OrtCompiledModelCompatibility_EP_NOT_APPLICABLE;
+    *model_compatibility = CheckCompatibilityInfo(compatibility_info);
     return nullptr;
 }
 
@@ -212,30 +284,54 @@ OrtStatus* ORT_API_CALL SampleEpFactory::CreateAllocatorImpl(
     const OrtMemoryInfo* memory_info,
     const OrtKeyValuePairs* allocator_options,
     OrtAllocator** allocator) noexcept {
-    (void)this_;
-    (void)memory_info;
-    (void)allocator_options;
-    *allocator = nullptr;  // Use default CPU allocator
+    auto* factory = FromOrt(this_);
+    PoolAllocatorOptions options;
+    RETURN_IF_ERROR(ParseAllocatorOptions(factory->apis_.ort_api, allocator_options, &options));
+    return factory->CreatePoolAllocator(memory_info, options, allocator);
+}
+
+OrtStatus* SampleEpFactory::CreatePoolAllocator(const OrtMemoryInfo* memory_info,
+                                                const PoolAllocatorOptions& options,
+                                                OrtAllocator** allocator) {
+    const OrtApi* api = apis_.ort_api;
+    *allocator = nullptr;
+
+    // We only register one memory info; anything else gets ORT's default allocator
+    const char* name = nullptr;
+    const char* our_name = nullptr;
+    if (memory_info_ == nullptr || memory_info == nullptr) return nullptr;
+    RETURN_IF_ERROR(api->MemoryInfoGetName(memory_info, &name));
+    RETURN_IF_ERROR(api->MemoryInfoGetName(memory_info_, &our_name));
+    if (std::strcmp(name, our_name) != 0) return nullptr;
+
+    auto pool = std::make_unique<PoolAllocator>(api, memory_info_, options);
+    *allocator = pool.release()->GetOrtAllocator();
     return nullptr;
 }
 
 void ORT_API_CALL SampleEpFactory::ReleaseAllocatorImpl(
     OrtEpFactory* this_, OrtAllocator* allocator) noexcept {
     (void)this_;
-    (void)allocator;
+    if (allocator == nullptr) return;
+    delete PoolAllocator::FromOrt(allocator);
 }
 
 OrtStatus* ORT_API_CALL SampleEpFactory::CreateDataTransferImpl(
     OrtEpFactory* this_,
     OrtDataTransferImpl** data_transfer) noexcept {
-    (void)this_;
-    *data_transfer = nullptr;  // No custom data transfer needed for CPU EP
+    // Moves tensors between ORT's CPU memory and ours; ORT releases it
+    auto* factory = FromOrt(this_);
+    *data_transfer = nullptr;
+    if (factory->memory_info_ == nullptr) return nullptr;
+    auto* transfer = new SampleDataTransfer(factory->apis_.ort_api, factory->apis_.ep_api, factory->memory_info_,
+                                            factory->streams_);
+    *data_transfer = transfer->GetOrtDataTransfer();
     return nullptr;
 }
 
 bool ORT_API_CALL SampleEpFactory::IsStreamAwareImpl(const OrtEpFactory* this_) noexcept {
     (void)this_;
-    return false;
+    return true;
 }
 
 OrtStatus* ORT_API_CALL SampleEpFactory::CreateSyncStreamForDeviceImpl(
@@ -243,10 +339,11 @@ OrtStatus* ORT_API_CALL SampleEpFactory::CreateSyncStreamForDeviceImpl(
     const OrtMemoryDevice* memory_device,
     const OrtKeyValuePairs* stream_options,
     OrtSyncStreamImpl** stream) noexcept {
-    (void)this_;
+    // Streams created without a session, e.g. for copies; no EP waits for them at run end
     (void)memory_device;
     (void)stream_options;
-    *stream = nullptr;
+    auto* factory = FromOrt(this_);
+    *stream = (new CpuStream(factory->apis_.ep_api, factory->streams_))->GetOrtStream();
     return nullptr;
 }
 
@@ -262,8 +359,41 @@ const SampleEp* SampleEp::FromOrt(const OrtEp* ort_ep) {
     return CONTAINER_OF_CONST(ort_ep, SampleEp, ep_);
 }
 
-SampleEp::SampleEp(SampleEpFactory* factory, const OrtLogger* session_logger)
-    : factory_(factory), session_logger_(session_logger) {
+namespace {
+
+// Threads to use for the num_threads option; 0 means one per core, of the NUMA node if pinned
+size_t ResolveNumThreads(const SampleEpOptions& options) {
+    if (options.num_threads != 0) return options.num_threads;
+    if (const NumaNode* node = FindNumaNode(options.numa_node)) return node->cpus.size();
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// CPUs the pool's workers are pinned to; empty = not pinned
+std::vector<int> PoolCpus(const SampleEpOptions& options) {
+    const NumaNode* node = options.numa_node >= 0 ? FindNumaNode(options.numa_node) : nullptr;
+    return node != nullptr ? node->cpus : std::vector<int>();
+}
+
+}  // namespace
+
+SampleEp::SampleEp(SampleEpFactory* factory, const OrtLogger* session_logger,
+                   const SampleEpOptions& options, const KernelTable& kernels)
+    : factory_(factory), session_logger_(session_logger), options_(options), kernels_(&kernels) {
+
+    thread_pool_ = std::make_unique<ThreadPool>(ResolveNumThreads(options_), options_.thread_priority,
+                                                PoolCpus(options_));
+
+    compatibility_info_ = GetCompatibilityInfo(*kernels_);
+
+    if (!options_.program_cache_dir.empty()) {
+        program_cache_ = std::make_unique<ProgramCache>(options_.program_cache_dir);
+    }
+
+    // Profiling can be switched on later, so the profiler always exists
+    profiler_ = std::make_unique<Profiler>(options_.profile_file);
+    profiler_->SetEnabled(options_.enable_profiling);
+
+    streams_ = std::make_shared<StreamSet>(factory_->GetStreams());
 
     // Zero-initialize the OrtEp struct
     std::memset(&ep_, 0, sizeof(ep_));
@@ -294,6 +424,119 @@ const char* ORT_API_CALL SampleEp::GetNameImpl(const OrtEp* this_) noexcept {
     return FromOrt(this_)->factory_->GetEpName().c_str();
 }
 
+namespace {
+
+// Nodes GetCapabilityImpl describes per pool task
+constexpr size_t kNodesPerChunk = 256;
+
+// Call fn(chunk, begin, end) for the chunks of kNodesPerChunk nodes, on the pool, and return
+// the failure of the lowest failing chunk, releasing the others, so the error reported does
+// not depend on scheduling
+template <class F>
+OrtStatus* ForEachNodeChunk(const OrtApi* api, ThreadPool* pool, size_t num_nodes, F fn) {
+    const size_t num_chunks = (num_nodes + kNodesPerChunk - 1) / kNodesPerChunk;
+    std::vector<OrtStatus*> statuses(num_chunks, nullptr);
+    auto run_chunk = [&](size_t chunk) {
+        const size_t begin = chunk * kNodesPerChunk;
+        statuses[chunk] = fn(chunk, begin, std::min(num_nodes, begin + kNodesPerChunk));
+    };
+    if (num_chunks == 1) {
+        run_chunk(0);
+    } else {
+        pool->ParallelFor(num_chunks, run_chunk);
+    }
+
+    OrtStatus* first = nullptr;
+    for (OrtStatus* status : statuses) {
+        if (first == nullptr) {
+            first = status;
+        } else if (status != nullptr) {
+            api->ReleaseStatus(status);
+        }
+    }
+    return first;
+}
+
+// Fill node i's entries of *graph but its shape class: the key of its output shape goes to
+// *shape_key instead, if it may fuse. Its producers are appended to *producers and counted in
+// graph->producer_begin[i + 1]. An EPContext node of ours gets its producers and is flagged,
+// but stays unsupported, so nodes on either side of it are never fused into a cycle.
+OrtStatus* DescribeNode(const OrtApi* api, const OrtNode* node, size_t i, const std::string& ep_name,
+                        const std::unordered_map<size_t, size_t>& index_of_id, PartitionGraph* graph,
+                        std::vector<size_t>* producers, std::string* shape_key, uint8_t* is_ep_context) {
+    size_t num_inputs = 0;
+    size_t num_outputs = 0;
+    RETURN_IF_ERROR(api->Node_GetNumInputs(node, &num_inputs));
+    RETURN_IF_ERROR(api->Node_GetNumOutputs(node, &num_outputs));
+    std::vector<const OrtValueInfo*> inputs(num_inputs);
+    std::vector<const OrtValueInfo*> outputs(num_outputs);
+    RETURN_IF_ERROR(api->Node_GetInputs(node, inputs.data(), num_inputs));
+    RETURN_IF_ERROR(api->Node_GetOutputs(node, outputs.data(), num_outputs));
+
+    int64_t first_producer = -1;  // Of input 0, a row op's operand
+    for (size_t k = 0; k < num_inputs; ++k) {
+        if (inputs[k] == nullptr) continue;  // Missing optional input
+        const OrtNode* producer = nullptr;
+        size_t producer_output = 0;
+        RETURN_IF_ERROR(api->ValueInfo_GetValueProducer(inputs[k], &producer, &producer_output));
+        if (producer == nullptr) continue;  // Graph input or initializer
+
+        size_t producer_id = 0;
+        RETURN_IF_ERROR(api->Node_GetId(producer, &producer_id));
+        auto it = index_of_id.find(producer_id);
+        if (it != index_of_id.end()) {
+            producers->push_back(it->second);
+            graph->producer_begin[i + 1]++;
+            if (k == 0) first_producer = static_cast<int64_t>(it->second);
+        }
+    }
+
+    // An EPContext node is a partition already; its edges still order the nodes around it
+    bool ep_context = false;
+    RETURN_IF_ERROR(IsOwnEpContextNode(api, node, ep_name, &ep_context));
+    if (ep_context) {
+        *is_ep_context = 1;
+        return nullptr;
+    }
+
+    // Support elementwise ops with kernels for their operand types. Edges between supported
+    // nodes may change type (Cast, comparisons); every register of a program carries its own.
+    NodeLowering lowering;
+    bool supported = false;
+    RETURN_IF_ERROR(LowerNode(api, node, &lowering, &supported));
+    if (!supported) return nullptr;
+
+    ONNXTensorElementDataType elem_type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+    std::string key;
+    RETURN_IF_ERROR(GetValueTensorInfo(api, outputs[0], &elem_type, &key));
+
+    graph->supported[i] = 1;
+    graph->row_op[i] = lowering.has_row_op;
+    if (lowering.has_row_op) graph->operand_producer[i] = first_producer;
+    if (lowering.descriptor->fusable) *shape_key = std::move(key);
+
+    // Traffic and work for the cost model. An unknown input size leaves elements at 0.
+    size_t elements = 0;
+    size_t bytes = 0;
+    bool known = true;
+    for (const OrtValueInfo* input : inputs) {
+        if (input == nullptr) continue;
+        RETURN_IF_ERROR(GetStaticTensorSize(api, input, &elements, &bytes));
+        known = known && elements > 0;
+        graph->input_bytes[i] += bytes;
+    }
+    RETURN_IF_ERROR(GetStaticTensorSize(api, outputs[0], &elements, &bytes));
+    bool graph_output = false;
+    RETURN_IF_ERROR(api->ValueInfo_IsGraphOutput(outputs[0], &graph_output));
+    graph->graph_output[i] = graph_output;
+    graph->elements[i] = known ? elements : 0;
+    graph->output_bytes[i] = bytes;
+    graph->cost[i] = lowering.descriptor->cost;
+    return nullptr;
+}
+
+}  // namespace
+
 OrtStatus* ORT_API_CALL SampleEp::GetCapabilityImpl(
     OrtEp* this_,
     const OrtGraph* graph,
@@ -320,34 +563,102 @@ OrtStatus* ORT_API_CALL SampleEp::GetCapabilityImpl(
         return status;
     }
 
-    // Check each node and claim supported operators
+    // Graph reads through the C API do not modify the graph, so the nodes are described in
+    // parallel, a chunk of them per pool task. Every step that assigns numbers (shape
+    // classes, edge offsets) then runs in node order, so the result does not depend on the
+    // number of threads.
+    const std::string& ep_name = ep->factory_->GetEpName();
+    ThreadPool* pool = ep->thread_pool_.get();
+
+    std::vector<size_t> node_ids(num_nodes);
+    RETURN_IF_ERROR(ForEachNodeChunk(apis.ort_api, pool, num_nodes,
+                                     [&](size_t chunk, size_t begin, size_t end) -> OrtStatus* {
+        (void)chunk;
+        for (size_t i = begin; i < end; ++i) RETURN_IF_ERROR(apis.ort_api->Node_GetId(all_nodes[i], &node_ids[i]));
+        return nullptr;
+    }));
+    std::unordered_map<size_t, size_t> index_of_id;  // Node id -> position in all_nodes
+    index_of_id.reserve(num_nodes);
+    for (size_t i = 0; i < num_nodes; ++i) index_of_id[node_ids[i]] = i;
+
+    // Describe each node to the partitioner: whether we support it, which shape class it
+    // belongs to, and which in-graph nodes produce its inputs
+    PartitionGraph partition_graph(num_nodes);
+    const size_t num_chunks = (num_nodes + kNodesPerChunk - 1) / kNodesPerChunk;
+    std::vector<std::vector<size_t>> chunk_producers(num_chunks);
+    std::vector<std::string> shape_keys(num_nodes);
+    std::vector<uint8_t> is_ep_context(num_nodes, 0);  // Partitions compiled by an earlier session
+    RETURN_IF_ERROR(ForEachNodeChunk(apis.ort_api, pool, num_nodes,
+                                     [&](size_t chunk, size_t begin, size_t end) -> OrtStatus* {
+        for (size_t i = begin; i < end; ++i) {
+            RETURN_IF_ERROR(DescribeNode(apis.ort_api, all_nodes[i], i, ep_name, index_of_id, &partition_graph,
+                                         &chunk_producers[chunk], &shape_keys[i], &is_ep_context[i]));
+        }
+        return nullptr;
+    }));
+
+    std::unordered_map<std::string, int64_t> shape_classes;
     for (size_t i = 0; i < num_nodes; ++i) {
-        const OrtNode* node = all_nodes[i];
-        if (!node) continue;
+        if (shape_keys[i].empty()) continue;
+        auto it = shape_classes.emplace(std::move(shape_keys[i]), static_cast<int64_t>(shape_classes.size())).first;
+        partition_graph.shape_class[i] = it->second;
+    }
+    std::vector<size_t>& producer_begin = partition_graph.producer_begin;
+    std::partial_sum(producer_begin.begin(), producer_begin.end(), producer_begin.begin());
+    partition_graph.producers.reserve(producer_begin.back());
+    for (const std::vector<size_t>& producers : chunk_producers) {
+        partition_graph.producers.insert(partition_graph.producers.end(), producers.begin(), producers.end());
+    }
 
-        const char* op_type = nullptr;
-        status = apis.ort_api->Node_GetOperatorType(node, &op_type);
-        if (status != nullptr) {
-            return status;
+    // Each EPContext node is already a compiled partition
+    for (size_t i = 0; i < num_nodes; ++i) {
+        if (!is_ep_context[i]) continue;
+        RETURN_IF_ERROR(apis.ep_api->EpGraphSupportInfo_AddNodesToFuse(graph_support_info, &all_nodes[i], 1, nullptr));
+    }
+
+    // Claim each partition as one fused node, unless the cost model expects ORT's CPU EP to
+    // run it faster (tiny, isolated nodes mostly)
+    const SampleEpOptions& options = ep->options_;
+    std::vector<std::vector<size_t>> partitions =
+        BuildPartitions(partition_graph, options.max_partition_nodes, pool);
+    std::vector<PartitionEstimate> estimates = EstimatePartitions(partition_graph, partitions, options.cost_model);
+    for (size_t p = 0; p < partitions.size(); ++p) {
+        const std::vector<size_t>& partition = partitions[p];
+        const PartitionEstimate& estimate = estimates[p];
+        std::vector<const OrtNode*> fused(partition.size());
+        std::string op_list;
+        for (size_t k = 0; k < partition.size(); ++k) {
+            fused[k] = all_nodes[partition[k]];
+            const char* op_type = nullptr;
+            RETURN_IF_ERROR(apis.ort_api->Node_GetOperatorType(fused[k], &op_type));
+            op_list += (k == 0 ? "" : " -> ");
+            op_list += op_type;
         }
 
-        // Support Add and Mul operators as an example
-        if (op_type && (std::strcmp(op_type, "Add") == 0 ||
-                       std::strcmp(op_type, "Mul") == 0)) {
-            printf("  [SampleEP] Claiming op: %s\n", op_type);
-            fflush(stdout);
+        const bool claim = !options.partition_by_cost || estimate.Profitable();
+        if (claim) {
+            printf("  [SampleEP] Claiming partition of %zu node(s): %s\n", fused.size(), op_list.c_str());
+        } else if (options.partition_log) {
+            printf("  [SampleEP] Leaving partition of %zu node(s) to ORT: %s\n", fused.size(), op_list.c_str());
+        }
+        if (options.partition_log && estimate.known) {
+            printf("  [SampleEP]   %zu boundary bytes: %.2f us here vs %.2f us on the CPU EP%s\n",
+                   estimate.boundary_bytes, estimate.ep_ns * 1e-3, estimate.cpu_ns * 1e-3,
+                   options.partition_by_cost ? "" : " (partition_policy=all)");
+        } else if (options.partition_log) {
+            printf("  [SampleEP]   dynamic shapes, claimed without an estimate\n");
+        }
+        fflush(stdout);
+        if (!claim) continue;
 
-            // Add each supported node as its own fused group
-            const OrtNode* single_node = node;
-            status = apis.ep_api->EpGraphSupportInfo_AddNodesToFuse(
-                graph_support_info,
-                &single_node,
-                1,
-                nullptr);
+        status = apis.ep_api->EpGraphSupportInfo_AddNodesToFuse(
+            graph_support_info,
+            fused.data(),
+            fused.size(),
+            nullptr);
 
-            if (status != nullptr) {
-                return status;
-            }
+        if (status != nullptr) {
+            return status;
         }
     }
 
@@ -362,21 +673,99 @@ OrtStatus* ORT_API_CALL SampleEp::CompileImpl(
     OrtNodeComputeInfo** node_compute_infos,
     OrtNode** ep_context_nodes) noexcept {
 
-    (void)graphs;
-    (void)fused_nodes;
-
     auto* ep = FromOrt(this_);
     const auto& apis = ep->GetApis();
 
     // Create a compute info for each fused graph
     for (size_t i = 0; i < count; ++i) {
-        auto* compute_info = new SampleNodeComputeInfo(apis);
-        node_compute_infos[i] = compute_info->GetOrtComputeInfo();
+        auto compute_info = std::make_unique<SampleNodeComputeInfo>(apis, ep->GetKernels());
+
+        // EPContext nodes carry the program. Otherwise try the on-disk cache, and compile
+        // the subgraph only if it has not been seen on this host before.
+        bool loaded = false;
+        RETURN_IF_ERROR(LoadEpContextProgram(apis, graphs[i], fused_nodes[i], &compute_info->program, &loaded));
+
+        ProgramCache* cache = loaded ? nullptr : ep->program_cache_.get();
+        uint64_t cache_key = 0;
+        if (cache != nullptr) {
+            RETURN_IF_ERROR(HashFusedGraph(apis.ort_api, graphs[i], fused_nodes[i],
+                                           ep->GetKernels(), &cache_key));
+            loaded = cache->Find(cache_key, &compute_info->program);
+        }
 
-        // Set ep_context_nodes to nullptr since we don't support EPContext models
+        if (!loaded) {
+            RETURN_IF_ERROR(CompileFusedGraph(apis, graphs[i], fused_nodes[i], &compute_info->program));
+            if (cache != nullptr) cache->Add(cache_key, compute_info->program);
+        }
+
+        // A MatMul's weight is an initializer the subgraph reads; keep a copy to pack
+        const ExprProgram& compiled = compute_info->program;
+        const size_t row_instr = FindRowInstr(compiled);
+        if (row_instr < compiled.code.size() && compiled.code[row_instr].op == OpCode::MatMul) {
+            std::vector<const OrtValueInfo*> inputs;
+            RETURN_IF_ERROR(GetNodeInputs(apis.ort_api, fused_nodes[i], &inputs));
+            const char* name = nullptr;
+            RETURN_IF_ERROR(apis.ort_api->GetValueInfoName(inputs[compiled.code[row_instr].src[1]], &name));
+            const OrtValueInfo* initializer = nullptr;
+            RETURN_IF_ERROR(FindGraphInitializer(apis.ort_api, graphs[i], name, &initializer));
+            bool found = false;
+            if (initializer != nullptr) {
+                RETURN_IF_ERROR(GetInitializerFloats(apis.ort_api, initializer, &compute_info->weight,
+                                                     &compute_info->weight_dims, &found));
+            }
+            if (!found || compute_info->weight_dims.size() != 2) {
+                return apis.ort_api->CreateStatus(ORT_EP_FAIL, "MatMul weight is not a constant initializer");
+            }
+        }
+        compute_info->thread_pool = ep->GetThreadPool();
+        compute_info->parallel_threshold = ep->options_.parallel_threshold;
+        compute_info->specialize_after = ep->options_.specialize_after;
+        compute_info->batch_window = std::chrono::microseconds(ep->options_.batch_window_us);
+        compute_info->deterministic_reductions = ep->options_.deterministic_reductions;
+        if (const OrtMemoryInfo* memory_info = ep->factory_->GetMemoryInfo()) {
+            const char* memory_name = nullptr;
+            RETURN_IF_ERROR(apis.ort_api->MemoryInfoGetName(memory_info, &memory_name));
+            compute_info->stream_execution = ep->options_.stream_execution;
+            compute_info->pool_memory_name = memory_name;
+        }
+
+        // Registered even while profiling is off, in case it is switched on later
+        if (Profiler* profiler = ep->profiler_.get()) {
+            const char* node_name = nullptr;
+            RETURN_IF_ERROR(apis.ort_api->Node_GetName(fused_nodes[i], &node_name));
+            const KernelTable& kernels = ep->GetKernels();
+            const ExprProgram& program = compute_info->program;
+            compute_info->profiler = profiler;
+            compute_info->profile_id = profiler->RegisterNode(
+                node_name ? node_name : "",
+                std::string(kernels.name) + "/" + DataTypeName(program.types[program.outputs[0]]));
+        }
+
+        // When ORT is compiling the model, save the program so later sessions skip this step
         if (ep_context_nodes) {
             ep_context_nodes[i] = nullptr;
+            if (ep->options_.ep_context_enable) {
+                RETURN_IF_ERROR(CreateEpContextNode(
+                    apis, fused_nodes[i], ep->factory_->GetEpName(),
+                    SerializeProgram(compute_info->program, ep->GetKernels()), &ep_context_nodes[i]));
+            }
         }
+
+        // Folded after the program is stored, since the constants come from the model
+        if (ep->options_.fold_constants) {
+            std::vector<std::unique_ptr<ConstantTensor>> values;
+            std::vector<std::vector<int64_t>> dims;
+            RETURN_IF_ERROR(ReadConstantInputs(apis.ort_api, graphs[i], fused_nodes[i], compute_info->program,
+                                               &values, &dims));
+            FoldConstants(&compute_info->program, values, dims, ep->GetKernels(), &compute_info->constants);
+        }
+
+        node_compute_infos[i] = compute_info.release()->GetOrtComputeInfo();
+    }
+
+    // A cache that cannot be written only costs the next process a compile
+    if (ep->program_cache_ != nullptr) {
+        ep->program_cache_->Commit();
     }
 
     return nullptr;  // Success
@@ -397,8 +786,7 @@ void ORT_API_CALL SampleEp::ReleaseNodeComputeInfosImpl(
 
 OrtStatus* ORT_API_CALL SampleEp::GetPreferredDataLayoutImpl(
     OrtEp* this_, OrtEpDataLayout* preferred_data_layout) noexcept {
-    (void)this_;
-    *preferred_data_layout = OrtEpDataLayout::OrtEpDataLayout_NCHW;
+    *preferred_data_layout = FromOrt(this_)->options_.preferred_layout;
     return nullptr;
 }
 
@@ -406,61 +794,89 @@ OrtStatus* ORT_API_CALL SampleEp::ShouldConvertDataLayoutForOpImpl(
     OrtEp* this_, const char* domain, const char* op_type,
     OrtEpDataLayout target_data_layout, int* should_convert) noexcept {
     (void)this_;
-    (void)domain;
-    (void)op_type;
     (void)target_data_layout;
-    *should_convert = -1;  // Let ORT decide
+
+    // Our ops are elementwise or work over the axes they name, so they run on any layout and
+    // never need converting; ORT's transpose optimizer pushes the transposes it inserts
+    // through them to the partition boundary. Everything else gets ORT's default handling.
+    *should_convert = FindOp(domain, op_type) != nullptr ? 0 : -1;
     return nullptr;
 }
 
 OrtStatus* ORT_API_CALL SampleEp::SetDynamicOptionsImpl(
     OrtEp* this_, const char* const* option_keys,
     const char* const* option_values, size_t num_options) noexcept {
-    (void)this_;
-    (void)option_keys;
-    (void)option_values;
-    (void)num_options;
+    auto* ep = FromOrt(this_);
+    SampleEpOptions updated = ep->options_;
+    RETURN_IF_ERROR(ParseDynamicEpOptions(ep->GetApis().ort_api, option_keys, option_values,
+                                          num_options, &updated));
+
+    // Only the dynamic fields can differ. Compute calls keep running throughout: the pool
+    // restarts its workers between loops and the profiler flag is read once per call.
+    if (updated.num_threads != ep->options_.num_threads ||
+        updated.thread_priority != ep->options_.thread_priority) {
+        ep->thread_pool_->Reconfigure(ResolveNumThreads(updated), updated.thread_priority);
+        ep->options_.num_threads = updated.num_threads;
+        ep->options_.thread_priority = updated.thread_priority;
+    }
+    if (updated.enable_profiling != ep->options_.enable_profiling) {
+        ep->profiler_->SetEnabled(updated.enable_profiling);
+        ep->options_.enable_profiling = updated.enable_profiling;
+    }
     return nullptr;
 }
 
 OrtStatus* ORT_API_CALL SampleEp::OnRunStartImpl(
     OrtEp* this_, const OrtRunOptions* run_options) noexcept {
-    (void)this_;
     (void)run_options;
+    if (Profiler* profiler = FromOrt(this_)->GetProfiler()) {
+        profiler->RecordRunStart();
+    }
     return nullptr;
 }
 
 OrtStatus* ORT_API_CALL SampleEp::OnRunEndImpl(
     OrtEp* this_, const OrtRunOptions* run_options, bool sync_stream) noexcept {
-    (void)this_;
     (void)run_options;
-    (void)sync_stream;
+
+    // Join the work this run queued. Without sync_stream some of it may still be running,
+    // and its samples land in the next run's profile.
+    auto* ep = FromOrt(this_);
+    if (sync_stream) ep->streams_->DrainAll();
+
+    Profiler* profiler = ep->GetProfiler();
+    if (profiler == nullptr) return nullptr;
+
+    profiler->RecordRunEnd();
+    if (!profiler->Flush()) {
+        std::string msg = "Cannot write SampleEP profile to '" + profiler->Path() + "'";
+        return ep->GetApis().ort_api->CreateStatus(ORT_FAIL, msg.c_str());
+    }
     return nullptr;
 }
 
 OrtStatus* ORT_API_CALL SampleEp::EpCreateAllocatorImpl(
     OrtEp* this_, const OrtMemoryInfo* memory_info,
     OrtAllocator** allocator) noexcept {
-    (void)this_;
-    (void)memory_info;
-    *allocator = nullptr;  // Use default
-    return nullptr;
+    // Same pools as the factory creates, configured by the allocator option; ORT releases
+    // them through the factory's ReleaseAllocatorImpl
+    auto* ep = FromOrt(this_);
+    return ep->factory_->CreatePoolAllocator(memory_info, ep->options_.allocator, allocator);
 }
 
 OrtStatus* ORT_API_CALL SampleEp::EpCreateSyncStreamForDeviceImpl(
     OrtEp* this_, const OrtMemoryDevice* memory_device,
     OrtSyncStreamImpl** stream) noexcept {
-    (void)this_;
     (void)memory_device;
-    *stream = nullptr;
+    auto* ep = FromOrt(this_);
+    *stream = (new CpuStream(ep->GetApis().ep_api, ep->streams_))->GetOrtStream();
     return nullptr;
 }
 
 const char* ORT_API_CALL SampleEp::GetCompiledModelCompatibilityInfoImpl(
     OrtEp* this_, const OrtGraph* graph) noexcept {
-    (void)this_;
     (void)graph;
-    return nullptr;
+    return FromOrt(this_)->compatibility_info_.c_str();
 }
 
 // ============================================================================
@@ -471,8 +887,8 @@ SampleNodeComputeInfo* SampleNodeComputeInfo::FromOrt(OrtNodeComputeInfo* ort_in
     return CONTAINER_OF(ort_info, SampleNodeComputeInfo, compute_info_);
 }
 
-SampleNodeComputeInfo::SampleNodeComputeInfo(const ApiPtrs& apis)
-    : ort_api(apis.ort_api), ep_api(apis.ep_api) {
+SampleNodeComputeInfo::SampleNodeComputeInfo(const ApiPtrs& apis, const KernelTable& kernels)
+    : ort_api(apis.ort_api), ep_api(apis.ep_api), kernels(kernels) {
 
     // Zero-initialize the OrtNodeComputeInfo struct
     std::memset(&compute_info_, 0, sizeof(compute_info_));
@@ -484,21 +900,215 @@ SampleNodeComputeInfo::SampleNodeComputeInfo(const ApiPtrs& apis)
     compute_info_.ReleaseState = ReleaseStateImpl;
 }
 
-// Simple compute state - just stores a flag
+std::shared_ptr<const PackedWeight> SampleNodeComputeInfo::GetPackedWeight(OrtStatus** status) {
+    *status = nullptr;
+    std::call_once(pack_once_, [this] {
+        if (weight_dims.size() != 2) return;
+        const bool transposed = program.row.transposed;
+        const auto k = static_cast<size_t>(weight_dims[transposed ? 1 : 0]);
+        const auto n = static_cast<size_t>(weight_dims[transposed ? 0 : 1]);
+        auto packed = std::make_shared<PackedWeight>();
+        packed->Pack(kernels.gemm, weight.data(), k, n, transposed);
+        packed_weight_ = std::move(packed);
+        weight = std::vector<float>();
+    });
+    if (packed_weight_ == nullptr) *status = ort_api->CreateStatus(ORT_EP_FAIL, "MatMul weight is missing");
+    return packed_weight_;
+}
+
+// Per-node state: execution plans for the input shapes seen so far, the packed weight of a
+// MatMul partition and the batcher coalescing small calls. ORT creates one per session and
+// shares it between concurrent Run calls, which only ever read published plans.
 struct ComputeState {
-    bool initialized = true;
+    PlanCache plans;
+    std::shared_ptr<const PackedWeight> weight;
+    CallBatcher batcher;
+};
+
+namespace {
+
+// Per-thread buffers for one Compute call, reused so the hot path does not allocate. Each
+// caller thread has its own, as do the pool workers' register files (see ExecuteProgram).
+struct CallScratch {
+    std::vector<ShapeRef> shapes;
+    std::vector<const OrtValue*> inputs;
+    std::vector<OrtValue*> outputs;
+    std::vector<const void*> input_data;
+    std::vector<void*> output_data;
+    std::vector<char> replicated;
 };
 
+// A call queued on a stream: its own copy of the buffers it touches, whose pool blocks stay
+// retained until it has run
+struct QueuedCall {
+    std::vector<const void*> input_data;
+    std::vector<void*> output_data;
+    std::vector<char> replicated;
+    std::vector<void*> retained;
+    std::unique_ptr<ExecutionPlan> uncached;
+
+    ~QueuedCall() {
+        for (void* p : retained) PoolAllocator::Unretain(p);
+    }
+};
+
+// Retain the pool block behind every input and output of the call. False, with nothing
+// retained, if any of them lives elsewhere: ORT may reuse such memory as soon as Compute
+// returns, so the call cannot be queued.
+bool RetainBuffers(const SampleNodeComputeInfo& info, const CallScratch& scratch, QueuedCall* call) {
+    auto retain = [&](const OrtValue* value, const void* data) {
+        if (data == nullptr) return true;  // Empty tensor
+        const OrtMemoryInfo* memory_info = nullptr;
+        const char* name = nullptr;
+        OrtStatus* status = info.ort_api->GetTensorMemoryInfo(value, &memory_info);
+        if (status == nullptr) status = info.ort_api->MemoryInfoGetName(memory_info, &name);
+        if (status != nullptr) {
+            info.ort_api->ReleaseStatus(status);
+            return false;
+        }
+        if (name == nullptr || info.pool_memory_name != name) return false;
+        if (!PoolAllocator::Retain(const_cast<void*>(data))) return false;
+        call->retained.push_back(const_cast<void*>(data));
+        return true;
+    };
+
+    bool ok = true;
+    for (size_t k = 0; k < scratch.inputs.size() && ok; ++k) ok = retain(scratch.inputs[k], scratch.input_data[k]);
+    for (size_t k = 0; k < scratch.outputs.size() && ok; ++k) ok = retain(scratch.outputs[k], scratch.output_data[k]);
+    if (!ok) {
+        for (void* p : call->retained) PoolAllocator::Unretain(p);
+        call->retained.clear();
+    }
+    return ok;
+}
+
+// Tile row-vector inputs across the widened rows, then run the whole partition in one tiled
+// pass over memory. Replicated inputs are redirected in `input_data` to `replicated`.
+void RunPlan(const SampleNodeComputeInfo& info, const ComputeState& state, const ExecutionPlan& plan,
+             const void** input_data, void* const* output_data, std::vector<char>* replicated) {
+    const ExprProgram& program = info.program;
+    const BroadcastPlan& bcast = plan.broadcast;
+
+    if (plan.row) {
+        RunRowPlan(plan, info.kernels, info.thread_pool, info.deterministic_reductions, state.weight.get(),
+                   input_data, output_data, replicated);
+        return;
+    }
+
+    if (plan.replicated_bytes > 0) {
+        replicated->resize(plan.replicated_bytes);
+        ReplicateInputs(program, plan, input_data, replicated->data());
+    }
+
+    // In a real EP, this would dispatch to hardware
+    const size_t total_elements = bcast.total;
+    if (plan.num_chunks == 1) {
+        ExecuteProgram(program, plan, input_data, output_data, 0, total_elements);
+    } else {
+        auto run_chunk = [&](size_t chunk) {
+            const size_t begin = chunk * plan.chunk_elements;
+            const size_t end = std::min(total_elements, begin + plan.chunk_elements);
+            ExecuteProgram(program, plan, input_data, output_data, begin, end);
+        };
+        info.thread_pool->ParallelFor(plan.num_chunks, run_chunk);
+    }
+}
+
+// Run one call: as part of a micro-batch when batching is on and the call is small enough,
+// otherwise on its own
+void RunPartition(const SampleNodeComputeInfo& info, ComputeState& state, const ExecutionPlan& plan,
+                  const void** input_data, void* const* output_data, std::vector<char>* replicated) {
+    if (info.batch_window.count() > 0) {
+        struct Context {
+            const SampleNodeComputeInfo& info;
+            const ComputeState& state;
+            std::vector<char>* replicated;
+        } context{info, state, replicated};
+        auto run = [](void* ctx, const ExecutionPlan& batch_plan, const void** inputs, void* const* outputs) {
+            auto* c = static_cast<Context*>(ctx);
+            RunPlan(c->info, c->state, batch_plan, inputs, outputs, c->replicated);
+        };
+
+        BatchTarget target;
+        target.program = &info.program;
+        target.num_call_inputs = info.program.num_inputs - info.constants.size();
+        target.kernels = &info.kernels;
+        target.options.parallel_threshold = info.parallel_threshold;
+        target.plans = &state.plans;
+        if (state.batcher.Run(target, info.batch_window, plan, input_data, output_data, run, &context)) return;
+    }
+    RunPlan(info, state, plan, input_data, output_data, replicated);
+}
+
+// Count the elements each instruction of a row plan ran over: the prologue's and the row
+// op's over the operand, a MatMul's once per multiply-add, and the epilogue's over the result
+void CountRowOpElements(const RowPlan& row) {
+    const uint64_t operand = static_cast<uint64_t>(row.outer) * row.operand_slab;
+    for (const Instr& instr : row.prologue.code) CountAdd(OpElementsCounter(instr.op), operand);
+    CountAdd(OpElementsCounter(row.op), row.op == OpCode::MatMul ? operand * row.columns : operand);
+
+    const uint64_t result = static_cast<uint64_t>(row.outer) * row.result_slab;
+    for (const Instr& instr : row.epilogue.code) CountAdd(OpElementsCounter(instr.op), result);
+}
+
+// Count one call in the always-on counters
+void CountCall(const ExprProgram& program, const ExecutionPlan& plan, bool plan_built, bool cached) {
+    // Every output of a row plan has the row op's result shape
+    const uint64_t elements =
+        plan.row ? static_cast<uint64_t>(plan.row->outer) * plan.row->result_slab : plan.broadcast.total;
+    CountAdd(Counter::ComputeCalls, 1);
+    CountAdd(Counter::OutputElements, elements);
+    CountAdd(plan_built ? Counter::PlanCacheMisses : Counter::PlanCacheHits, 1);
+    if (!cached) CountAdd(Counter::PlanCacheOverflows, 1);
+
+    Counter path = Counter::GenericCalls;
+    if (plan.row) {
+        path = Counter::RowOpCalls;
+    } else if (plan.hot.load(std::memory_order_acquire) != nullptr) {
+        path = Counter::HotPathCalls;
+    }
+    CountAdd(path, 1);
+    if (plan.row) {
+        CountRowOpElements(*plan.row);
+    } else {
+        for (const Instr& instr : program.code) CountAdd(OpElementsCounter(instr.op), elements);
+    }
+}
+
+// Bytes read from the partition inputs and written to its outputs by one call
+uint64_t BytesMoved(const CallScratch& scratch, const ExprProgram& program, size_t total_elements) {
+    uint64_t bytes = 0;
+    for (uint32_t out_reg : program.outputs) {
+        bytes += static_cast<uint64_t>(total_elements) * DataTypeSize(program.types[out_reg]);
+    }
+    for (size_t k = 0; k < scratch.shapes.size(); ++k) {
+        const ShapeRef& shape = scratch.shapes[k];
+        uint64_t n = 1;
+        for (size_t d = 0; d < shape.rank; ++d) n *= static_cast<uint64_t>(shape.dims[d]);
+        bytes += n * DataTypeSize(program.types[k]);
+    }
+    return bytes;
+}
+
+}  // namespace
+
 OrtStatus* ORT_API_CALL SampleNodeComputeInfo::CreateStateImpl(
     OrtNodeComputeInfo* this_,
     OrtNodeComputeContext* compute_context,
     void** compute_state) noexcept {
 
-    (void)this_;
     (void)compute_context;
 
-    // Create compute state
-    *compute_state = new ComputeState();
+    // Create compute state. MatMul partitions pack their weight here, once per node.
+    auto* info = FromOrt(this_);
+    auto state = std::make_unique<ComputeState>();
+    const size_t row_instr = FindRowInstr(info->program);
+    if (row_instr < info->program.code.size() && info->program.code[row_instr].op == OpCode::MatMul) {
+        OrtStatus* status = nullptr;
+        state->weight = info->GetPackedWeight(&status);
+        if (status != nullptr) return status;
+    }
+    *compute_state = state.release();
     return nullptr;
 }
 
@@ -508,69 +1118,153 @@ OrtStatus* ORT_API_CALL SampleNodeComputeInfo::ComputeImpl(
     OrtKernelContext* kernel_context) noexcept {
 
     auto* info = FromOrt(this_);
-    (void)compute_state;
+    auto* state = static_cast<ComputeState*>(compute_state);
+    const ExprProgram& program = info->program;
+    Profiler* profiler = info->profiler != nullptr && info->profiler->Enabled() ? info->profiler : nullptr;
+    const uint64_t start_ticks = profiler ? Profiler::Now() : 0;
 
-    // Get input tensors
-    const OrtValue* input_0 = nullptr;
-    const OrtValue* input_1 = nullptr;
-    OrtStatus* status = info->ort_api->KernelContext_GetInput(kernel_context, 0, &input_0);
-    if (status != nullptr) return status;
-    status = info->ort_api->KernelContext_GetInput(kernel_context, 1, &input_1);
-    if (status != nullptr) return status;
-
-    if (!input_0 || !input_1) {
+    if (program.num_inputs == 0) {
         return info->ort_api->CreateStatus(ORT_INVALID_ARGUMENT, "Missing inputs");
     }
 
-    // Get tensor info
-    OrtTensorTypeAndShapeInfo* input_info = nullptr;
-    status = info->ort_api->GetTensorTypeAndShape(input_0, &input_info);
-    if (status != nullptr) return status;
+    const size_t num_node_inputs = program.num_inputs - info->constants.size();
+    static thread_local CallScratch scratch;
+    scratch.shapes.resize(program.num_inputs);
+    scratch.inputs.resize(num_node_inputs);
+    scratch.outputs.resize(program.outputs.size());
+    scratch.input_data.resize(program.num_inputs);
+    scratch.output_data.resize(program.outputs.size());
+
+    // ORT passes our CpuStream when it runs the EP's nodes on streams
+    CpuStream* stream = nullptr;
+    if (info->stream_execution) {
+        void* handle = nullptr;
+        OrtStatus* status = info->ort_api->KernelContext_GetGPUComputeStream(kernel_context, &handle);
+        if (status != nullptr) return status;
+        stream = CpuStream::FromHandle(handle);
+    }
 
-    size_t num_dims = 0;
-    status = info->ort_api->GetDimensionsCount(input_info, &num_dims);
-    if (status != nullptr) {
-        info->ort_api->ReleaseTensorTypeAndShapeInfo(input_info);
-        return status;
+    // Get input shapes and data pointers. The shape is read by reference, so no
+    // OrtTensorTypeAndShapeInfo is created per call.
+    for (size_t k = 0; k < num_node_inputs; ++k) {
+        const OrtValue* input = nullptr;
+        OrtStatus* status = info->ort_api->KernelContext_GetInput(kernel_context, k, &input);
+        if (status != nullptr) return status;
+
+        if (!input) {
+            return info->ort_api->CreateStatus(ORT_INVALID_ARGUMENT, "Missing inputs");
+        }
+        scratch.inputs[k] = input;
+
+        ONNXTensorElementDataType elem_type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+        status = info->ort_api->GetTensorElementTypeAndShapeDataReference(
+            input, &elem_type, &scratch.shapes[k].dims, &scratch.shapes[k].rank);
+        if (status != nullptr) return status;
+
+        DataType type;
+        if (!LookupDataType(elem_type, &type) || type != program.types[k]) {
+            return info->ort_api->CreateStatus(ORT_INVALID_ARGUMENT, "Unexpected input element type");
+        }
+
+        status = info->ort_api->GetTensorData(input, &scratch.input_data[k]);
+        if (status != nullptr) return status;
     }
 
-    std::vector<int64_t> dims(num_dims);
-    status = info->ort_api->GetDimensions(input_info, dims.data(), num_dims);
-    if (status != nullptr) {
-        info->ort_api->ReleaseTensorTypeAndShapeInfo(input_info);
-        return status;
+    // Folded constants follow the node's inputs
+    for (size_t c = 0; c < info->constants.size(); ++c) {
+        const ConstantTensor& constant = info->constants[c];
+        scratch.shapes[num_node_inputs + c] = ShapeRef{constant.dims.data(), constant.dims.size()};
+        scratch.input_data[num_node_inputs + c] = constant.data();
     }
 
-    size_t total_elements = 1;
-    for (auto d : dims) total_elements *= static_cast<size_t>(d);
+    // Look up the plan for these shapes, building it on first sight
+    const ExecutionPlan* plan = state->plans.Find(scratch.shapes.data(), program.num_inputs);
+    std::unique_ptr<ExecutionPlan> uncached;
+    const bool plan_built = plan == nullptr;
+    if (plan == nullptr) {
+        PlanOptions plan_options;
+        plan_options.parallel_threshold = info->parallel_threshold;
+
+        auto built = std::make_unique<ExecutionPlan>();
+        switch (BuildExecutionPlan(program, info->kernels, scratch.shapes.data(), plan_options,
+                                   built.get())) {
+            case PlanStatus::Ok:
+                break;
+            case PlanStatus::IncompatibleShapes:
+                return info->ort_api->CreateStatus(ORT_INVALID_ARGUMENT, "Input shapes cannot be broadcast");
+            case PlanStatus::UnsupportedShapes:
+                return info->ort_api->CreateStatus(ORT_NOT_IMPLEMENTED,
+                                                   "Partition outputs must share the broadcast shape");
+        }
 
-    info->ort_api->ReleaseTensorTypeAndShapeInfo(input_info);
+        // Plans are built from the weight input's shape, which must be the one packed
+        if (const RowPlan* row = built->row.get()) {
+            if (row->op == OpCode::MatMul &&
+                (state->weight == nullptr || state->weight->k != row->n || state->weight->n != row->columns)) {
+                return info->ort_api->CreateStatus(ORT_INVALID_ARGUMENT, "MatMul weight shape changed");
+            }
+        }
 
-    // Create output tensor
-    OrtValue* output = nullptr;
-    status = info->ort_api->KernelContext_GetOutput(kernel_context, 0, dims.data(), num_dims, &output);
-    if (status != nullptr) return status;
+        plan = state->plans.Insert(built);
+        if (plan == nullptr) {
+            // Cache is full; use the plan for this call only
+            uncached = std::move(built);
+            plan = uncached.get();
+        }
+    }
+    if (uncached == nullptr) RecordPlanCall(program, info->kernels, info->specialize_after, *plan);
+    CountCall(program, *plan, plan_built, uncached == nullptr);
+    const BroadcastPlan& bcast = plan->broadcast;
+
+    // Create output tensors
+    for (size_t k = 0; k < scratch.output_data.size(); ++k) {
+        OrtValue* output = nullptr;
+        OrtStatus* status = info->ort_api->KernelContext_GetOutput(
+            kernel_context, k, bcast.output_dims.data(), bcast.output_dims.size(), &output);
+        if (status != nullptr) return status;
+
+        if (!output) {
+            return info->ort_api->CreateStatus(ORT_FAIL, "Failed to create output");
+        }
+        scratch.outputs[k] = output;
 
-    if (!output) {
-        return info->ort_api->CreateStatus(ORT_FAIL, "Failed to create output");
+        status = info->ort_api->GetTensorMutableData(output, &scratch.output_data[k]);
+        if (status != nullptr) return status;
     }
 
-    // Get data pointers (assuming float tensors for this sample)
-    const float* data_0 = nullptr;
-    const float* data_1 = nullptr;
-    float* data_out = nullptr;
+    const size_t total_elements = bcast.total;
+
+    // Queue the call and return; ORT waits on the stream before it reads the outputs
+    if (stream != nullptr) {
+        auto call = std::make_shared<QueuedCall>();
+        if (RetainBuffers(*info, scratch, call.get())) {
+            call->input_data = scratch.input_data;
+            call->output_data = scratch.output_data;
+            call->uncached = std::move(uncached);
+            const uint64_t bytes = profiler ? BytesMoved(scratch, program, total_elements) : 0;
+            stream->Enqueue([info, state, plan, call, bytes, plan_built] {
+                Profiler* profiler = info->profiler != nullptr && info->profiler->Enabled() ? info->profiler : nullptr;
+                const uint64_t start_ticks = profiler ? Profiler::Now() : 0;
+                RunPartition(*info, *state, *plan, call->input_data.data(), call->output_data.data(),
+                             &call->replicated);
+                if (profiler != nullptr) {
+                    profiler->RecordCompute(info->profile_id, start_ticks, Profiler::Now(), bytes,
+                                            static_cast<uint32_t>(plan->num_chunks), plan_built);
+                }
+            });
+            return nullptr;
+        }
 
-    status = info->ort_api->GetTensorData(input_0, (const void**)&data_0);
-    if (status != nullptr) return status;
-    status = info->ort_api->GetTensorData(input_1, (const void**)&data_1);
-    if (status != nullptr) return status;
-    status = info->ort_api->GetTensorMutableData(output, (void**)&data_out);
-    if (status != nullptr) return status;
+        // Computing inline: partitions queued earlier may produce this one's inputs
+        stream->Drain();
+    }
 
-    // Perform element-wise addition (even for Mul, just for demonstration)
-    // In a real EP, this would dispatch to hardware
-    for (size_t i = 0; i < total_elements; ++i) {
-        data_out[i] = data_0[i] + data_1[i];
+    RunPartition(*info, *state, *plan, scratch.input_data.data(), scratch.output_data.data(), &scratch.replicated);
+
+    if (profiler != nullptr) {
+        profiler->RecordCompute(info->profile_id, start_ticks, Profiler::Now(),
+                                BytesMoved(scratch, program, total_elements),
+                                static_cast<uint32_t>(plan->num_chunks), plan_built);
     }
 
     return nullptr;  // Success
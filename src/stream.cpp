@@ -0,0 +1,199 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// CPU sync streams: an in-order task queue behind each OrtSyncStreamImpl
+
+#include "stream.h"
+#include "counters.h"
+#include "ort_utils.h"
+
+#include <algorithm>
+#include <cstring>
+
+// ============================================================================
+// StreamSet Implementation
+// ============================================================================
+
+void StreamSet::Add(CpuStream* stream) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        streams_.push_back(stream);
+    }
+    // Never with our lock held, so no thread holds two sets' locks at once
+    if (parent_) parent_->Add(stream);
+}
+
+void StreamSet::Remove(CpuStream* stream) {
+    if (parent_) parent_->Remove(stream);
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_.erase(std::remove(streams_.begin(), streams_.end(), stream), streams_.end());
+}
+
+void StreamSet::DrainAll() {
+    // Held throughout so no stream is destroyed while it is drained
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (CpuStream* stream : streams_) stream->Drain();
+}
+
+// ============================================================================
+// CpuNotification - A ticket on a stream
+// Uses composition to wrap OrtSyncNotificationImpl
+// ============================================================================
+
+struct CpuNotification {
+    OrtSyncNotificationImpl impl;  // The actual OrtSyncNotificationImpl struct
+    CpuStream* stream;
+    uint64_t ticket = 0;  // Set by Activate; 0 waits for nothing
+
+    explicit CpuNotification(CpuStream* producer) : stream(producer) {
+        std::memset(&impl, 0, sizeof(impl));
+        impl.ort_version_supported = ORT_API_VERSION;
+        impl.Release = ReleaseImpl;
+        impl.Activate = ActivateImpl;
+        impl.WaitOnDevice = WaitOnDeviceImpl;
+        impl.WaitOnHost = WaitOnHostImpl;
+    }
+
+    static CpuNotification* FromOrt(OrtSyncNotificationImpl* ort_notification) {
+        return CONTAINER_OF(ort_notification, CpuNotification, impl);
+    }
+
+    static void ORT_API_CALL ReleaseImpl(OrtSyncNotificationImpl* this_ptr) noexcept {
+        delete FromOrt(this_ptr);
+    }
+
+    // Mark everything submitted to the producer so far
+    static OrtStatus* ORT_API_CALL ActivateImpl(OrtSyncNotificationImpl* this_ptr) noexcept {
+        auto* notification = FromOrt(this_ptr);
+        notification->ticket = notification->stream->Submitted();
+        return nullptr;
+    }
+
+    // Make `consumer_stream` wait without blocking ORT's thread when it is one of ours: the
+    // wait is queued on it. Work on the producer itself is already in order.
+    static OrtStatus* ORT_API_CALL WaitOnDeviceImpl(OrtSyncNotificationImpl* this_ptr,
+                                                    OrtSyncStream* consumer_stream) noexcept {
+        auto* notification = FromOrt(this_ptr);
+        CpuStream* producer = notification->stream;
+        const uint64_t ticket = notification->ticket;
+
+        CpuStream* consumer = CpuStream::FromOrtStream(producer->ep_api_, consumer_stream);
+        if (consumer == nullptr) {
+            producer->WaitFor(ticket);
+            return nullptr;
+        }
+        if (consumer != producer && ticket != 0) {
+            consumer->Enqueue([producer, ticket] { producer->WaitFor(ticket); });
+        }
+        return nullptr;
+    }
+
+    static OrtStatus* ORT_API_CALL WaitOnHostImpl(OrtSyncNotificationImpl* this_ptr) noexcept {
+        auto* notification = FromOrt(this_ptr);
+        notification->stream->WaitFor(notification->ticket);
+        return nullptr;
+    }
+};
+
+// ============================================================================
+// CpuStream Implementation
+// ============================================================================
+
+CpuStream* CpuStream::FromOrt(OrtSyncStreamImpl* ort_stream) {
+    return CONTAINER_OF(ort_stream, CpuStream, stream_);
+}
+
+CpuStream* CpuStream::FromOrtStream(const OrtEpApi* ep_api, OrtSyncStream* stream) {
+    const OrtSyncStreamImpl* impl = stream ? ep_api->SyncStream_GetImpl(stream) : nullptr;
+    if (impl == nullptr || impl->Release != ReleaseImpl) return nullptr;
+    return FromOrt(const_cast<OrtSyncStreamImpl*>(impl));
+}
+
+CpuStream::CpuStream(const OrtEpApi* ep_api, std::shared_ptr<StreamSet> set)
+    : ep_api_(ep_api), set_(std::move(set)) {
+    std::memset(&stream_, 0, sizeof(stream_));
+    stream_.ort_version_supported = ORT_API_VERSION;
+    stream_.Release = ReleaseImpl;
+    stream_.GetHandle = GetHandleImpl;
+    stream_.CreateNotification = CreateNotificationImpl;
+    stream_.Flush = FlushImpl;
+    stream_.OnSessionRunEnd = OnSessionRunEndImpl;
+
+    if (set_) set_->Add(this);
+}
+
+CpuStream::~CpuStream() {
+    if (set_) set_->Remove(this);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_one();
+    if (worker_.joinable()) worker_.join();
+}
+
+uint64_t CpuStream::Enqueue(Task task) {
+    uint64_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!worker_.joinable()) worker_ = std::thread(&CpuStream::WorkerLoop, this);
+        CountAdd(Counter::StreamQueueDepth, 1);  // Before the worker can take it and count it off
+        queue_.push_back(std::move(task));
+        ticket = ++submitted_;
+    }
+    work_cv_.notify_one();
+    return ticket;
+}
+
+uint64_t CpuStream::Submitted() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return submitted_;
+}
+
+void CpuStream::WaitFor(uint64_t ticket) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [&] { return completed_ >= ticket; });
+}
+
+void CpuStream::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        // Drain the queue before honouring stop_, so no submitted task is dropped
+        work_cv_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+        if (queue_.empty()) return;
+
+        Task task = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+        CountSub(Counter::StreamQueueDepth, 1);
+        task();
+        task = nullptr;  // Release its captures before waiters see it complete
+        lock.lock();
+
+        ++completed_;
+        done_cv_.notify_all();
+    }
+}
+
+void ORT_API_CALL CpuStream::ReleaseImpl(OrtSyncStreamImpl* this_ptr) noexcept {
+    delete FromOrt(this_ptr);
+}
+
+void* ORT_API_CALL CpuStream::GetHandleImpl(OrtSyncStreamImpl* this_ptr) noexcept {
+    return FromOrt(this_ptr);
+}
+
+OrtStatus* ORT_API_CALL CpuStream::CreateNotificationImpl(OrtSyncStreamImpl* this_ptr,
+                                                          OrtSyncNotificationImpl** notification) noexcept {
+    *notification = &(new CpuNotification(FromOrt(this_ptr)))->impl;
+    return nullptr;
+}
+
+OrtStatus* ORT_API_CALL CpuStream::FlushImpl(OrtSyncStreamImpl* this_ptr) noexcept {
+    // Tasks start as soon as they are queued; there is nothing to submit
+    (void)this_ptr;
+    return nullptr;
+}
+
+OrtStatus* ORT_API_CALL CpuStream::OnSessionRunEndImpl(OrtSyncStreamImpl* this_ptr) noexcept {
+    FromOrt(this_ptr)->Drain();
+    return nullptr;
+}
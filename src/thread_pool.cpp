@@ -0,0 +1,140 @@
+// Copyright (c) Sample EP Authors. Licensed under the MIT License.
+// Thread pool used by the Sample EP for intra-op parallelism
+
+#include "thread_pool.h"
+#include "counters.h"
+#include "numa.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+namespace {
+
+// Lower the calling thread's priority. Threads start at their creator's priority, so Normal
+// needs no call and switching back never needs privileges.
+void LowerCurrentThreadPriority() {
+#if defined(_WIN32)
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#elif defined(__linux__)
+    // Nice values are per thread on Linux; failure just leaves the thread as it was
+    (void)setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#elif defined(__APPLE__)
+    pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#endif
+}
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t num_threads, ThreadPriority priority, std::vector<int> cpus)
+    : priority_(priority), cpus_(std::move(cpus)) {
+    StartWorkers(num_threads);
+}
+
+ThreadPool::~ThreadPool() {
+    StopWorkers();
+}
+
+void ThreadPool::Reconfigure(size_t num_threads, ThreadPriority priority) {
+    std::lock_guard<std::mutex> owner(submit_mutex_);
+    StopWorkers();
+    priority_ = priority;
+    StartWorkers(num_threads);
+}
+
+void ThreadPool::StartWorkers(size_t num_threads) {
+    num_threads = num_threads > 0 ? num_threads : 1;
+    ranges_.reset(new Range[num_threads]);
+    stop_ = false;
+
+    // Workers start from the current generation, so a loop posted before one first waits is
+    // still seen as new
+    for (size_t i = 1; i < num_threads; ++i) {
+        workers_.emplace_back([this, i, seen = generation_] { WorkerLoop(i, seen); });
+    }
+    num_threads_.store(num_threads, std::memory_order_relaxed);
+}
+
+void ThreadPool::StopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stop_ = true;
+    }
+    wake_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    num_threads_.store(1, std::memory_order_relaxed);
+}
+
+void ThreadPool::ParallelFor(size_t num_chunks, ChunkFn fn, void* context) {
+    std::unique_lock<std::mutex> owner(submit_mutex_, std::try_to_lock);
+    if (!owner.owns_lock() || workers_.empty() || num_chunks <= 1) {
+        if (!owner.owns_lock() && num_chunks > 1) CountAdd(Counter::BusyPoolLoops, 1);
+        for (size_t chunk = 0; chunk < num_chunks; ++chunk) fn(context, chunk);
+        return;
+    }
+    CountAdd(Counter::ParallelLoops, 1);
+
+    // Give every participant an equal contiguous share of the chunks
+    const size_t participants = NumThreads();
+    for (size_t p = 0; p < participants; ++p) {
+        ranges_[p].next.store(num_chunks * p / participants, std::memory_order_relaxed);
+        ranges_[p].end = num_chunks * (p + 1) / participants;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        fn_ = fn;
+        context_ = context;
+        active_workers_.store(workers_.size(), std::memory_order_relaxed);
+        generation_++;
+    }
+    wake_cv_.notify_all();
+
+    RunChunks(0);
+
+    // Every chunk has been claimed once RunChunks returns; wait for workers still running one
+    while (active_workers_.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+void ThreadPool::RunChunks(size_t self) {
+    const size_t participants = NumThreads();
+    uint64_t stolen = 0;
+    for (size_t offset = 0; offset < participants; ++offset) {
+        Range& range = ranges_[(self + offset) % participants];
+        for (;;) {
+            size_t chunk = range.next.fetch_add(1, std::memory_order_relaxed);
+            if (chunk >= range.end) break;
+            fn_(context_, chunk);
+            if (offset > 0) stolen++;
+        }
+    }
+    if (stolen > 0) CountAdd(Counter::StolenChunks, stolen);
+}
+
+void ThreadPool::WorkerLoop(size_t index, uint64_t seen) {
+    if (priority_ == ThreadPriority::Low) LowerCurrentThreadPriority();
+    if (!cpus_.empty()) PinCurrentThread(cpus_);
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+        }
+
+        RunChunks(index);
+        active_workers_.fetch_sub(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,609 @@
+/**
+ * Microbenchmark for the Sample EP plugin
+ * Compatible with ONNX Runtime 1.23+
+ * Licensed under the MIT License.
+ *
+ * Builds synthetic elementwise models over a sweep of shapes, element types, broadcast
+ * patterns and fusion depths, runs each through the Sample EP and through the default CPU EP,
+ * and prints latency percentiles, GB/s and GFLOP/s per case as JSON. --callers N runs every
+ * case from N threads sharing one session and adds their combined runs per second. With
+ * --calibrate it instead fits the partitioner's cost model to this host and prints it as a
+ * `cost_model` EP option value.
+ *
+ * Usage:
+ *     bench_sample_ep [--plugin PATH] [--iterations N] [--warmup N] [--threads N]
+ *                     [--callers N] [--output FILE] [--quick] [--calibrate]
+ */
+#include <onnxruntime_c_api.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Return early from an OrtStatus-returning function if expr fails
+#define RETURN_IF_ERROR(expr)                   \
+    do {                                        \
+        OrtStatus* _status = (expr);            \
+        if (_status != nullptr) return _status; \
+    } while (0)
+
+const OrtApi* g_ort = nullptr;
+
+namespace {
+
+struct BenchOptions {
+    std::string plugin_path = "./libsample_ep.so";
+    std::string output_path;  // Empty: write JSON to stdout
+    size_t iterations = 200;
+    size_t warmup = 20;
+    size_t threads = 0;       // 0: each EP's default
+    size_t callers = 1;       // Threads calling Run on the same session at once
+    bool quick = false;
+    bool calibrate = false;
+};
+
+struct ElementType {
+    const char* name;
+    ONNXTensorElementDataType type;
+    size_t size;
+};
+
+const ElementType kElementTypes[] = {
+    {"float", ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, 4},
+    {"float16", ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16, 2},
+    {"double", ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE, 8},
+    {"int32", ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32, 4},
+};
+
+// Shape of the second operand relative to X
+enum class Broadcast {
+    None,     // [N, C] op [N, C]
+    Row,      // [N, C] op [C]
+    Scalar,   // [N, C] op [1]
+    Channel,  // [N, C, H, W] op [C, 1, 1]
+};
+
+const char* BroadcastName(Broadcast broadcast) {
+    switch (broadcast) {
+        case Broadcast::None: return "none";
+        case Broadcast::Row: return "row";
+        case Broadcast::Scalar: return "scalar";
+        case Broadcast::Channel: return "channel";
+    }
+    return "unknown";
+}
+
+struct BenchCase {
+    ElementType elem;
+    Broadcast broadcast;
+    std::vector<int64_t> x_shape;  // Also the output shape
+    std::vector<int64_t> b_shape;
+    size_t depth;                  // Chained elementwise nodes
+
+    std::string Name() const {
+        std::ostringstream name;
+        name << elem.name << "/" << BroadcastName(broadcast) << "/";
+        for (size_t d = 0; d < x_shape.size(); ++d) name << (d ? "x" : "") << x_shape[d];
+        name << "/depth" << depth;
+        return name.str();
+    }
+};
+
+struct Stats {
+    double min_us = 0, mean_us = 0, p50_us = 0, p90_us = 0, p99_us = 0;
+    double runs_per_s = 0;  // Over all callers
+};
+
+size_t NumElements(const std::vector<int64_t>& shape) {
+    size_t n = 1;
+    for (int64_t d : shape) n *= static_cast<size_t>(d);
+    return n;
+}
+
+std::vector<BenchCase> MakeCases(bool quick) {
+    // Roughly 4K, 256K and 4M elements: L1-resident, L2/L3-resident and DRAM-bound
+    const std::vector<std::vector<int64_t>> matrices = {{16, 256}, {256, 1024}, {2048, 2048}};
+    const std::vector<std::vector<int64_t>> images = {{1, 16, 16, 16}, {4, 64, 32, 32}, {16, 64, 64, 64}};
+    const std::vector<size_t> depths = quick ? std::vector<size_t>{1, 4} : std::vector<size_t>{1, 2, 4, 8};
+    const size_t first_size = quick ? 1 : 0;
+    const size_t last_size = quick ? 1 : 2;
+
+    std::vector<BenchCase> cases;
+    for (const ElementType& elem : kElementTypes) {
+        if (quick && elem.type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT &&
+            elem.type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16) {
+            continue;
+        }
+        for (Broadcast broadcast : {Broadcast::None, Broadcast::Row, Broadcast::Scalar, Broadcast::Channel}) {
+            for (size_t s = first_size; s <= last_size; ++s) {
+                for (size_t depth : depths) {
+                    BenchCase c{elem, broadcast, {}, {}, depth};
+                    switch (broadcast) {
+                        case Broadcast::None:
+                            c.x_shape = c.b_shape = matrices[s];
+                            break;
+                        case Broadcast::Row:
+                            c.x_shape = matrices[s];
+                            c.b_shape = {matrices[s][1]};
+                            break;
+                        case Broadcast::Scalar:
+                            c.x_shape = matrices[s];
+                            c.b_shape = {1};
+                            break;
+                        case Broadcast::Channel:
+                            c.x_shape = images[s];
+                            c.b_shape = {images[s][1], 1, 1};
+                            break;
+                    }
+                    cases.push_back(c);
+                }
+            }
+        }
+    }
+    return cases;
+}
+
+OrtStatus* CreateValueInfo(const OrtModelEditorApi* model_api, const char* name,
+                           ONNXTensorElementDataType type, const std::vector<int64_t>& shape,
+                           OrtValueInfo** value_info) {
+    OrtTensorTypeAndShapeInfo* tensor_info = nullptr;
+    RETURN_IF_ERROR(g_ort->CreateTensorTypeAndShapeInfo(&tensor_info));
+    OrtStatus* status = g_ort->SetTensorElementType(tensor_info, type);
+    if (status == nullptr) status = g_ort->SetDimensions(tensor_info, shape.data(), shape.size());
+
+    OrtTypeInfo* type_info = nullptr;
+    if (status == nullptr) status = model_api->CreateTensorTypeInfo(tensor_info, &type_info);
+    g_ort->ReleaseTensorTypeAndShapeInfo(tensor_info);
+    if (status != nullptr) return status;
+
+    status = model_api->CreateValueInfo(name, type_info, value_info);
+    g_ort->ReleaseTypeInfo(type_info);
+    return status;
+}
+
+// Z = op_depth(... op_1(X, B) ..., B), cycling through Add, Mul, Sub
+OrtStatus* BuildModel(const OrtModelEditorApi* model_api, const BenchCase& c, OrtModel** model) {
+    OrtValueInfo* vi_x = nullptr;
+    OrtValueInfo* vi_b = nullptr;
+    OrtValueInfo* vi_z = nullptr;
+    RETURN_IF_ERROR(CreateValueInfo(model_api, "X", c.elem.type, c.x_shape, &vi_x));
+    RETURN_IF_ERROR(CreateValueInfo(model_api, "B", c.elem.type, c.b_shape, &vi_b));
+    RETURN_IF_ERROR(CreateValueInfo(model_api, "Z", c.elem.type, c.x_shape, &vi_z));
+
+    OrtGraph* graph = nullptr;
+    RETURN_IF_ERROR(model_api->CreateGraph(&graph));
+
+    OrtValueInfo* inputs[] = {vi_x, vi_b};
+    RETURN_IF_ERROR(model_api->SetGraphInputs(graph, inputs, 2));
+    OrtValueInfo* outputs[] = {vi_z};
+    RETURN_IF_ERROR(model_api->SetGraphOutputs(graph, outputs, 1));
+
+    const char* op_types[] = {"Add", "Mul", "Sub"};
+    std::string previous = "X";
+    for (size_t i = 0; i < c.depth; ++i) {
+        const std::string output = (i + 1 == c.depth) ? "Z" : "T" + std::to_string(i);
+        const std::string node_name = "node" + std::to_string(i);
+        const char* in_names[] = {previous.c_str(), "B"};
+        const char* out_name = output.c_str();
+
+        OrtNode* node = nullptr;
+        RETURN_IF_ERROR(model_api->CreateNode(op_types[i % 3], "", node_name.c_str(),
+                                              in_names, 2, &out_name, 1, nullptr, 0, &node));
+        RETURN_IF_ERROR(model_api->AddNodeToGraph(graph, node));
+        previous = output;
+    }
+
+    const char* domains[] = {""};
+    const int opsets[] = {14};
+    RETURN_IF_ERROR(model_api->CreateModel(domains, opsets, 1, model));
+    return model_api->AddGraphToModel(*model, graph);
+}
+
+// Session running `c` on the Sample EP, or on the default CPU EP if ep_device is null
+OrtStatus* CreateSession(OrtEnv* env, const OrtModelEditorApi* model_api, const BenchCase& c,
+                         const OrtEpDevice* ep_device, const BenchOptions& options,
+                         OrtSession** session) {
+    OrtModel* model = nullptr;
+    RETURN_IF_ERROR(BuildModel(model_api, c, &model));
+
+    OrtSessionOptions* session_options = nullptr;
+    OrtStatus* status = g_ort->CreateSessionOptions(&session_options);
+
+    // Claim every case, including ones the cost model would leave to the CPU EP
+    const std::string threads = std::to_string(options.threads);
+    if (status == nullptr && ep_device != nullptr) {
+        const char* keys[] = {"partition_policy", "num_threads"};
+        const char* values[] = {"all", threads.c_str()};
+        status = g_ort->SessionOptionsAppendExecutionProvider_V2(
+            session_options, env, &ep_device, 1, keys, values, options.threads ? 2 : 1);
+    } else if (status == nullptr && options.threads != 0) {
+        status = g_ort->SetIntraOpNumThreads(session_options, static_cast<int>(options.threads));
+    }
+
+    if (status == nullptr) {
+        status = model_api->CreateSessionFromModel(env, model, session_options, session);
+    }
+
+    if (session_options != nullptr) g_ort->ReleaseSessionOptions(session_options);
+    g_ort->ReleaseModel(model);
+    return status;
+}
+
+// Values near 1 keep chained Mul/Add/Sub finite in every element type
+std::vector<uint8_t> MakeData(const ElementType& elem, size_t count) {
+    std::vector<uint8_t> data(count * elem.size);
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t* p = data.data() + i * elem.size;
+        const double value = 0.5 + 0.5 * static_cast<double>(i % 7) / 7.0;
+        switch (elem.type) {
+            case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT: {
+                float v = static_cast<float>(value);
+                std::memcpy(p, &v, sizeof(v));
+                break;
+            }
+            case ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE:
+                std::memcpy(p, &value, sizeof(value));
+                break;
+            case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16: {
+                const uint16_t halves[] = {0x3800, 0x3A00, 0x3C00};  // 0.5, 0.75, 1.0
+                std::memcpy(p, &halves[i % 3], sizeof(uint16_t));
+                break;
+            }
+            case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32: {
+                int32_t v = static_cast<int32_t>(i % 3) + 1;
+                std::memcpy(p, &v, sizeof(v));
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return data;
+}
+
+OrtStatus* CreateInput(const OrtMemoryInfo* memory_info, const ElementType& elem,
+                       const std::vector<int64_t>& shape, std::vector<uint8_t>& data,
+                       OrtValue** value) {
+    return g_ort->CreateTensorWithDataAsOrtValue(memory_info, data.data(), data.size(),
+                                                 shape.data(), shape.size(), elem.type, value);
+}
+
+Stats Summarize(std::vector<double> latencies_us) {
+    Stats stats;
+    if (latencies_us.empty()) return stats;
+    std::sort(latencies_us.begin(), latencies_us.end());
+    auto percentile = [&](double p) {
+        size_t index = static_cast<size_t>(p * static_cast<double>(latencies_us.size() - 1) + 0.5);
+        return latencies_us[index];
+    };
+    double sum = 0;
+    for (double v : latencies_us) sum += v;
+    stats.min_us = latencies_us.front();
+    stats.mean_us = sum / static_cast<double>(latencies_us.size());
+    stats.p50_us = percentile(0.50);
+    stats.p90_us = percentile(0.90);
+    stats.p99_us = percentile(0.99);
+    return stats;
+}
+
+OrtStatus* RunCase(OrtSession* session, const BenchCase& c, const BenchOptions& options,
+                   Stats* stats) {
+    OrtMemoryInfo* memory_info = nullptr;
+    RETURN_IF_ERROR(g_ort->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &memory_info));
+
+    std::vector<uint8_t> x_data = MakeData(c.elem, NumElements(c.x_shape));
+    std::vector<uint8_t> b_data = MakeData(c.elem, NumElements(c.b_shape));
+
+    OrtValue* inputs[2] = {nullptr, nullptr};
+    OrtStatus* status = CreateInput(memory_info, c.elem, c.x_shape, x_data, &inputs[0]);
+    if (status == nullptr) status = CreateInput(memory_info, c.elem, c.b_shape, b_data, &inputs[1]);
+
+    // Every caller runs warmup + iterations calls on the shared session and inputs
+    const size_t callers = std::max<size_t>(1, options.callers);
+    std::vector<std::vector<double>> latencies_us(callers);
+    std::vector<OrtStatus*> statuses(callers, nullptr);
+    auto run_caller = [&](size_t caller) {
+        const char* input_names[] = {"X", "B"};
+        const char* output_names[] = {"Z"};
+        std::vector<double>& latencies = latencies_us[caller];
+        latencies.reserve(options.iterations);
+        for (size_t i = 0; statuses[caller] == nullptr && i < options.warmup + options.iterations; ++i) {
+            OrtValue* output = nullptr;
+            const auto start = std::chrono::steady_clock::now();
+            statuses[caller] = g_ort->Run(session, nullptr, input_names, inputs, 2, output_names, 1, &output);
+            const auto end = std::chrono::steady_clock::now();
+            if (output != nullptr) g_ort->ReleaseValue(output);
+
+            if (i >= options.warmup) {
+                latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            }
+        }
+    };
+
+    const auto wall_start = std::chrono::steady_clock::now();
+    if (status == nullptr) {
+        std::vector<std::thread> threads;
+        for (size_t caller = 1; caller < callers; ++caller) threads.emplace_back(run_caller, caller);
+        run_caller(0);
+        for (auto& thread : threads) thread.join();
+    }
+    const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+    for (OrtStatus*& caller_status : statuses) {
+        if (status == nullptr) {
+            status = caller_status;
+        } else if (caller_status != nullptr) {
+            g_ort->ReleaseStatus(caller_status);
+        }
+    }
+    for (OrtValue* input : inputs) {
+        if (input != nullptr) g_ort->ReleaseValue(input);
+    }
+    g_ort->ReleaseMemoryInfo(memory_info);
+
+    if (status == nullptr) {
+        std::vector<double> all;
+        for (const auto& latencies : latencies_us) all.insert(all.end(), latencies.begin(), latencies.end());
+        *stats = Summarize(all);
+        // Warmup calls are part of the wall time, so count them too
+        const double runs = static_cast<double>(callers * (options.warmup + options.iterations));
+        stats->runs_per_s = wall_s > 0 ? runs / wall_s : 0;
+    }
+    return status;
+}
+
+// Each node reads X (or the previous node's output) and B and writes one output; at depth d
+// an unfused EP moves d times as much data, a fused one the same as depth 1
+void WriteProviderJson(std::ostream& out, const BenchCase& c, const Stats& stats) {
+    const double elements = static_cast<double>(NumElements(c.x_shape));
+    const double bytes = static_cast<double>(c.elem.size) *
+                         (2 * elements + static_cast<double>(NumElements(c.b_shape)));
+    const double seconds = stats.p50_us * 1e-6;
+    out << "{\"min_us\": " << stats.min_us << ", \"mean_us\": " << stats.mean_us
+        << ", \"p50_us\": " << stats.p50_us << ", \"p90_us\": " << stats.p90_us
+        << ", \"p99_us\": " << stats.p99_us << ", \"runs_per_s\": " << stats.runs_per_s
+        << ", \"gbps\": " << (seconds > 0 ? bytes / seconds * 1e-9 : 0)
+        << ", \"gflops\": " << (seconds > 0 ? elements * static_cast<double>(c.depth) / seconds * 1e-9 : 0)
+        << "}";
+}
+
+void WriteError(std::ostream& out, OrtStatus* status) {
+    std::string message = g_ort->GetErrorMessage(status);
+    std::replace(message.begin(), message.end(), '"', '\'');
+    std::replace(message.begin(), message.end(), '\n', ' ');
+    out << "{\"error\": \"" << message << "\"}";
+    g_ort->ReleaseStatus(status);
+}
+
+// Least-squares line through (x, y): y = intercept + slope * x
+void FitLine(const std::vector<double>& x, const std::vector<double>& y, double* intercept, double* slope) {
+    const double n = static_cast<double>(x.size());
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        sx += x[i];
+        sy += y[i];
+        sxx += x[i] * x[i];
+        sxy += x[i] * y[i];
+    }
+    *slope = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+    *intercept = (sy - *slope * sx) / n;
+}
+
+// Fit the cost model's call overheads and streaming rates from float Add chains of growing size.
+// Per-op compute costs need heavier ops than the bench builds and keep their defaults.
+OrtStatus* Calibrate(OrtEnv* env, const OrtModelEditorApi* model_api, const OrtEpDevice* ep_device,
+                     BenchOptions options, std::ostream& out) {
+    options.callers = 1;  // Latency of one caller, not throughput
+    const std::vector<std::vector<int64_t>> shapes = {{1, 64}, {16, 256}, {64, 1024}, {256, 1024}};
+    const ElementType& elem = kElementTypes[0];
+
+    // Latency against bytes moved, per provider and depth. Depth 4 separates the CPU EP's
+    // per-node cost from the per-run cost both providers pay.
+    double intercept[2][2] = {};
+    double slope[2][2] = {};
+    for (size_t p = 0; p < 2; ++p) {
+        for (size_t d = 0; d < 2; ++d) {
+            const size_t depth = d == 0 ? 1 : 4;
+            std::vector<double> bytes, latency_ns;
+            for (const auto& shape : shapes) {
+                BenchCase c{elem, Broadcast::None, shape, shape, depth};
+                std::cerr << "[calibrate] " << (p == 0 ? "SampleEP " : "CPU ") << c.Name() << std::endl;
+
+                OrtSession* session = nullptr;
+                Stats stats;
+                OrtStatus* status = CreateSession(env, model_api, c, p == 0 ? ep_device : nullptr, options, &session);
+                if (status == nullptr) status = RunCase(session, c, options, &stats);
+                if (session != nullptr) g_ort->ReleaseSession(session);
+                if (status != nullptr) return status;
+
+                // Per node: X (or the previous output) and B read, one output written
+                bytes.push_back(static_cast<double>(3 * NumElements(shape) * elem.size * depth));
+                latency_ns.push_back(stats.p50_us * 1e3);
+            }
+            FitLine(bytes, latency_ns, &intercept[p][d], &slope[p][d]);
+        }
+    }
+
+    // Both providers pay the session's per-run cost; the depth-4 CPU chain separates it from
+    // the CPU EP's per-node cost. Fits that come out non-positive (noise on very fast hosts)
+    // are left out so the EP keeps its default for that field.
+    const double cpu_node_ns = (intercept[1][1] - intercept[1][0]) / 3;
+    const double run_ns = intercept[1][0] - cpu_node_ns;
+    const double ep_call_ns = intercept[0][0] - run_ns;
+
+    std::ostringstream spec;
+    const auto field = [&spec](const char* name, double value) {
+        if (value <= 0) return;
+        if (spec.tellp() > 0) spec << ",";
+        spec << name << "=" << value;
+    };
+    field("ep_call_ns", ep_call_ns);
+    field("ep_bytes_per_ns", slope[0][0] > 0 ? 1 / slope[0][0] : 0);
+    field("cpu_node_ns", cpu_node_ns);
+    field("cpu_bytes_per_ns", slope[1][0] > 0 ? 1 / slope[1][0] : 0);
+
+    out << "{\n  \"ort_version\": \"" << OrtGetApiBase()->GetVersionString() << "\",\n"
+        << "  \"run_overhead_ns\": " << run_ns << ",\n"
+        << "  \"cost_model\": \"" << spec.str() << "\"\n}\n";
+    return nullptr;
+}
+
+bool ParseArgs(int argc, char* argv[], BenchOptions* options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--plugin" && has_value) {
+            options->plugin_path = argv[++i];
+        } else if (arg == "--output" && has_value) {
+            options->output_path = argv[++i];
+        } else if (arg == "--iterations" && has_value) {
+            options->iterations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--warmup" && has_value) {
+            options->warmup = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && has_value) {
+            options->threads = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--callers" && has_value) {
+            options->callers = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--quick") {
+            options->quick = true;
+        } else if (arg == "--calibrate") {
+            options->calibrate = true;
+        } else {
+            return false;
+        }
+    }
+    return options->iterations > 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!ParseArgs(argc, argv, &options)) {
+        std::cerr << "Usage: " << argv[0] << " [--plugin PATH] [--iterations N] [--warmup N]"
+                  << " [--threads N] [--callers N] [--output FILE] [--quick] [--calibrate]" << std::endl;
+        return 2;
+    }
+
+    g_ort = OrtGetApiBase()->GetApi(ORT_API_VERSION);
+    if (!g_ort) {
+        std::cerr << "Failed to get ORT API" << std::endl;
+        return 1;
+    }
+
+    const OrtModelEditorApi* model_api = g_ort->GetModelEditorApi();
+    if (!model_api) {
+        std::cerr << "ModelEditorApi not available (minimal build?)" << std::endl;
+        return 1;
+    }
+
+    OrtEnv* env = nullptr;
+    OrtStatus* status = g_ort->CreateEnv(ORT_LOGGING_LEVEL_ERROR, "bench_sample_ep", &env);
+    if (status == nullptr) {
+        status = g_ort->RegisterExecutionProviderLibrary(env, "SampleEP", options.plugin_path.c_str());
+    }
+    if (status != nullptr) {
+        std::cerr << "Failed to load " << options.plugin_path << ": " << g_ort->GetErrorMessage(status) << std::endl;
+        g_ort->ReleaseStatus(status);
+        if (env) g_ort->ReleaseEnv(env);
+        return 1;
+    }
+
+    // Find our plugin EP device
+    const OrtEpDevice* const* ep_devices = nullptr;
+    size_t num_ep_devices = 0;
+    const OrtEpDevice* sample_ep_device = nullptr;
+    status = g_ort->GetEpDevices(env, &ep_devices, &num_ep_devices);
+    for (size_t i = 0; status == nullptr && i < num_ep_devices; ++i) {
+        const char* ep_name = g_ort->EpDevice_EpName(ep_devices[i]);
+        if (ep_name && std::strstr(ep_name, "SampleEP") != nullptr) sample_ep_device = ep_devices[i];
+    }
+    if (status != nullptr || sample_ep_device == nullptr) {
+        std::cerr << "Could not find SampleEP device" << std::endl;
+        if (status) g_ort->ReleaseStatus(status);
+        g_ort->ReleaseEnv(env);
+        return 1;
+    }
+
+    std::ofstream file;
+    if (!options.output_path.empty()) {
+        file.open(options.output_path);
+        if (!file) {
+            std::cerr << "Cannot open " << options.output_path << std::endl;
+            g_ort->ReleaseEnv(env);
+            return 1;
+        }
+    }
+    std::ostream& out = options.output_path.empty() ? std::cout : file;
+
+    if (options.calibrate) {
+        status = Calibrate(env, model_api, sample_ep_device, options, out);
+        const int result = status == nullptr ? 0 : 1;
+        if (status != nullptr) {
+            std::cerr << "Calibration failed: " << g_ort->GetErrorMessage(status) << std::endl;
+            g_ort->ReleaseStatus(status);
+        }
+        status = g_ort->UnregisterExecutionProviderLibrary(env, "SampleEP");
+        if (status != nullptr) g_ort->ReleaseStatus(status);
+        g_ort->ReleaseEnv(env);
+        return result;
+    }
+
+    out << "{\n  \"ort_version\": \"" << OrtGetApiBase()->GetVersionString() << "\",\n"
+        << "  \"iterations\": " << options.iterations << ",\n"
+        << "  \"threads\": " << options.threads << ",\n"
+        << "  \"callers\": " << options.callers << ",\n"
+        << "  \"cases\": [";
+
+    const std::vector<BenchCase> cases = MakeCases(options.quick);
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const BenchCase& c = cases[i];
+        std::cerr << "[" << (i + 1) << "/" << cases.size() << "] " << c.Name() << std::endl;
+
+        out << (i ? "," : "") << "\n    {\"name\": \"" << c.Name() << "\", \"dtype\": \"" << c.elem.name
+            << "\", \"broadcast\": \"" << BroadcastName(c.broadcast) << "\", \"depth\": " << c.depth
+            << ", \"elements\": " << NumElements(c.x_shape) << ", \"providers\": {";
+
+        double p50[2] = {0, 0};
+        const struct {
+            const char* name;
+            const OrtEpDevice* device;
+        } providers[] = {{"SampleEP", sample_ep_device}, {"CPU", nullptr}};
+
+        for (size_t p = 0; p < 2; ++p) {
+            out << (p ? ", " : "") << "\"" << providers[p].name << "\": ";
+
+            OrtSession* session = nullptr;
+            Stats stats;
+            status = CreateSession(env, model_api, c, providers[p].device, options, &session);
+            if (status == nullptr) status = RunCase(session, c, options, &stats);
+            if (session != nullptr) g_ort->ReleaseSession(session);
+
+            if (status != nullptr) {
+                WriteError(out, status);
+                continue;
+            }
+            WriteProviderJson(out, c, stats);
+            p50[p] = stats.p50_us;
+        }
+
+        out << "}";
+        if (p50[0] > 0 && p50[1] > 0) out << ", \"speedup\": " << p50[1] / p50[0];
+        out << "}";
+        out.flush();
+    }
+    out << "\n  ]\n}\n";
+
+    status = g_ort->UnregisterExecutionProviderLibrary(env, "SampleEP");
+    if (status != nullptr) g_ort->ReleaseStatus(status);
+    g_ort->ReleaseEnv(env);
+    return 0;
+}
@@ -0,0 +1,394 @@
+"""
+End-to-end performance regression suite for the Sample EP plugin.
+Compatible with ONNX Runtime 1.23+
+
+Licensed under the MIT License.
+
+Builds realistic models (an MLP block, a transformer layer, an elementwise-heavy image
+preprocessing graph) and runs each under the default CPU EP and under the Sample EP, every
+run in a fresh process so cold start and peak RSS are its own. Checks that the outputs agree,
+reports the speedup, cold start time, peak RSS and the Sample EP's per-partition breakdown,
+and fails when a result regresses past the baselines stored in perf_baselines.json.
+
+Usage:
+    python perf_sample_ep.py [--plugin PATH] [--runs N] [--warmup N] [--threads N]
+                             [--models NAME,...] [--output FILE]
+                             [--baselines FILE] [--update-baselines | --no-baseline | --report-only]
+"""
+import argparse
+import json
+import os
+import platform
+import resource
+import subprocess
+import sys
+import tempfile
+import time
+
+import numpy as np
+import onnx
+from onnx import helper, numpy_helper, TensorProto
+import onnxruntime as ort
+
+
+def weight(rng, name, shape, scale=None):
+    """A random float32 initializer, scaled so activations stay in range through the layer."""
+    scale = scale if scale is not None else 1.0 / np.sqrt(shape[0])
+    return numpy_helper.from_array((rng.standard_normal(shape) * scale).astype(np.float32), name)
+
+
+def finish_model(nodes, name, inputs, outputs, initializers, opset=20):
+    graph = helper.make_graph(nodes, name, inputs, outputs, initializer=initializers)
+    model = helper.make_model(graph, opset_imports=[helper.make_opsetid("", opset)])
+    model.ir_version = 9
+    onnx.checker.check_model(model)
+    return model.SerializeToString()
+
+
+def build_mlp_model(tokens=64, d=512, hidden=2048):
+    """Build a pre-norm MLP block: Y = X + Gelu(LayerNorm(X) @ W1 + B1) @ W2 + B2."""
+    rng = np.random.default_rng(0)
+    X = helper.make_tensor_value_info("X", TensorProto.FLOAT, [tokens, d])
+    Y = helper.make_tensor_value_info("Y", TensorProto.FLOAT, [tokens, d])
+
+    initializers = [
+        numpy_helper.from_array(np.ones(d, np.float32), "G"),
+        numpy_helper.from_array(np.zeros(d, np.float32), "B"),
+        weight(rng, "W1", [d, hidden]),
+        weight(rng, "B1", [hidden], 0.1),
+        weight(rng, "W2", [hidden, d]),
+        weight(rng, "B2", [d], 0.1),
+    ]
+    nodes = [
+        helper.make_node("LayerNormalization", ["X", "G", "B"], ["T0"], name="ln_node", epsilon=1e-5),
+        helper.make_node("MatMul", ["T0", "W1"], ["T1"], name="up_node"),
+        helper.make_node("Add", ["T1", "B1"], ["T2"], name="up_bias_node"),
+        helper.make_node("Gelu", ["T2"], ["T3"], name="gelu_node"),
+        helper.make_node("MatMul", ["T3", "W2"], ["T4"], name="down_node"),
+        helper.make_node("Add", ["T4", "B2"], ["T5"], name="down_bias_node"),
+        helper.make_node("Add", ["X", "T5"], ["Y"], name="residual_node"),
+    ]
+    feeds = {"X": rng.standard_normal((tokens, d)).astype(np.float32)}
+    return finish_model(nodes, "mlp_graph", [X], [Y], initializers), feeds
+
+
+def build_transformer_model(seq=128, d=256, hidden=1024):
+    """Build a single-head pre-norm transformer layer: attention and an MLP, each with a
+    residual. The activation-by-activation MatMuls and the Transpose stay on the CPU EP."""
+    rng = np.random.default_rng(1)
+    X = helper.make_tensor_value_info("X", TensorProto.FLOAT, [seq, d])
+    Y = helper.make_tensor_value_info("Y", TensorProto.FLOAT, [seq, d])
+
+    initializers = [
+        numpy_helper.from_array(np.ones(d, np.float32), "G"),
+        numpy_helper.from_array(np.zeros(d, np.float32), "B"),
+        weight(rng, "Wq", [d, d]),
+        weight(rng, "Wk", [d, d]),
+        weight(rng, "Wv", [d, d]),
+        weight(rng, "Wo", [d, d]),
+        weight(rng, "Bo", [d], 0.1),
+        numpy_helper.from_array(np.array(1.0 / np.sqrt(d), np.float32), "scale"),
+        weight(rng, "W1", [d, hidden]),
+        weight(rng, "B1", [hidden], 0.1),
+        weight(rng, "W2", [hidden, d]),
+        weight(rng, "B2", [d], 0.1),
+    ]
+    nodes = [
+        helper.make_node("LayerNormalization", ["X", "G", "B"], ["N0"], name="ln0_node", epsilon=1e-5),
+        helper.make_node("MatMul", ["N0", "Wq"], ["Q"], name="q_node"),
+        helper.make_node("MatMul", ["N0", "Wk"], ["K"], name="k_node"),
+        helper.make_node("MatMul", ["N0", "Wv"], ["V"], name="v_node"),
+        helper.make_node("Transpose", ["K"], ["Kt"], name="kt_node", perm=[1, 0]),
+        helper.make_node("MatMul", ["Q", "Kt"], ["S0"], name="scores_node"),
+        helper.make_node("Mul", ["S0", "scale"], ["S1"], name="scale_node"),
+        helper.make_node("Softmax", ["S1"], ["P"], name="softmax_node", axis=-1),
+        helper.make_node("MatMul", ["P", "V"], ["A"], name="context_node"),
+        helper.make_node("MatMul", ["A", "Wo"], ["O0"], name="out_node"),
+        helper.make_node("Add", ["O0", "Bo"], ["O1"], name="out_bias_node"),
+        helper.make_node("Add", ["X", "O1"], ["H"], name="attn_residual_node"),
+        helper.make_node("LayerNormalization", ["H", "G", "B"], ["N1"], name="ln1_node", epsilon=1e-5),
+        helper.make_node("MatMul", ["N1", "W1"], ["F0"], name="up_node"),
+        helper.make_node("Add", ["F0", "B1"], ["F1"], name="up_bias_node"),
+        helper.make_node("Gelu", ["F1"], ["F2"], name="gelu_node"),
+        helper.make_node("MatMul", ["F2", "W2"], ["F3"], name="down_node"),
+        helper.make_node("Add", ["F3", "B2"], ["F4"], name="down_bias_node"),
+        helper.make_node("Add", ["H", "F4"], ["Y"], name="mlp_residual_node"),
+    ]
+    feeds = {"X": rng.standard_normal((seq, d)).astype(np.float32)}
+    return finish_model(nodes, "transformer_graph", [X], [Y], initializers), feeds
+
+
+def build_preprocess_model(batch=8, size=224):
+    """Build NHWC image preprocessing: Z = Clip(((X * contrast + brightness) / 255 - mean) / std, -3, 3),
+    with a mask of pixels above a threshold and a per-pixel grayscale mean."""
+    rng = np.random.default_rng(2)
+    X = helper.make_tensor_value_info("X", TensorProto.FLOAT, [batch, size, size, 3])
+    outputs = [
+        helper.make_tensor_value_info("Z", TensorProto.FLOAT, [batch, size, size, 3]),
+        helper.make_tensor_value_info("M", TensorProto.FLOAT, [batch, size, size, 3]),
+        helper.make_tensor_value_info("Gray", TensorProto.FLOAT, [batch, size, size, 1]),
+    ]
+
+    initializers = [
+        numpy_helper.from_array(np.array(1.2, np.float32), "contrast"),
+        numpy_helper.from_array(np.array(-8.0, np.float32), "brightness"),
+        numpy_helper.from_array(np.array(255.0, np.float32), "range"),
+        numpy_helper.from_array(np.array([0.485, 0.456, 0.406], np.float32), "mean"),
+        numpy_helper.from_array(np.array([0.229, 0.224, 0.225], np.float32), "std"),
+        numpy_helper.from_array(np.array(-3.0, np.float32), "lo"),
+        numpy_helper.from_array(np.array(3.0, np.float32), "hi"),
+        numpy_helper.from_array(np.array(0.0, np.float32), "zero"),
+        numpy_helper.from_array(np.array([3], np.int64), "channel_axis"),
+    ]
+    nodes = [
+        helper.make_node("Mul", ["X", "contrast"], ["T0"], name="contrast_node"),
+        helper.make_node("Add", ["T0", "brightness"], ["T1"], name="brightness_node"),
+        helper.make_node("Div", ["T1", "range"], ["T2"], name="range_node"),
+        helper.make_node("Sub", ["T2", "mean"], ["T3"], name="mean_node"),
+        helper.make_node("Div", ["T3", "std"], ["T4"], name="std_node"),
+        helper.make_node("Clip", ["T4", "lo", "hi"], ["Z"], name="clip_node"),
+        helper.make_node("Greater", ["Z", "zero"], ["C"], name="threshold_node"),
+        helper.make_node("Where", ["C", "Z", "zero"], ["M"], name="mask_node"),
+        helper.make_node("ReduceMean", ["T2", "channel_axis"], ["Gray"], name="gray_node"),
+    ]
+    feeds = {"X": rng.uniform(0, 255, (batch, size, size, 3)).astype(np.float32)}
+    return finish_model(nodes, "preprocess_graph", [X], outputs, initializers), feeds
+
+
+# name -> (builder, rtol, atol). MatMuls accumulate in a different order than ORT's MLAS.
+MODELS = {
+    "mlp_block": (build_mlp_model, 1e-3, 1e-3),
+    "transformer_layer": (build_transformer_model, 1e-3, 1e-3),
+    "preprocess": (build_preprocess_model, 1e-5, 1e-5),
+}
+
+PROVIDERS = ("cpu", "sample")
+
+
+# =============================================================================
+# Worker: one model on one EP, in a process of its own
+# =============================================================================
+
+def peak_rss_mb():
+    """Peak resident set size of this process so far."""
+    peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    return peak / (1024.0 * 1024.0) if sys.platform == "darwin" else peak / 1024.0
+
+
+def partition_breakdown(profile_path):
+    """Time per partition from the EP's Chrome trace, heaviest first."""
+    with open(profile_path) as f:
+        events = json.load(f)
+    partitions = {}
+    for event in events:
+        if event.get("cat") != "Node":
+            continue
+        entry = partitions.setdefault(event["name"], {
+            "partition": event["name"], "kernel": event["args"]["kernel"], "calls": 0, "total_us": 0.0})
+        entry["calls"] += 1
+        entry["total_us"] += event["dur"]
+    for entry in partitions.values():
+        entry["mean_us"] = entry["total_us"] / entry["calls"]
+    return sorted(partitions.values(), key=lambda e: -e["total_us"])
+
+
+def run_worker(args):
+    model_bytes, feeds = MODELS[args.model][0]()
+    session_options = ort.SessionOptions()
+    session_options.intra_op_num_threads = args.threads
+    profile_path = None
+
+    if args.provider == "sample":
+        ort.register_execution_provider_library("SampleEP", args.plugin)
+        devices = [d for d in ort.get_ep_devices() if "SampleEP" in d.ep_name]
+        if not devices:
+            raise RuntimeError("Could not find SampleEP device")
+        profile_path = os.path.join(args.scratch, f"{args.model}_profile.json")
+        session_options.add_provider_for_devices(devices, {
+            "num_threads": str(args.threads), "profile_file": profile_path})
+
+    # Cold start: session creation (partitioning, compilation) and the first run
+    start = time.perf_counter()
+    session = ort.InferenceSession(model_bytes, sess_options=session_options)
+    outputs = session.run(None, feeds)
+    cold_start_ms = (time.perf_counter() - start) * 1e3
+
+    for _ in range(args.warmup):
+        session.run(None, feeds)
+    latencies = []
+    for _ in range(args.runs):
+        start = time.perf_counter()
+        session.run(None, feeds)
+        latencies.append((time.perf_counter() - start) * 1e6)
+    latencies.sort()
+
+    # Profiling is switched on only after timing, so it does not skew the latencies
+    if profile_path is not None:
+        session.set_ep_dynamic_options({"enable_profiling": "1"})
+        for _ in range(min(args.runs, 20)):
+            session.run(None, feeds)
+        session.set_ep_dynamic_options({"enable_profiling": "0"})
+
+    result = {
+        "cold_start_ms": cold_start_ms,
+        "p50_us": latencies[len(latencies) // 2],
+        "p90_us": latencies[min(len(latencies) - 1, len(latencies) * 9 // 10)],
+        "peak_rss_mb": peak_rss_mb(),
+    }
+    np.savez(os.path.join(args.scratch, f"{args.model}_{args.provider}.npz"), *outputs)
+
+    del session  # Closes the trace file
+    if profile_path is not None:
+        ort.unregister_execution_provider_library("SampleEP")
+        result["partitions"] = partition_breakdown(profile_path)
+    print(json.dumps(result))
+    return 0
+
+
+# =============================================================================
+# Driver: every model on both EPs, checked against the baselines
+# =============================================================================
+
+def host_description(threads):
+    return f"{platform.machine()} {platform.processor() or platform.system()}, {os.cpu_count()} cores, {threads} threads"
+
+
+def measure(args, model, provider, scratch):
+    command = [sys.executable, os.path.abspath(__file__), "--worker", "--model", model, "--provider", provider,
+               "--plugin", args.plugin, "--runs", str(args.runs), "--warmup", str(args.warmup),
+               "--threads", str(args.threads), "--scratch", scratch]
+    completed = subprocess.run(command, capture_output=True, text=True)
+    if completed.returncode != 0:
+        raise RuntimeError(f"{model} on the {provider} EP failed:\n{completed.stdout}{completed.stderr}")
+    return json.loads(completed.stdout.strip().splitlines()[-1])
+
+
+def check_agreement(model, scratch):
+    """Largest absolute difference between the two EPs' outputs; None if outside tolerance."""
+    _, rtol, atol = MODELS[model]
+    cpu = np.load(os.path.join(scratch, f"{model}_cpu.npz"))
+    sample = np.load(os.path.join(scratch, f"{model}_sample.npz"))
+    max_error = 0.0
+    for key in cpu.files:
+        expected = cpu[key].astype(np.float64)
+        actual = sample[key].astype(np.float64)
+        if expected.shape != actual.shape or not np.allclose(actual, expected, rtol=rtol, atol=atol):
+            return None
+        max_error = max(max_error, float(np.max(np.abs(actual - expected), initial=0.0)))
+    return max_error
+
+
+def compare(result, baseline, tolerance):
+    """Regressions of `result` against its stored baseline, as messages."""
+    failures = []
+    if result["speedup"] < baseline["speedup"] * (1 - tolerance["speedup"]):
+        failures.append(f"speedup {result['speedup']:.2f}x below baseline {baseline['speedup']:.2f}x")
+    if result["cold_start_ms"] > baseline["cold_start_ms"] * (1 + tolerance["cold_start"]):
+        failures.append(f"cold start {result['cold_start_ms']:.1f} ms above baseline "
+                        f"{baseline['cold_start_ms']:.1f} ms")
+    if result["peak_rss_mb"] > baseline["peak_rss_mb"] * (1 + tolerance["peak_rss"]):
+        failures.append(f"peak RSS {result['peak_rss_mb']:.1f} MB above baseline {baseline['peak_rss_mb']:.1f} MB")
+    return failures
+
+
+def main():
+    script_dir = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1])
+    parser.add_argument("--plugin", default=os.path.join(script_dir, "..", "build", "libsample_ep.so"))
+    parser.add_argument("--runs", type=int, default=100)
+    parser.add_argument("--warmup", type=int, default=10)
+    parser.add_argument("--threads", type=int, default=4)
+    parser.add_argument("--models", default=",".join(MODELS))
+    parser.add_argument("--output", help="Write the full results as JSON")
+    parser.add_argument("--baselines", default=os.path.join(script_dir, "perf_baselines.json"))
+    parser.add_argument("--update-baselines", action="store_true",
+                        help="Store this run's results as this host's baselines instead of checking them")
+    parser.add_argument("--no-baseline", action="store_true",
+                        help="Compare against this host's baselines if it has any, and do not fail if it has none")
+    parser.add_argument("--report-only", action="store_true",
+                        help="Check agreement only: do not compare against the baselines")
+    parser.add_argument("--worker", action="store_true", help=argparse.SUPPRESS)
+    parser.add_argument("--model", help=argparse.SUPPRESS)
+    parser.add_argument("--provider", choices=PROVIDERS, help=argparse.SUPPRESS)
+    parser.add_argument("--scratch", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+    args.plugin = os.path.abspath(args.plugin)
+    if args.worker:
+        return run_worker(args)
+
+    print(f"ONNX Runtime Version: {ort.__version__}")
+    host = host_description(args.threads)
+    print(f"Host: {host}\n")
+
+    baselines = {"tolerance": {"speedup": 0.15, "cold_start": 0.5, "peak_rss": 0.15}, "hosts": {}}
+    if os.path.exists(args.baselines):
+        with open(args.baselines) as f:
+            baselines = json.load(f)
+    # Timings from another machine or thread count say nothing about this one, so each host
+    # is checked against its own
+    host_baselines = baselines.setdefault("hosts", {}).get(host, {})
+    compare_baselines = not args.update_baselines and not args.report_only
+
+    results = {}
+    failures = []
+    with tempfile.TemporaryDirectory() as scratch:
+        for model in args.models.split(","):
+            cpu = measure(args, model, "cpu", scratch)
+            sample = measure(args, model, "sample", scratch)
+            max_error = check_agreement(model, scratch)
+            result = {
+                "speedup": cpu["p50_us"] / sample["p50_us"],
+                "cold_start_ms": sample["cold_start_ms"],
+                "peak_rss_mb": sample["peak_rss_mb"],
+                "max_abs_error": max_error,
+                "cpu": cpu,
+                "sample": sample,
+            }
+            results[model] = result
+
+            print(f"{model}:")
+            print(f"  p50          {cpu['p50_us']:10.1f} us CPU EP   {sample['p50_us']:10.1f} us Sample EP   "
+                  f"speedup {result['speedup']:.2f}x")
+            print(f"  cold start   {cpu['cold_start_ms']:10.1f} ms CPU EP   {sample['cold_start_ms']:10.1f} ms Sample EP")
+            print(f"  peak RSS     {cpu['peak_rss_mb']:10.1f} MB CPU EP   {sample['peak_rss_mb']:10.1f} MB Sample EP")
+            for entry in sample.get("partitions", []):
+                print(f"  partition    {entry['mean_us']:10.1f} us x {entry['calls']:<4} "
+                      f"{entry['kernel']:<14} {entry['partition']}")
+
+            if max_error is None:
+                failures.append(f"{model}: outputs differ from the CPU EP")
+            else:
+                print(f"  max |error|  {max_error:.3g}")
+            baseline = host_baselines.get(model)
+            if compare_baselines and baseline is not None:
+                failures += [f"{model}: {message}" for message in compare(result, baseline, baselines["tolerance"])]
+            elif compare_baselines and args.no_baseline:
+                print("  no baseline for this host; not compared")
+            elif compare_baselines:
+                failures.append(f"{model}: no baseline for this host; record one with --update-baselines")
+            print()
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump({"host": host, "ort_version": ort.__version__, "models": results}, f, indent=2)
+
+    # Results that disagree with the CPU EP are not worth keeping as a reference
+    if args.update_baselines and not failures:
+        models = baselines["hosts"].setdefault(host, {})
+        for model, result in results.items():
+            models[model] = {key: round(result[key], 3) for key in ("speedup", "cold_start_ms", "peak_rss_mb")}
+        with open(args.baselines, "w") as f:
+            json.dump(baselines, f, indent=2)
+            f.write("\n")
+        print(f"Baselines written to {args.baselines}")
+
+    for failure in failures:
+        print(f"FAIL: {failure}")
+    if failures:
+        return 1
+    print("Performance suite passed")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -8,12 +8,16 @@ Licensed under the MIT License.
 Usage:
     python test_sample_ep.py [path_to_libsample_ep.so]
 """
+import concurrent.futures
+import ctypes
+import math
 import sys
 import os
+import tempfile
 
 import numpy as np
 import onnx
-from onnx import helper, TensorProto
+from onnx import helper, numpy_helper, TensorProto
 import onnxruntime as ort
 
 def build_test_model():
@@ -42,6 +46,226 @@ def build_test_model():
     return model.SerializeToString()
 
 
+def build_broadcast_model():
+    """Build a fused bias-add and scale: Z = (X + B) * S with B: [4], S: [1]."""
+    X = helper.make_tensor_value_info("X", TensorProto.FLOAT, [3, 4])
+    B = helper.make_tensor_value_info("B", TensorProto.FLOAT, [4])
+    S = helper.make_tensor_value_info("S", TensorProto.FLOAT, [1])
+    Z = helper.make_tensor_value_info("Z", TensorProto.FLOAT, [3, 4])
+
+    nodes = [
+        helper.make_node("Add", ["X", "B"], ["T"], name="bias_node"),
+        helper.make_node("Mul", ["T", "S"], ["Z"], name="scale_node"),
+    ]
+
+    graph = helper.make_graph(nodes, "broadcast_graph", [X, B, S], [Z])
+
+    model = helper.make_model(graph, opset_imports=[helper.make_opsetid("", 13)])
+    model.ir_version = 8
+    onnx.checker.check_model(model)
+    return model.SerializeToString()
+
+
+def build_dynamic_model():
+    """Build Z = Relu(X + B) * S with a symbolic batch dim: X: [N, 1000], B: [1000], S: [1]."""
+    X = helper.make_tensor_value_info("X", TensorProto.FLOAT, ["N", 1000])
+    B = helper.make_tensor_value_info("B", TensorProto.FLOAT, [1000])
+    S = helper.make_tensor_value_info("S", TensorProto.FLOAT, [1])
+    Z = helper.make_tensor_value_info("Z", TensorProto.FLOAT, ["N", 1000])
+
+    nodes = [
+        helper.make_node("Add", ["X", "B"], ["T0"], name="bias_node"),
+        helper.make_node("Relu", ["T0"], ["T1"], name="relu_node"),
+        helper.make_node("Mul", ["T1", "S"], ["Z"], name="scale_node"),
+    ]
+
+    graph = helper.make_graph(nodes, "dynamic_graph", [X, B, S], [Z])
+
+    model = helper.make_model(graph, opset_imports=[helper.make_opsetid("", 13)])
+    model.ir_version = 8
+    onnx.checker.check_model(model)
+    return model.SerializeToString()
+
+
+def build_nhwc_model():
+    """Build Z = (X + B) * B on an NHWC activation with a per-channel B: [C]."""
+    X = helper.make_tensor_value_info("X", TensorProto.FLOAT, [2, 3, 3, 8])
+    B = helper.make_tensor_value_info("B", TensorProto.FLOAT, [8])
+    Z = helper.make_tensor_value_info("Z", TensorProto.FLOAT, [2, 3, 3, 8])
+
+    nodes = [
+        helper.make_node("Add", ["X", "B"], ["T"], name="bias_node"),
+        helper.make_node("Mul", ["T", "B"], ["Z"], name="scale_node"),
+    ]
+
+    graph = helper.make_graph(nodes, "nhwc_graph", [X, B], [Z])
+
+    model = helper.make_model(graph, opset_imports=[helper.make_opsetid("", 13)])
+    model.ir_version = 8
+    onnx.checker.check_model(model)
+    return model.SerializeToString()
+
+
+def build_typed_model(elem_type):
+    """Build a fused Z = (X + Y) * Y - X over tensors of the given element type."""
+    X = helper.make_tensor_value_info("X", elem_type, [2, 8])
+    Y = helper.make_tensor_value_info("Y", elem_type, [2, 8])
+    Z = helper.make_tensor_value_info("Z", elem_type, [2, 8])
+
+    nodes = [
+        helper.make_node("Add", ["X", "Y"], ["T0"], name="add_node"),
+        helper.make_node("Mul", ["T0", "Y"], ["T1"], name="mul_node"),
+        helper.make_node("Sub", ["T1", "X"], ["Z"], name="sub_node"),
+    ]
+
+    graph = helper.make_graph(nodes, "typed_graph", [X, Y], [Z])
+
+    model = helper.make_model(graph, opset_imports=[helper.make_opsetid("", 14)])
+    model.ir_version = 8
+    onnx.checker.check_model(model)
+    return model.SerializeToString()
+
+
+def build_activation_model():
+    """Build Z = Clip(Where(X > 0, Gelu(X + B), Sigmoid(Y)), -1, 2) and I = Cast(Max(X, Y), int32)."""
+    X = helper.make_tensor_value_info("X", TensorProto.FLOAT, [2, 8])
+    Y = helper.make_tensor_value_info("Y", TensorProto.FLOAT, [2, 8])
+    B = helper.make_tensor_value_info("B", TensorProto.FLOAT, [8])
+    Z = helper.make_tensor_value_info("Z", TensorProto.FLOAT, [2, 8])
+    I = helper.make_tensor_value_info("I", TensorProto.INT32, [2, 8])
+
+    initializers = [
+        helper.make_tensor("zero", TensorProto.FLOAT, [], [0.0]),
+        helper.make_tensor("lo", TensorProto.FLOAT, [], [-1.0]),
+        helper.make_tensor("hi", TensorProto.FLOAT, [], [2.0]),
+    ]
+    nodes = [
+        helper.make_node("Add", ["X", "B"], ["T0"], name="bias_node"),
+        helper.make_node("Gelu", ["T0"], ["T1"], name="gelu_node"),
+        helper.make_node("Sigmoid", ["Y"], ["T2"], name="sigmoid_node"),
+        helper.make_node("Greater", ["X", "zero"], ["M"], name="greater_node"),
+        helper.make_node("Where", ["M", "T1", "T2"], ["T3"], name="where_node"),
+        helper.make_node("Clip", ["T3", "lo", "hi"], ["Z"], name="clip_node"),
+        helper.make_node("Max", ["X", "Y"], ["T4"], name="max_node"),
+        helper.make_node("Cast", ["T4"], ["I"], name="cast_node", to=TensorProto.INT32),
+    ]
+
+    graph = helper.make_graph(nodes, "activation_graph", [X, Y, B], [Z, I], initializer=initializers)
+
+    model = helper.make_model(graph, opset_imports=[helper.make_opsetid("", 20)])
+    model.ir_version = 9
+    onnx.checker.check_model(model)
+    return model.SerializeToString()
+
+
+def build_row_model():
+    """Build Y = Gelu(LayerNorm(X + R) * G + B), S = Softmax(X), M = ReduceMean(X, 1) + 1,
+    Mx = ReduceMax(X, 1), Sum = ReduceSum(X, [0, 1]) and Sq = ReduceSum(X * X, 1)."""
+    X = helper.make_tensor_value_info("X", TensorProto.FLOAT, [4, 64])
+    R = helper.make_tensor_value_info("R", TensorProto.FLOAT, [4, 64])
+    G = helper.make_tensor_value_info("G", TensorProto.FLOAT, [64])
+    B = helper.make_tensor_value_info("B", TensorProto.FLOAT, [64])
+    outputs = [
+        helper.make_tensor_value_info("Y", TensorProto.FLOAT, [4, 64]),
+        helper.make_tensor_value_info("S", TensorProto.FLOAT, [4, 64]),
+        helper.make_tensor_value_info("M", TensorProto.FLOAT, [4, 1]),
+        helper.make_tensor_value_info("Mx", TensorProto.FLOAT, [4]),
+        helper.make_tensor_value_info("Sum", TensorProto.FLOAT, []),
+        helper.make_tensor_value_info("Sq", TensorProto.FLOAT, [4]),
+    ]
+
+    initializers = [
+        helper.make_tensor("one", TensorProto.FLOAT, [], [1.0]),
+        helper.make_tensor("axis1", TensorProto.INT64, [1], [1]),
+        helper.make_tensor("all_axes", TensorProto.INT64, [2], [0, 1]),
+    ]
+    nodes = [
+        helper.make_node("Add", ["X", "R"], ["T0"], name="residual_node"),
+        helper.make_node("LayerNormalization", ["T0", "G", "B"], ["T1"], name="ln_node", epsilon=1e-5),
+        helper.make_node("Gelu", ["T1"], ["Y"], name="gelu_node"),
+        helper.make_node("Softmax", ["X"], ["S"], name="softmax_node"),
+        helper.make_node("ReduceMean", ["X", "axis1"], ["T2"], name="mean_node"),
+        helper.make_node("Add", ["T2", "one"], ["M"], name="mean_bias_node"),
+        helper.make_node("ReduceMax", ["X", "axis1"], ["Mx"], name="max_node", keepdims=0),
+        helper.make_node("ReduceSum", ["X", "all_axes"], ["Sum"], name="sum_node", keepdims=0),
+        helper.make_node("Mul", ["X", "X"], ["T3"], name="square_node"),
+        helper.make_node("ReduceSum", ["T3", "axis1"], ["Sq"], name="square_sum_node", keepdims=0),
+    ]
+
+    graph = helper.make_graph(nodes, "row_graph", [X, R, G, B], outputs, initializer=initializers)
+
+    model = helper.make_model(graph, opset_imports=[helper.make_opsetid("", 20)])
+    model.ir_version = 9
+    onnx.checker.check_model(model)
+    return model.SerializeToString()
+
+
+def build_matmul_model(w, wt, c):
+    """Build Y = Gelu(X @ W + C) and Z = Gemm(X, Wt, C, transB=1), W and Wt constant."""
+    X = helper.make_tensor_value_info("X", TensorProto.FLOAT, [6, w.shape[0]])
+    outputs = [
+        helper.make_tensor_value_info("Y", TensorProto.FLOAT, [6, w.shape[1]]),
+        helper.make_tensor_value_info("Z", TensorProto.FLOAT, [6, wt.shape[0]]),
+    ]
+
+    initializers = [
+        numpy_helper.from_array(w, "W"),
+        numpy_helper.from_array(wt, "Wt"),
+        numpy_helper.from_array(c, "C"),
+    ]
+    nodes = [
+        helper.make_node("MatMul", ["X", "W"], ["T0"], name="matmul_node"),
+        helper.make_node("Add", ["T0", "C"], ["T1"], name="bias_node"),
+        helper.make_node("Gelu", ["T1"], ["Y"], name="gelu_node"),
+        helper.make_node("Gemm", ["X", "Wt", "C"], ["Z"], name="gemm_node", transB=1),
+    ]
+
+    graph = helper.make_graph(nodes, "matmul_graph", [X], outputs, initializer=initializers)
+
+    model = helper.make_model(graph, opset_imports=[helper.make_opsetid("", 20)])
+    model.ir_version = 9
+    onnx.checker.check_model(model)
+    return model.SerializeToString()
+
+
+def build_constant_model(c, s, u):
+    """Build Y = X * (C * S) + U with constant C: [64], S: [1] and U: [4, 64]."""
+    X = helper.make_tensor_value_info("X", TensorProto.FLOAT, [4, 64])
+    Y = helper.make_tensor_value_info("Y", TensorProto.FLOAT, [4, 64])
+
+    initializers = [
+        numpy_helper.from_array(c, "C"),
+        numpy_helper.from_array(s, "S"),
+        numpy_helper.from_array(u, "U"),
+    ]
+    nodes = [
+        helper.make_node("Mul", ["C", "S"], ["CS"], name="const_scale_node"),
+        helper.make_node("Mul", ["X", "CS"], ["T"], name="scale_node"),
+        helper.make_node("Add", ["T", "U"], ["Y"], name="offset_node"),
+    ]
+
+    graph = helper.make_graph(nodes, "constant_graph", [X], [Y], initializer=initializers)
+
+    model = helper.make_model(graph, opset_imports=[helper.make_opsetid("", 13)])
+    model.ir_version = 8
+    onnx.checker.check_model(model)
+    return model.SerializeToString()
+
+
+def read_counters(plugin_path):
+    """Read the EP's aggregate counters through SampleEpGetCounters, as a metrics agent would."""
+    lib = ctypes.CDLL(plugin_path)
+    get_counters = lib.SampleEpGetCounters
+    get_counters.restype = ctypes.c_size_t
+    get_counters.argtypes = [ctypes.POINTER(ctypes.c_char_p), ctypes.POINTER(ctypes.c_uint64), ctypes.c_size_t]
+
+    count = get_counters(None, None, 0)
+    names = (ctypes.c_char_p * count)()
+    values = (ctypes.c_uint64 * count)()
+    get_counters(names, values, count)
+    return {names[i].decode(): values[i] for i in range(count)}
+
+
 def main():
     print(f"ONNX Runtime Version: {ort.__version__}")
     print(f"ONNX Runtime loaded successfully\n")
@@ -91,7 +315,8 @@ def main():
 
     # Create session with the plugin EP to trigger GetCapability
     session_options = ort.SessionOptions()
-    session_options.add_provider_for_devices(sample_ep_devices, {})
+    # The test tensors are too small for the cost model to claim them, so claim everything
+    session_options.add_provider_for_devices(sample_ep_devices, {"partition_policy": "all"})
 
     print("\nCreating session (EP will report claimed ops):")
     sys.stdout.flush()
@@ -110,9 +335,357 @@ def main():
     print(f"  X       = {x[0]}")
     print(f"  Y       = {y[0]}")
     print(f"  X + Y   = {z_add[0]}  (Add - handled by SampleEP)")
-    print(f"  X - Y   = {z_sub[0]}  (Sub - handled by CPU)")
+    print(f"  X - Y   = {z_sub[0]}  (Sub - handled by SampleEP)")
     print(f"  X * Y   = {z_mul[0]}  (Mul - handled by SampleEP)")
-    print(f"  X / Y   = {z_div[0]}  (Div - handled by CPU)")
+    print(f"  X / Y   = {z_div[0]}  (Div - handled by SampleEP)")
+
+    np.testing.assert_allclose(z_add, x + y, rtol=1e-6)
+    np.testing.assert_allclose(z_sub, x - y, rtol=1e-6)
+    np.testing.assert_allclose(z_mul, x * y, rtol=1e-6)
+    np.testing.assert_allclose(z_div, x / y, rtol=1e-6)
+    print("  Results match NumPy")
+
+    # Concurrent Run calls on one session share its compiled plans
+    print("\nRunning the session from 8 threads at once...")
+    def run_concurrently(seed):
+        rng = np.random.default_rng(seed)
+        xs = rng.standard_normal((1, 4)).astype(np.float32)
+        ys = rng.uniform(1.0, 2.0, (1, 4)).astype(np.float32)
+        for _ in range(50):
+            zs = session.run(None, {"X": xs, "Y": ys})
+            np.testing.assert_allclose(zs[0], xs + ys, rtol=1e-6)
+            np.testing.assert_allclose(zs[3], xs / ys, rtol=1e-6)
+    with concurrent.futures.ThreadPoolExecutor(max_workers=8) as pool:
+        list(pool.map(run_concurrently, range(8)))
+    print("  All results match NumPy")
+
+    # The same traffic with micro-batching: concurrent calls are coalesced and scattered back
+    print("\nRunning a session with batch_window_us=500 from 8 threads at once...")
+    batch_options = ort.SessionOptions()
+    batch_options.add_provider_for_devices(sample_ep_devices, {"partition_policy": "all", "batch_window_us": "500"})
+    session = ort.InferenceSession(model_bytes, sess_options=batch_options)
+    with concurrent.futures.ThreadPoolExecutor(max_workers=8) as pool:
+        list(pool.map(run_concurrently, range(8)))
+    print("  All results match NumPy")
+
+    # Broadcasting inside a fused partition
+    print("\nCreating broadcast session (Add + Mul fused into one partition):")
+    sys.stdout.flush()
+    bcast_session = ort.InferenceSession(build_broadcast_model(), sess_options=session_options)
+    sys.stdout.flush()
+
+    x = np.arange(12, dtype=np.float32).reshape(3, 4)
+    b = np.array([1.0, 2.0, 3.0, 4.0], dtype=np.float32)
+    s = np.array([0.5], dtype=np.float32)
+    (z,) = bcast_session.run(None, {"X": x, "B": b, "S": s})
+    np.testing.assert_allclose(z, (x + b) * s, rtol=1e-6)
+    print(f"  (X + B) * S = {z.tolist()}")
+    del bcast_session
+
+    # A symbolic batch dim: the repeated shape is specialized after two calls, the other stays cold
+    print("\nCreating dynamic-shape session with specialize_after=2:")
+    sys.stdout.flush()
+    hot_options = ort.SessionOptions()
+    hot_options.add_provider_for_devices(sample_ep_devices, {"partition_policy": "all", "specialize_after": "2"})
+    hot_session = ort.InferenceSession(build_dynamic_model(), sess_options=hot_options)
+    sys.stdout.flush()
+
+    bd = np.linspace(-1.0, 1.0, 1000, dtype=np.float32)
+    for batch in (3, 3, 3, 7, 3, 3):
+        xd = np.linspace(-2.0, 2.0, batch * 1000, dtype=np.float32).reshape(batch, 1000)
+        (z,) = hot_session.run(None, {"X": xd, "B": bd, "S": s})
+        np.testing.assert_allclose(z, np.maximum(xd + bd, 0) * s, rtol=1e-6)
+    print("  Relu(X + B) * S matches NumPy for hot and cold batch sizes")
+    del hot_session
+
+    # Channel-last layout: the channel bias becomes a row broadcast
+    print("\nCreating NHWC session (preferred_layout=NHWC):")
+    sys.stdout.flush()
+    nhwc_options = ort.SessionOptions()
+    nhwc_options.add_provider_for_devices(sample_ep_devices,
+                                          {"preferred_layout": "NHWC", "partition_policy": "all"})
+    nhwc_session = ort.InferenceSession(build_nhwc_model(), sess_options=nhwc_options)
+    sys.stdout.flush()
+
+    xn = np.arange(2 * 3 * 3 * 8, dtype=np.float32).reshape(2, 3, 3, 8)
+    bn = np.linspace(-1.0, 1.0, 8, dtype=np.float32)
+    (z,) = nhwc_session.run(None, {"X": xn, "B": bn})
+    np.testing.assert_allclose(z, (xn + bn) * bn, rtol=1e-6)
+    print("  (X + B) * B over [N, H, W, C] matches NumPy")
+    del nhwc_session
+
+    # Compile to an EPContext model, then run it without partitioning or compiling again
+    print("\nCompiling broadcast model to an EPContext model:")
+    sys.stdout.flush()
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        ctx_path = os.path.join(tmp_dir, "broadcast_ctx.onnx")
+        compiler = ort.ModelCompiler(session_options, build_broadcast_model(),
+                                     embed_compiled_data_into_model=True)
+        compiler.compile_to_file(ctx_path)
+
+        ctx_ops = [node.op_type for node in onnx.load(ctx_path).graph.node]
+        assert ctx_ops == ["EPContext"], ctx_ops
+
+        ctx_session = ort.InferenceSession(ctx_path, sess_options=session_options)
+        (z,) = ctx_session.run(None, {"X": x, "B": b, "S": s})
+        np.testing.assert_allclose(z, (x + b) * s, rtol=1e-6)
+        print("  EPContext model matches NumPy")
+        del ctx_session
+
+    # The on-disk program cache: a session writes it, the next one loads every partition from
+    # it, and a damaged file is treated as empty and rewritten
+    print("\nCompiling broadcast model through the program cache:")
+    sys.stdout.flush()
+    with tempfile.TemporaryDirectory() as cache_dir:
+        cache_path = os.path.join(cache_dir, "sample_ep_programs.bin")
+        cache_options = ort.SessionOptions()
+        cache_options.add_provider_for_devices(sample_ep_devices, {
+            "partition_policy": "all", "program_cache_dir": cache_dir})
+
+        def run_cached():
+            cache_session = ort.InferenceSession(build_broadcast_model(), sess_options=cache_options)
+            (z,) = cache_session.run(None, {"X": x, "B": b, "S": s})
+            np.testing.assert_allclose(z, (x + b) * s, rtol=1e-6)
+            del cache_session
+            return os.stat(cache_path)
+
+        written = run_cached()
+        assert written.st_size > 0, written
+
+        # Misses are written back by replacing the file, so one that is left alone was all hits
+        reopened = run_cached()
+        assert (reopened.st_ino, reopened.st_mtime_ns) == (written.st_ino, written.st_mtime_ns), reopened
+        print("  Second session loads its program from the cache and matches NumPy")
+
+        # Replace rather than truncate in place, so no live mapping of the file is cut short
+        with open(cache_path, "rb") as f:
+            data = f.read()
+        with open(cache_path + ".cut", "wb") as f:
+            f.write(data[:len(data) // 2])
+        os.replace(cache_path + ".cut", cache_path)
+        recompiled = run_cached()
+        assert recompiled.st_size == written.st_size, recompiled
+        print("  Truncated cache is recompiled, matches NumPy and is written back whole")
+
+    # Activations, comparisons, Where, Clip and Cast fused into one partition
+    print("\nCreating activation session (Gelu(X + B) runs as one fused kernel):")
+    sys.stdout.flush()
+    act_session = ort.InferenceSession(build_activation_model(), sess_options=session_options)
+    sys.stdout.flush()
+
+    xa = np.linspace(-4.0, 4.0, 16, dtype=np.float32).reshape(2, 8)
+    ya = np.linspace(3.0, -3.0, 16, dtype=np.float32).reshape(2, 8)
+    ba = np.linspace(-0.5, 0.5, 8, dtype=np.float32)
+    z, i = act_session.run(None, {"X": xa, "Y": ya, "B": ba})
+    t = (xa + ba).astype(np.float64)
+    gelu = 0.5 * t * (1.0 + np.vectorize(math.erf)(t / math.sqrt(2.0)))
+    sigmoid = 1.0 / (1.0 + np.exp(-ya.astype(np.float64)))
+    np.testing.assert_allclose(z, np.clip(np.where(xa > 0, gelu, sigmoid), -1.0, 2.0), rtol=1e-5, atol=1e-6)
+    np.testing.assert_array_equal(i, np.maximum(xa, ya).astype(np.int32))
+    print("  Clip(Where(X > 0, Gelu(X + B), Sigmoid(Y))) and Cast(Max(X, Y)) match NumPy")
+    del act_session
+
+    # Reductions and normalizations, fused with the elementwise ops around them
+    print("\nCreating row-op session (LayerNorm, Softmax, ReduceMean/Max/Sum):")
+    sys.stdout.flush()
+    row_session = ort.InferenceSession(build_row_model(), sess_options=session_options)
+    sys.stdout.flush()
+
+    rng = np.random.default_rng(0)
+    xr = rng.standard_normal((4, 64)).astype(np.float32)
+    rr = rng.standard_normal((4, 64)).astype(np.float32)
+    gr = rng.uniform(0.5, 1.5, 64).astype(np.float32)
+    br = rng.uniform(-0.5, 0.5, 64).astype(np.float32)
+    before = read_counters(plugin_path)
+    y, s_out, m, mx, total, sq = row_session.run(None, {"X": xr, "R": rr, "G": gr, "B": br})
+    after = read_counters(plugin_path)
+    t = (xr + rr).astype(np.float64)
+    t = (t - t.mean(axis=1, keepdims=True)) / np.sqrt(t.var(axis=1, keepdims=True) + 1e-5) * gr + br
+    np.testing.assert_allclose(y, 0.5 * t * (1.0 + np.vectorize(math.erf)(t / math.sqrt(2.0))),
+                               rtol=1e-4, atol=1e-5)
+    e = np.exp(xr.astype(np.float64) - xr.max(axis=1, keepdims=True))
+    np.testing.assert_allclose(s_out, e / e.sum(axis=1, keepdims=True), rtol=1e-5, atol=1e-7)
+    np.testing.assert_allclose(m, xr.mean(axis=1, keepdims=True) + 1, rtol=1e-5)
+    np.testing.assert_array_equal(mx, xr.max(axis=1))
+    np.testing.assert_allclose(total, xr.astype(np.float64).sum(), rtol=1e-5, atol=1e-5)
+    np.testing.assert_allclose(sq, (xr.astype(np.float64) ** 2).sum(axis=1), rtol=1e-5)
+    print("  Gelu(LayerNorm(X + R)), Softmax and the reductions match NumPy")
+
+    # Row ops count the elements of their operand, not of their result
+    for name, expected in (("reduce_mean", xr.size), ("reduce_max", xr.size), ("reduce_sum", 2 * xr.size),
+                           ("softmax", xr.size), ("layer_norm", xr.size)):
+        delta = after[f"op_elements.{name}"] - before[f"op_elements.{name}"]
+        assert delta == expected, (name, delta, expected)
+    print("  op_elements of each row op is its operand's size")
+    del row_session
+
+    # One partition per row op: the residual Add and the Mul squaring X are their row ops'
+    # prologues, the bias Add after ReduceMean its epilogue
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        ctx_path = os.path.join(tmp_dir, "row_ctx.onnx")
+        compiler = ort.ModelCompiler(session_options, build_row_model(), embed_compiled_data_into_model=True)
+        compiler.compile_to_file(ctx_path)
+        ctx_ops = [node.op_type for node in onnx.load(ctx_path).graph.node]
+        assert ctx_ops == ["EPContext"] * 6, ctx_ops
+    print("  Each row op is one partition with the elementwise code around it")
+
+    # MatMul by constant weights, with the bias and activation fused after it
+    print("\nCreating MatMul session (MatMul + bias + Gelu, Gemm transB):")
+    sys.stdout.flush()
+    wm = rng.standard_normal((40, 35)).astype(np.float32)
+    cm = rng.standard_normal(35).astype(np.float32)
+    matmul_session = ort.InferenceSession(build_matmul_model(wm, np.ascontiguousarray(wm.T), cm),
+                                          sess_options=session_options)
+    sys.stdout.flush()
+
+    xm = rng.standard_normal((6, 40)).astype(np.float32)
+    before = read_counters(plugin_path)
+    y, z = matmul_session.run(None, {"X": xm})
+    after = read_counters(plugin_path)
+    t = xm.astype(np.float64) @ wm + cm
+    np.testing.assert_allclose(y, 0.5 * t * (1.0 + np.vectorize(math.erf)(t / math.sqrt(2.0))),
+                               rtol=1e-4, atol=1e-4)
+    np.testing.assert_allclose(z, t, rtol=1e-4, atol=1e-4)
+    print("  Gelu(X @ W + C) and Gemm(X, W', C, transB=1) match NumPy")
+    # One multiply-add per element of M x K x N, for each of the two
+    delta = after["op_elements.matmul"] - before["op_elements.matmul"]
+    assert delta == 2 * xm.size * wm.shape[1], delta
+    del matmul_session
+
+    # Constant initializers folded at compile time; ORT's own folding is disabled so the EP
+    # sees C * S, and the uniform U is collapsed to a scalar
+    cc = rng.standard_normal(64).astype(np.float32)
+    sc = np.array([0.5], dtype=np.float32)
+    uc = np.full((4, 64), 1.25, dtype=np.float32)
+    xc = rng.standard_normal((4, 64)).astype(np.float32)
+    for fold in ("1", "0"):
+        print(f"\nCreating constant-input session with fold_constants={fold}:")
+        sys.stdout.flush()
+        fold_options = ort.SessionOptions()
+        fold_options.graph_optimization_level = ort.GraphOptimizationLevel.ORT_DISABLE_ALL
+        fold_options.add_provider_for_devices(sample_ep_devices, {
+            "partition_policy": "all", "fold_constants": fold})
+        fold_session = ort.InferenceSession(build_constant_model(cc, sc, uc), sess_options=fold_options)
+        sys.stdout.flush()
+
+        (yc,) = fold_session.run(None, {"X": xc})
+        np.testing.assert_allclose(yc, xc * (cc * sc) + uc, rtol=1e-6)
+        print("  X * (C * S) + U matches NumPy")
+        del fold_session
+
+    # With the default cost-based policy, a tiny model is left to the CPU EP
+    print("\nCompiling broadcast model with partition_policy=cost:")
+    sys.stdout.flush()
+    cost_options = ort.SessionOptions()
+    cost_options.add_provider_for_devices(sample_ep_devices, {"partition_log": "1"})
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        ctx_path = os.path.join(tmp_dir, "broadcast_cost.onnx")
+        compiler = ort.ModelCompiler(cost_options, build_broadcast_model(),
+                                     embed_compiled_data_into_model=True)
+        compiler.compile_to_file(ctx_path)
+        ctx_ops = [node.op_type for node in onnx.load(ctx_path).graph.node]
+        assert "EPContext" not in ctx_ops, ctx_ops
+        print(f"  Left to ORT: {ctx_ops}")
+
+    # Non-float element types
+    typed_cases = [
+        (TensorProto.FLOAT16, np.float16),
+        (TensorProto.DOUBLE, np.float64),
+        (TensorProto.INT8, np.int8),
+        (TensorProto.INT32, np.int32),
+        (TensorProto.INT64, np.int64),
+    ]
+    for elem_type, np_type in typed_cases:
+        print(f"\nCreating {np.dtype(np_type).name} session:")
+        sys.stdout.flush()
+        typed_session = ort.InferenceSession(build_typed_model(elem_type), sess_options=session_options)
+        sys.stdout.flush()
+
+        x = np.arange(-8, 8, dtype=np_type).reshape(2, 8)
+        y = np.arange(16, dtype=np_type).reshape(2, 8) % 5
+        (z,) = typed_session.run(None, {"X": x, "Y": y})
+        expected = ((x.astype(np.float64) + y) * y - x).astype(np_type)
+        np.testing.assert_array_equal(z, expected)
+        print("  (X + Y) * Y - X matches NumPy")
+        del typed_session
+
+    # Creation-time options, then the dynamic subset changed on the live session
+    print("\nCreating session with isa=scalar, max_partition_nodes=1, allocator=system:")
+    sys.stdout.flush()
+    tuned_options = ort.SessionOptions()
+    tuned_options.add_provider_for_devices(sample_ep_devices, {
+        "partition_policy": "all", "isa": "scalar", "max_partition_nodes": "1",
+        "allocator": "system", "thread_priority": "low"})
+    tuned_session = ort.InferenceSession(build_broadcast_model(), sess_options=tuned_options)
+    sys.stdout.flush()
+
+    x = np.arange(12, dtype=np.float32).reshape(3, 4)
+    (z,) = tuned_session.run(None, {"X": x, "B": b, "S": s})
+    np.testing.assert_allclose(z, (x + b) * s, rtol=1e-6)
+
+    tuned_session.set_ep_dynamic_options({"num_threads": "2", "ep.dynamic.workload_type": "Default"})
+    (z,) = tuned_session.run(None, {"X": x, "B": b, "S": s})
+    np.testing.assert_allclose(z, (x + b) * s, rtol=1e-6)
+    try:
+        tuned_session.set_ep_dynamic_options({"isa": "avx2"})
+        rejected = False
+    except Exception:
+        rejected = True
+    assert rejected, "isa must be fixed at session creation"
+    print("  Dynamic options applied; creation-time options rejected")
+    del tuned_session
+
+    # NUMA layout published on the device, and a session pinned to its first node
+    metadata = sample_ep_devices[0].ep_metadata
+    node = metadata["numa_nodes"].split(",")[0]
+    print(f"\nCreating session on NUMA node {node} (CPUs {metadata[f'numa_node.{node}.cpus']}):")
+    sys.stdout.flush()
+    numa_options = ort.SessionOptions()
+    numa_options.add_provider_for_devices(sample_ep_devices, {"partition_policy": "all", "numa_node": node})
+    numa_session = ort.InferenceSession(build_broadcast_model(), sess_options=numa_options)
+    (z,) = numa_session.run(None, {"X": x, "B": b, "S": s})
+    np.testing.assert_allclose(z, (x + b) * s, rtol=1e-6)
+    print("  NUMA-pinned session matches NumPy")
+    del numa_session
+
+    # One partition per node, so intermediates stay in EP memory and calls are queued on
+    # ORT's stream; the inline mode must agree
+    for stream_execution in ("1", "0"):
+        stream_options = ort.SessionOptions()
+        stream_options.add_provider_for_devices(sample_ep_devices, {
+            "partition_policy": "all", "max_partition_nodes": "1", "stream_execution": stream_execution})
+        stream_session = ort.InferenceSession(build_broadcast_model(), sess_options=stream_options)
+        for _ in range(3):
+            (z,) = stream_session.run(None, {"X": x, "B": b, "S": s})
+            np.testing.assert_allclose(z, (x + b) * s, rtol=1e-6)
+
+        # Chain runs through an IOBinding: each Z is copied to the host out of the EP's memory,
+        # which the queued partition has just written, and copied back in as the next run's X
+        binding = stream_session.io_binding()
+        binding.bind_cpu_input("X", x)
+        binding.bind_cpu_input("B", b)
+        binding.bind_cpu_input("S", s)
+        expected = x
+        for _ in range(3):
+            binding.bind_output("Z")
+            stream_session.run_with_iobinding(binding)
+            (z_value,) = binding.get_outputs()
+            expected = (expected + b) * s
+            binding.bind_ortvalue_input("X", z_value)
+        np.testing.assert_allclose(z_value.numpy(), expected, rtol=1e-6)
+        del binding, stream_session
+    print("  Stream-queued and inline execution match NumPy, also with each output fed back in")
+
+    # Aggregate counters, summed over every thread that has run the EP's code
+    counters = read_counters(plugin_path)
+    print("\nCounters:")
+    for name in ("compute_calls", "plan_cache_hits", "plan_cache_misses", "hot_path_calls", "batched_calls",
+                 "row_op_calls", "op_elements.add", "pool_bytes_in_use", "stream_queue_depth"):
+        print(f"  {name} = {counters[name]}")
+    assert counters["compute_calls"] > 0 and counters["plan_cache_hits"] > 0, counters
+    assert counters["op_elements.add"] > 0 and counters["hot_path_calls"] > 0, counters
+    assert counters["plan_cache_hits"] + counters["plan_cache_misses"] == counters["compute_calls"], counters
+    assert counters["stream_queue_depth"] == 0, counters
 
     # =========================================================================
     # Cleanup